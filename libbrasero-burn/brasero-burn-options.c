@@ -86,6 +86,12 @@ struct _BraseroBurnOptionsPrivate
 	guint not_ready_id;
 	GtkWidget *status_dialog;
 
+	/* Number of media needed to span the session for the last data size
+	 * and medium space it was computed for */
+	goffset span_blocks;
+	goffset span_space;
+	guint span_disc_num;
+
 	GCancellable *cancel;
 
 	guint is_valid:1;
@@ -428,12 +434,32 @@ brasero_burn_options_update_valid (BraseroBurnOptions *self)
 		if (available_space > min_disc_size
 		&&  brasero_session_span_possible (BRASERO_SESSION_SPAN (priv->session)) == BRASERO_BURN_RETRY) {
 			GtkWidget *message;
+			gchar *secondary;
+			goffset blocks = 0;
+
+			/* Tell the user how many media of this size are needed.
+			 * Finding it means trying to fill each medium so it is
+			 * only done again when one of the sizes changed. */
+			brasero_burn_session_get_size (BRASERO_BURN_SESSION (priv->session), &blocks, NULL);
+			if (blocks != priv->span_blocks || available_space != priv->span_space) {
+				priv->span_blocks = blocks;
+				priv->span_space = available_space;
+				priv->span_disc_num = brasero_session_span_get_disc_num (BRASERO_SESSION_SPAN (priv->session), NULL);
+			}
+
+			/* Only reached with several media so no plural form */
+			if (priv->span_disc_num > 1)
+				secondary = g_strdup_printf (_("The data size is too large for the disc even with the overburn option. It can be burnt across %u media of this size."),
+							     priv->span_disc_num);
+			else
+				secondary = g_strdup (_("The data size is too large for the disc even with the overburn option."));
 
 			message = brasero_notify_message_add (priv->message_output,
 							      _("Would you like to burn the selection of files across several media?"),
-							      _("The data size is too large for the disc even with the overburn option."),
+							      secondary,
 							      -1,
 							      BRASERO_NOTIFY_CONTEXT_SIZE);
+			g_free (secondary);
 
 			gtk_widget_set_tooltip_text (gtk_info_bar_add_button (GTK_INFO_BAR (message),
 									      _("_Burn Several Discs"),
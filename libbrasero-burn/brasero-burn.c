@@ -284,11 +284,61 @@ brasero_burn_sleep (BraseroBurn *burn, gint msec)
 	return BRASERO_BURN_CANCEL;
 }
 
+static void
+brasero_burn_drive_changed (BraseroDrive *drive,
+			    BraseroMedium *medium,
+			    BraseroBurn *burn)
+{
+	BraseroBurnPrivate *priv = BRASERO_BURN_PRIVATE (burn);
+
+	/* Don't touch timeout_id: brasero_burn_sleep () removes it */
+	if (priv->sleep_loop)
+		g_main_loop_quit (priv->sleep_loop);
+}
+
+/**
+ * Waits for a probe to finish. The drive signals when a medium is added or
+ * removed so sleep until then; the timeout (which grows) is there for the
+ * probes which end with no signal.
+ */
+
+static BraseroBurnResult
+brasero_burn_wait_probe (BraseroBurn *burn,
+			 BraseroDrive *drive)
+{
+	BraseroBurnResult result = BRASERO_BURN_OK;
+	gulong added_id, removed_id;
+	gint wait = 25;
+
+	if (!brasero_drive_probing (drive))
+		return BRASERO_BURN_OK;
+
+	added_id = g_signal_connect (drive,
+				     "medium-added",
+				     G_CALLBACK (brasero_burn_drive_changed),
+				     burn);
+	removed_id = g_signal_connect (drive,
+				       "medium-removed",
+				       G_CALLBACK (brasero_burn_drive_changed),
+				       burn);
+
+	while (brasero_drive_probing (drive)) {
+		result = brasero_burn_sleep (burn, wait);
+		if (result != BRASERO_BURN_OK)
+			break;
+
+		wait = MIN (wait * 2, 500);
+	}
+
+	g_signal_handler_disconnect (drive, added_id);
+	g_signal_handler_disconnect (drive, removed_id);
+	return result;
+}
+
 static BraseroBurnResult
 brasero_burn_reprobe (BraseroBurn *burn)
 {
 	BraseroBurnPrivate *priv;
-	BraseroBurnResult result = BRASERO_BURN_OK;
 
 	priv = BRASERO_BURN_PRIVATE (burn);
 
@@ -296,13 +346,7 @@ brasero_burn_reprobe (BraseroBurn *burn)
 
 	/* reprobe the medium and wait for it to be probed */
 	brasero_drive_reprobe (priv->dest);
-	while (brasero_drive_probing (priv->dest)) {
-		result = brasero_burn_sleep (burn, 250);
-		if (result != BRASERO_BURN_OK)
-			return result;
-	}
-
-	return result;
+	return brasero_burn_wait_probe (burn, priv->dest);
 }
 
 static BraseroBurnResult
@@ -590,11 +634,9 @@ brasero_burn_lock_src_media (BraseroBurn *burn,
 
 again:
 
-	while (brasero_drive_probing (priv->src)) {
-		result = brasero_burn_sleep (burn, 500);
-		if (result != BRASERO_BURN_OK)
-			return result;
-	}
+	result = brasero_burn_wait_probe (burn, priv->src);
+	if (result != BRASERO_BURN_OK)
+		return result;
 
 	medium = brasero_drive_get_medium (priv->src);
 	if (brasero_volume_is_mounted (BRASERO_VOLUME (medium))) {
@@ -681,11 +723,9 @@ brasero_burn_lock_rewritable_media (BraseroBurn *burn,
 
  again:
 
-	while (brasero_drive_probing (priv->dest)) {
-		result = brasero_burn_sleep (burn, 500);
-		if (result != BRASERO_BURN_OK)
-			return result;
-	}
+	result = brasero_burn_wait_probe (burn, priv->dest);
+	if (result != BRASERO_BURN_OK)
+		return result;
 
 	medium = brasero_drive_get_medium (priv->dest);
 	if (!brasero_medium_can_be_rewritten (medium)) {
@@ -773,11 +813,9 @@ brasero_burn_lock_dest_media (BraseroBurn *burn,
 
 	/* NOTE: don't lock the drive here yet as
 	 * otherwise we'd be probing forever. */
-	while (brasero_drive_probing (priv->dest)) {
-		result = brasero_burn_sleep (burn, 500);
-		if (result != BRASERO_BURN_OK)
-			return result;
-	}
+	result = brasero_burn_wait_probe (burn, priv->dest);
+	if (result != BRASERO_BURN_OK)
+		return result;
 
 	medium = brasero_drive_get_medium (priv->dest);
 	if (!medium) {
@@ -939,11 +977,9 @@ brasero_burn_lock_checksum_media (BraseroBurn *burn,
 
 again:
 
-	while (brasero_drive_probing (priv->dest)) {
-		result = brasero_burn_sleep (burn, 500);
-		if (result != BRASERO_BURN_OK)
-			return result;
-	}
+	result = brasero_burn_wait_probe (burn, priv->dest);
+	if (result != BRASERO_BURN_OK)
+		return result;
 
 	medium = brasero_drive_get_medium (priv->dest);
 	media = brasero_medium_get_status (medium);
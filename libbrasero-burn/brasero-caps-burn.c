@@ -162,6 +162,55 @@ brasero_caps_link_list_sort (gconstpointer a,
 	       brasero_plugin_get_priority (node1->plugin);
 }
 
+/**
+ * Costs used to compare paths leading to the same output. Plugins piping their
+ * data to one another cost nothing; what we want to avoid is an intermediate
+ * image written to disk (time and space) and decoding streams (CPU).
+ * Costs only apply when the session allows piping (on the fly burning). When
+ * it asks for images every path costs nothing and plugins are chosen on their
+ * priority alone.
+ */
+#define BRASERO_CAPS_COST_TMP_FILE	4
+#define BRASERO_CAPS_COST_TRANSCODE	1
+
+static guint
+brasero_caps_link_cost (BraseroCapsLinkList *node,
+                        gboolean is_input,
+                        BraseroPluginIOFlag io_flags)
+{
+	guint cost = 0;
+
+	/* The user wants intermediate images anyway */
+	if (!(io_flags & BRASERO_PLUGIN_IO_ACCEPT_PIPE))
+		return 0;
+
+	/* Unless the caps are the input of the session, the data are produced
+	 * by another plugin; see brasero_burn_caps_new_task () for when a new
+	 * task (and therefore an image file) is needed for that */
+	if (!is_input
+	&&  !(node->link->caps->flags & BRASERO_PLUGIN_IO_ACCEPT_PIPE))
+		cost += BRASERO_CAPS_COST_TMP_FILE;
+
+	if (brasero_track_type_get_has_stream (&node->link->caps->type))
+		cost += BRASERO_CAPS_COST_TRANSCODE;
+
+	return cost;
+}
+
+static guint
+brasero_caps_link_list_cost (GSList *path,
+                             BraseroPluginIOFlag io_flags)
+{
+	GSList *iter;
+	guint cost = 0;
+
+	/* The last link of the path is the one taking the input */
+	for (iter = path; iter; iter = iter->next)
+		cost += brasero_caps_link_cost (iter->data, (iter->next == NULL), io_flags);
+
+	return cost;
+}
+
 static GSList *
 brasero_caps_get_best_path (GSList *path1,
                             GSList *path2)
@@ -297,6 +346,7 @@ brasero_caps_find_best_link (BraseroCaps *caps,
 			     BraseroPluginIOFlag io_flags)
 {
 	GSList *iter;
+	guint cost = 0;
 	GSList *list = NULL;
 	GSList *results = NULL;
 	gboolean perfect_fit = FALSE;
@@ -451,17 +501,32 @@ brasero_caps_find_best_link (BraseroCaps *caps,
 		goto end;
 
 	node = iter->data;
+	if (perfect_fit)
+		cost = brasero_caps_link_cost (node, TRUE, io_flags);
+	else
+		cost = brasero_caps_link_cost (node, FALSE, io_flags) +
+		       brasero_caps_link_list_cost (results, io_flags);
 
 	/* Stage 3: there may be other link with the same priority (most the
 	 * time because it is the same plugin) so we try them as well and keep
-	 * the one whose next plugin in the list has the highest priority. */
+	 * the one whose next plugin in the list has the highest priority.
+	 * Links with a lower priority are tried too as long as the path found
+	 * so far has a cost (like an intermediate image file) that they could
+	 * avoid. They are only kept if they are cheaper. Costs are only charged
+	 * when the session allows piping; otherwise (the user didn't choose on
+	 * the fly burning) cost is 0 and only priorities matter. */
 	for (iter = iter->next; iter; iter = iter->next) {
 		GSList *other_results;
 		BraseroCapsLinkList *iter_node;
+		gboolean same_priority;
+		guint other_cost;
 
 		iter_node = iter->data;
-		if (brasero_plugin_get_priority (iter_node->plugin) !=
-		    brasero_plugin_get_priority (node->plugin))
+		same_priority = (brasero_plugin_get_priority (iter_node->plugin) ==
+				 brasero_plugin_get_priority (node->plugin));
+
+		if (!same_priority
+		&& (perfect_fit || have_processing_plugin || !cost))
 			break;
 
 		BRASERO_BURN_LOG ("Trying %s with a priority of %i",
@@ -469,47 +534,74 @@ brasero_caps_find_best_link (BraseroCaps *caps,
 			          brasero_plugin_get_priority (iter_node->plugin));
 
 		/* see if that's a perfect fit */
-		if ((iter_node->link->caps->flags & BRASERO_PLUGIN_IO_ACCEPT_FILE) == 0
-		||  !brasero_caps_is_compatible_type (iter_node->link->caps, input)) {
-			other_results = brasero_caps_get_plugin_results (iter_node,
-				                                         group_id,
-				                                         used_caps,
-				                                         session_flags,
-				                                         media,
-				                                         input,
-				                                         io_flags);
-			if (!other_results)
+		if ((iter_node->link->caps->flags & BRASERO_PLUGIN_IO_ACCEPT_FILE)
+		&&   brasero_caps_is_compatible_type (iter_node->link->caps, input)) {
+			if (perfect_fit || have_processing_plugin)
 				continue;
 
-			if (perfect_fit) {
-				have_processing_plugin = brasero_caps_link_list_have_processing_plugin (other_results);
-				if (have_processing_plugin) {
-					/* Note: results == NULL for perfect fit */
-					results = other_results;
+			other_cost = brasero_caps_link_cost (iter_node, TRUE, io_flags);
+			if (!same_priority && other_cost >= cost)
+				continue;
 
-					perfect_fit = FALSE;
-					node = iter_node;
-				}
-				else {
-					g_slist_foreach (other_results, (GFunc) g_free, NULL);
-					g_slist_free (other_results);
-				}
+			g_slist_foreach (results, (GFunc) g_free, NULL);
+			g_slist_free (results);
+			results = NULL;
+
+			perfect_fit = TRUE;
+			node = iter_node;
+			cost = other_cost;
+			continue;
+		}
+
+		other_results = brasero_caps_get_plugin_results (iter_node,
+			                                         group_id,
+			                                         used_caps,
+			                                         session_flags,
+			                                         media,
+			                                         input,
+			                                         io_flags);
+		if (!other_results)
+			continue;
+
+		other_cost = brasero_caps_link_cost (iter_node, FALSE, io_flags) +
+			     brasero_caps_link_list_cost (other_results, io_flags);
+
+		if (perfect_fit) {
+			have_processing_plugin = brasero_caps_link_list_have_processing_plugin (other_results);
+			if (have_processing_plugin) {
+				/* Note: results == NULL for perfect fit */
+				results = other_results;
+
+				perfect_fit = FALSE;
+				node = iter_node;
+				cost = other_cost;
 			}
 			else {
-				results = brasero_caps_get_best_path (results, other_results);
-				if (results == other_results) {
-					have_processing_plugin = brasero_caps_link_list_have_processing_plugin (other_results);
-					node = iter_node;
-				}
+				g_slist_foreach (other_results, (GFunc) g_free, NULL);
+				g_slist_free (other_results);
 			}
 		}
-		else if (!perfect_fit && !have_processing_plugin) {
+		else if (other_cost < cost) {
+			BRASERO_BURN_LOG ("Cheaper path found (%u < %u)", other_cost, cost);
+
 			g_slist_foreach (results, (GFunc) g_free, NULL);
 			g_slist_free (results);
-			results = NULL;
+			results = other_results;
 
-			perfect_fit = TRUE;
+			have_processing_plugin = brasero_caps_link_list_have_processing_plugin (other_results);
 			node = iter_node;
+			cost = other_cost;
+		}
+		else if (same_priority && other_cost == cost) {
+			results = brasero_caps_get_best_path (results, other_results);
+			if (results == other_results) {
+				have_processing_plugin = brasero_caps_link_list_have_processing_plugin (other_results);
+				node = iter_node;
+			}
+		}
+		else {
+			g_slist_foreach (other_results, (GFunc) g_free, NULL);
+			g_slist_free (other_results);
 		}
 	}
 
@@ -560,7 +560,11 @@ brasero_caps_find_link_set_ctx (BraseroBurnSession *session,
 
 static BraseroBurnResult
 brasero_caps_find_link (BraseroCaps *caps,
-                        BraseroFindLinkCtx *ctx)
+                        BraseroFindLinkCtx *ctx);
+
+static BraseroBurnResult
+brasero_caps_find_link_real (BraseroCaps *caps,
+                             BraseroFindLinkCtx *ctx)
 {
 	GSList *iter;
 
@@ -657,6 +661,121 @@ brasero_caps_find_link (BraseroCaps *caps,
 	return BRASERO_BURN_NOT_SUPPORTED;
 }
 
+/* Above that number of entries the cache is simply emptied */
+#define BRASERO_CAPS_LINK_CACHE_MAX	4096
+
+struct _BraseroCapsLinkKey {
+	BraseroCaps *caps;
+	BraseroTrackType input;
+	BraseroMedia media;
+	BraseroBurnFlag session_flags;
+	BraseroPluginIOFlag io_flags;
+
+	guint ignore_plugin_errors:1;
+	guint check_session_flags:1;
+};
+typedef struct _BraseroCapsLinkKey BraseroCapsLinkKey;
+
+static guint
+brasero_caps_link_key_hash (gconstpointer data)
+{
+	const BraseroCapsLinkKey *key = data;
+	guint hash;
+
+	hash = GPOINTER_TO_UINT (key->caps);
+	hash = hash * 31 + key->input.type;
+	hash = hash * 31 + key->input.subtype.media;
+	hash = hash * 31 + key->media;
+	hash = hash * 31 + key->session_flags;
+	hash = hash * 31 + key->io_flags;
+	hash = hash * 31 + (key->ignore_plugin_errors << 1 | key->check_session_flags);
+	return hash;
+}
+
+static gboolean
+brasero_caps_link_key_equal (gconstpointer a,
+                             gconstpointer b)
+{
+	const BraseroCapsLinkKey *key_a = a;
+	const BraseroCapsLinkKey *key_b = b;
+
+	return key_a->caps == key_b->caps
+	    && key_a->input.type == key_b->input.type
+	    && key_a->input.subtype.media == key_b->input.subtype.media
+	    && key_a->media == key_b->media
+	    && key_a->session_flags == key_b->session_flags
+	    && key_a->io_flags == key_b->io_flags
+	    && key_a->ignore_plugin_errors == key_b->ignore_plugin_errors
+	    && key_a->check_session_flags == key_b->check_session_flags;
+}
+
+GHashTable *
+brasero_caps_link_cache_new (void)
+{
+	return g_hash_table_new_full (brasero_caps_link_key_hash,
+	                              brasero_caps_link_key_equal,
+	                              g_free,
+	                              NULL);
+}
+
+/**
+ * The result of a search only depends on the caps graph, on the state of the
+ * plugins and on the parameters in ctx. So results are memoised (sub-paths
+ * included since the search recurses through here) until a plugin changes.
+ * When a callback is set, plugin errors are reported along the way and the
+ * search must always be run.
+ */
+
+static BraseroBurnResult
+brasero_caps_find_link (BraseroCaps *caps,
+                        BraseroFindLinkCtx *ctx)
+{
+	BraseroCapsLinkKey key = { NULL, };
+	BraseroBurnResult result;
+	BraseroBurnCaps *self;
+	gpointer value;
+	guint generation;
+
+	if (ctx->callback)
+		return brasero_caps_find_link_real (caps, ctx);
+
+	self = brasero_burn_caps_get_default ();
+
+	/* The caps graph is only modified while plugins register which is
+	 * followed by a check of the plugin state; so this catches it too */
+	generation = brasero_plugin_get_generation ();
+	if (self->priv->links_generation != generation) {
+		g_hash_table_remove_all (self->priv->links_cache);
+		self->priv->links_generation = generation;
+	}
+
+	key.caps = caps;
+	key.input = *ctx->input;
+	key.media = ctx->media;
+	key.io_flags = ctx->io_flags;
+	key.ignore_plugin_errors = (ctx->ignore_plugin_errors != FALSE);
+	key.check_session_flags = (ctx->check_session_flags != FALSE);
+	if (ctx->check_session_flags)
+		key.session_flags = ctx->session_flags;
+
+	if (g_hash_table_lookup_extended (self->priv->links_cache, &key, NULL, &value)) {
+		g_object_unref (self);
+		return GPOINTER_TO_INT (value);
+	}
+
+	result = brasero_caps_find_link_real (caps, ctx);
+
+	if (g_hash_table_size (self->priv->links_cache) >= BRASERO_CAPS_LINK_CACHE_MAX)
+		g_hash_table_remove_all (self->priv->links_cache);
+
+	g_hash_table_insert (self->priv->links_cache,
+	                     g_memdup (&key, sizeof (BraseroCapsLinkKey)),
+	                     GINT_TO_POINTER (result));
+
+	g_object_unref (self);
+	return result;
+}
+
 static BraseroBurnResult
 brasero_caps_try_output (BraseroBurnCaps *self,
                          BraseroFindLinkCtx *ctx,
@@ -34,7 +34,6 @@
 
 #include <string.h>
 #include <stdio.h>
-#include <libgen.h>
 #include <sys/param.h>
 
 #include <glib.h>
@@ -45,6 +44,7 @@
 #include "brasero-units.h"
 
 #include "brasero-data-project.h"
+#include "brasero-uri-tree.h"
 #include "libbrasero-marshal.h"
 
 #include "brasero-misc.h"
@@ -61,7 +61,8 @@ struct _BraseroDataProjectPrivate
 	GCompareFunc sort_func;
 	GtkSortType sort_type;
 
-	GSList *spanned;
+	/* Top nodes already burnt while spanning (used as a set) */
+	GHashTable *spanned;
 
 	/**
 	 * In this table we record all changes (key = URI, data = list
@@ -76,6 +77,11 @@ struct _BraseroDataProjectPrivate
 	 * any node then that means that the file/URI will not appear in the 
 	 * image */
 	GHashTable *grafts;
+
+	/* Same URIs as above (except NEW_FOLDER) to find the grafted parent
+	 * URIs of a URI or all its grafted children in one walk */
+	BraseroUriTree *graft_tree;
+
 	GHashTable *reference;
 
 	GHashTable *joliet;
@@ -85,7 +91,15 @@ struct _BraseroDataProjectPrivate
 	/* This is a counter for the number of files to be loaded */
 	guint loading;
 
+	/* Sectors of the URIs grafted at several places that are not counted
+	 * in the whole tree size; valid while the changes counter of the tree
+	 * stats is still duplicate_changes */
+	guint64 duplicate_sectors;
+	guint duplicate_changes;
+
 	guint is_loading_contents:1;
+	guint has_duplicates:1;
+	guint duplicates_valid:1;
 };
 
 #define BRASERO_DATA_PROJECT_PRIVATE(o)  (G_TYPE_INSTANCE_GET_PRIVATE ((o), BRASERO_TYPE_DATA_PROJECT, BraseroDataProjectPrivate))
@@ -595,35 +609,35 @@ static BraseroFileNode *
 brasero_data_project_find_child_node (BraseroFileNode *node,
 				      const gchar *path)
 {
+	gchar *name;
+	gchar *copy;
 	gchar *end;
-	guint len;
 
-	/* skip the separator if any */
-	if (path [0] == G_DIR_SEPARATOR)
-		path ++;
+	/* Split the path in place so that each name can be looked up through
+	 * brasero_file_node_check_name_existence () which uses the children
+	 * index of big directories. */
+	copy = g_strdup (path);
+	name = copy;
 
-	/* find the next separator if any */
-	end = g_utf8_strchr (path, -1, G_DIR_SEPARATOR);
+	while (node) {
+		/* skip the separator if any */
+		if (name [0] == G_DIR_SEPARATOR)
+			name ++;
 
-	if (end)
-		len = end - path;
-	else
-		len = strlen (path);
+		/* find the next separator if any */
+		end = strchr (name, G_DIR_SEPARATOR);
+		if (end)
+			*end = '\0';
 
-	/* go through the children nodes and find the name */
-	for (node = BRASERO_FILE_NODE_CHILDREN (node); node; node = node->next) {
-		if (node
-		&& !strncmp (BRASERO_FILE_NODE_NAME (node), path, len)
-		&& (BRASERO_FILE_NODE_NAME (node) [len] == G_DIR_SEPARATOR
-		||  BRASERO_FILE_NODE_NAME (node) [len] == '\0')) {
-			if (end)
-				return brasero_data_project_find_child_node (node, end);
+		node = brasero_file_node_check_name_existence (node, name);
+		if (!end)
+			break;
 
-			return node;
-		}	
+		name = end + 1;
 	}
+	g_free (copy);
 
-	return NULL;
+	return node;
 }
 
 static GSList *
@@ -633,7 +647,7 @@ brasero_data_project_uri_to_nodes (BraseroDataProject *self,
 	BraseroDataProjectPrivate *priv;
 	BraseroURINode *graft;
 	GSList *nodes = NULL;
-	gchar *parent;
+	gsize parent_len;
 	GSList *iter;
 	gchar *path;
 
@@ -644,24 +658,14 @@ brasero_data_project_uri_to_nodes (BraseroDataProject *self,
 	if (graft)
 		return g_slist_copy (graft->nodes);
 
-	/* keep going up until we reach root URI in grafts */
-	parent = g_path_get_dirname (uri);
-	while (strcmp (parent, G_DIR_SEPARATOR_S) && strchr (parent, G_DIR_SEPARATOR)) {
-		graft = g_hash_table_lookup (priv->grafts, parent);
-		if (graft)
-			break;
-
-		parent = dirname (parent);
-	}
-
+	/* find the closest parent URI in grafts */
+	graft = brasero_uri_tree_lookup_parent (priv->graft_tree, uri, &parent_len);
 	if (!graft) {
 		/* no graft point was found; there isn't any node */
-		g_free (parent);
 		return NULL;
 	}
 
-	uri += strlen (parent);
-	g_free (parent);
+	uri += parent_len;
 
 	/* unescape URI */
 	path = g_uri_unescape_string (uri, NULL);
@@ -811,24 +815,9 @@ brasero_data_project_uri_has_parent (BraseroDataProject *self,
 				     const gchar *uri)
 {
 	BraseroDataProjectPrivate *priv;
-	gchar *parent;
 
 	priv = BRASERO_DATA_PROJECT_PRIVATE (self);
-
-	parent = g_path_get_dirname (uri);
-
-	/* keep going up until we reach a root URI */
-	while (strcmp (parent, G_DIR_SEPARATOR_S) && strchr (parent, G_DIR_SEPARATOR)) {
-		if (g_hash_table_lookup (priv->grafts, parent)) {
-			g_free (parent);
-			return TRUE;
-		}
-
-		parent = dirname (parent);
-	}
-
-	g_free (parent);
-	return FALSE;
+	return (brasero_uri_tree_lookup_parent (priv->graft_tree, uri, NULL) != NULL);
 }
 
 static gboolean
@@ -892,16 +881,15 @@ brasero_data_project_uri_is_graft_needed (BraseroDataProject *self,
 	}
 	g_free (name);
 
+	g_free (parent);
+
 	/* make sure no node is missing/removed. To do this find the 
 	 * first parent URI in the hash and see if it has the same 
 	 * number of graft point as this one. If not that means one
 	 * node is missing. */
-	graft_parent = g_hash_table_lookup (priv->grafts, parent);
-	while (parent && !graft_parent) {
-		parent = dirname (parent);
-		graft_parent = g_hash_table_lookup (priv->grafts, parent);
-	}
-	g_free (parent);
+	graft_parent = brasero_uri_tree_lookup_parent (priv->graft_tree, uri, NULL);
+	if (!graft_parent)
+		return TRUE;
 
 	if (g_slist_length (graft_parent->nodes) != g_slist_length (graft->nodes))
 		return TRUE;
@@ -938,6 +926,8 @@ brasero_data_project_uri_remove_graft (BraseroDataProject *self,
 
 	/* we have to free the key and data ourselves */
 	g_hash_table_remove (priv->grafts, uri);
+	if (key != NEW_FOLDER)
+		brasero_uri_tree_remove (priv->graft_tree, uri);
 
 	klass = BRASERO_DATA_PROJECT_GET_CLASS (self);
 	if (klass->uri_removed)
@@ -991,6 +981,8 @@ brasero_data_project_uri_add_graft (BraseroDataProject *self,
 	g_hash_table_insert (priv->grafts,
 			     graft->uri,
 			     graft);
+	if (uri != NEW_FOLDER)
+		brasero_uri_tree_insert (priv->graft_tree, graft->uri, graft);
 
 	return graft;
 }
@@ -1090,7 +1082,16 @@ brasero_data_project_remove_node_children_graft_cb (const gchar *key,
 
 	/* Check if this graft should be removed. If not, it should 
 	 * have a parent URI in the graft. */
-	return (brasero_data_project_uri_has_parent (data->project, key) == FALSE);
+	if (brasero_data_project_uri_has_parent (data->project, key))
+		return FALSE;
+
+	if (key != NEW_FOLDER) {
+		BraseroDataProjectPrivate *priv;
+
+		priv = BRASERO_DATA_PROJECT_PRIVATE (data->project);
+		brasero_uri_tree_remove (priv->graft_tree, key);
+	}
+	return TRUE;
 }
 
 static void
@@ -1772,7 +1773,7 @@ brasero_data_project_restore_uri (BraseroDataProject *self,
 		if (brasero_file_node_check_name_existence (parent, name))
 			continue;
 
-		node = brasero_file_node_new_loading (name);
+		node = brasero_file_node_new_loading (BRASERO_FILE_NODE_ARENA (priv->root), name);
 		brasero_file_node_add (parent, node, priv->sort_func);
 		brasero_data_project_add_node_real (self, node, graft, uri);
 	}
@@ -1829,12 +1830,13 @@ brasero_data_project_add_imported_session_file (BraseroDataProject *self,
 		 * replace those whenever we run into one but not lose their 
 		 * children. */
 		if (BRASERO_FILE_NODE_VIRTUAL (sibling)) {
-			node = brasero_file_node_new_imported_session_file (info);
+			node = brasero_file_node_new_imported_session_file (BRASERO_FILE_NODE_ARENA (priv->root), info);
 			brasero_data_project_virtual_sibling (self, node, sibling);
 		}
 		else if (sibling->is_fake && sibling->is_tmp_parent) {
 			BraseroGraft *graft;
 			BraseroURINode *uri_node;
+			guint64 old_total;
 
 			graft = BRASERO_FILE_NODE_GRAFT (sibling);
 			uri_node = graft->node;
@@ -1852,8 +1854,10 @@ brasero_data_project_add_imported_session_file (BraseroDataProject *self,
 			else
 				sibling->union3.imported_address = g_file_info_get_attribute_int64 (info, BRASERO_IO_DIR_CONTENTS_ADDR);
 
+			old_total = BRASERO_FILE_NODE_TOTAL_SECTORS (sibling);
 			sibling->is_imported = TRUE;
 			sibling->is_tmp_parent = FALSE;
+			brasero_file_node_total_changed (sibling, old_total);
 
 			/* Something has changed, tell the tree */
 			klass = BRASERO_DATA_PROJECT_GET_CLASS (self);
@@ -1869,11 +1873,11 @@ brasero_data_project_add_imported_session_file (BraseroDataProject *self,
 			 * be replaced, so we delete that node (since the new
 			 * one would have the old one's children otherwise). */
 			brasero_data_project_remove_real (self, sibling);
-			node = brasero_file_node_new_imported_session_file (info);
+			node = brasero_file_node_new_imported_session_file (BRASERO_FILE_NODE_ARENA (priv->root), info);
 		}
 	}
 	else
-		node = brasero_file_node_new_imported_session_file (info);
+		node = brasero_file_node_new_imported_session_file (BRASERO_FILE_NODE_ARENA (priv->root), info);
 
 	/* Add it (we must add a graft) */
 	brasero_file_node_add (parent, node, priv->sort_func);
@@ -1913,7 +1917,7 @@ brasero_data_project_add_empty_directory (BraseroDataProject *self,
 	sibling = brasero_file_node_check_name_existence (parent, name);
 	if (sibling) {
 		if (BRASERO_FILE_NODE_VIRTUAL (sibling)) {
-			node = brasero_file_node_new_empty_folder (name);
+			node = brasero_file_node_new_empty_folder (BRASERO_FILE_NODE_ARENA (priv->root), name);
 			brasero_data_project_virtual_sibling (self, node, sibling);
 		}
 		else if (brasero_data_project_node_signal (self, NAME_COLLISION_SIGNAL, sibling))
@@ -1923,11 +1927,11 @@ brasero_data_project_add_empty_directory (BraseroDataProject *self,
 			 * be replaced, so we delete that node (since the new
 			 * one would have the old one's children otherwise). */
 			brasero_data_project_remove_real (self, sibling);
-			node = brasero_file_node_new_empty_folder (name);
+			node = brasero_file_node_new_empty_folder (BRASERO_FILE_NODE_ARENA (priv->root), name);
 		}
 	}
 	else
-		node = brasero_file_node_new_empty_folder (name);
+		node = brasero_file_node_new_empty_folder (BRASERO_FILE_NODE_ARENA (priv->root), name);
 
 	brasero_file_node_add (parent, node, priv->sort_func);
 
@@ -2198,7 +2202,7 @@ brasero_data_project_add_loading_node_real (BraseroDataProject *self,
 	sibling = brasero_file_node_check_name_existence (parent, name);
 	if (sibling) {
 		if (BRASERO_FILE_NODE_VIRTUAL (sibling)) {
-			node = brasero_file_node_new_loading (name);
+			node = brasero_file_node_new_loading (BRASERO_FILE_NODE_ARENA (priv->root), name);
 			brasero_data_project_virtual_sibling (self, node, sibling);
 		}
 		else if (brasero_data_project_node_signal (self, NAME_COLLISION_SIGNAL, sibling)) {
@@ -2210,18 +2214,20 @@ brasero_data_project_add_loading_node_real (BraseroDataProject *self,
 			 * be replaced, so we delete that node (since the new
 			 * one would have the old one's children otherwise). */
 			brasero_data_project_remove_real (self, sibling);
-			node = brasero_file_node_new_loading (name);
+			node = brasero_file_node_new_loading (BRASERO_FILE_NODE_ARENA (priv->root), name);
 			graft = g_hash_table_lookup (priv->grafts, uri);
 		}
 	}
 	else
-		node = brasero_file_node_new_loading (name);
+		node = brasero_file_node_new_loading (BRASERO_FILE_NODE_ARENA (priv->root), name);
 
 	g_free (name);
 
+	/* Set it before adding the node so it is inserted at the right
+	 * place (hidden nodes are always last). */
+	node->is_hidden = is_hidden;
 	brasero_file_node_add (parent, node, priv->sort_func);
 
-	node->is_hidden = is_hidden;
 	if (!brasero_data_project_add_node_real (self, node, graft, uri))
 		return NULL;
 
@@ -2381,7 +2387,7 @@ brasero_data_project_add_node_from_info (BraseroDataProject *self,
 		stats = brasero_file_node_get_tree_stats (priv->root, NULL);
 
 		if (BRASERO_FILE_NODE_VIRTUAL (sibling)) {
-			node = brasero_file_node_new (g_file_info_get_name (info));
+			node = brasero_file_node_new (BRASERO_FILE_NODE_ARENA (priv->root), g_file_info_get_name (info));
 			brasero_file_node_set_from_info (node, stats, info);
 			brasero_data_project_virtual_sibling (self, node, sibling);
 		}
@@ -2394,7 +2400,7 @@ brasero_data_project_add_node_from_info (BraseroDataProject *self,
 			/* The node existed and the user wants the existing to 
 			 * be replaced, so we delete that node (since the new
 			 * one would have the old one's children otherwise). */
-			node = brasero_file_node_new (g_file_info_get_name (info));
+			node = brasero_file_node_new (BRASERO_FILE_NODE_ARENA (priv->root), g_file_info_get_name (info));
 			brasero_file_node_set_from_info (node, stats, info);
 
 			brasero_data_project_remove_real (self, sibling);
@@ -2404,7 +2410,7 @@ brasero_data_project_add_node_from_info (BraseroDataProject *self,
 	else {
 		BraseroFileTreeStats *stats;
 
-		node = brasero_file_node_new (g_file_info_get_name (info));
+		node = brasero_file_node_new (BRASERO_FILE_NODE_ARENA (priv->root), g_file_info_get_name (info));
 		stats = brasero_file_node_get_tree_stats (priv->root, NULL);
 		brasero_file_node_set_from_info (node, stats, info);
 	}
@@ -2461,6 +2467,179 @@ brasero_data_project_add_node_from_info (BraseroDataProject *self,
 	return node;
 }
 
+/**
+ * Entries that may need a signal (collision, size, depth) or a graft are left
+ * to brasero_data_project_add_node_from_info ().
+ */
+
+static gboolean
+brasero_data_project_node_info_is_plain (BraseroDataProject *self,
+					 BraseroFileNode *parent,
+					 guint parent_depth,
+					 const gchar *uri,
+					 GFileInfo *info)
+{
+	BraseroDataProjectPrivate *priv;
+	GFileType type;
+
+	priv = BRASERO_DATA_PROJECT_PRIVATE (self);
+
+	if (g_hash_table_lookup (priv->grafts, uri))
+		return FALSE;
+
+	type = g_file_info_get_file_type (info);
+	if (type != G_FILE_TYPE_DIRECTORY) {
+		if (BRASERO_BYTES_TO_SECTORS (g_file_info_get_size (info), 2048) > BRASERO_FILE_2G_LIMIT)
+			return FALSE;
+	}
+	else if (parent_depth == 5)
+		return FALSE;
+
+	if (g_file_info_get_is_symlink (info)
+	&&  type != G_FILE_TYPE_SYMBOLIC_LINK)
+		return FALSE;
+
+	if (brasero_file_node_check_name_existence (parent, g_file_info_get_name (info)))
+		return FALSE;
+
+	return TRUE;
+}
+
+struct _BraseroDataProjectNodesData {
+	BraseroDataProject *project;
+	GHashTable *node_uris;
+	gboolean size_changed;
+};
+typedef struct _BraseroDataProjectNodesData BraseroDataProjectNodesData;
+
+/* Called for each node of a list once it is in the tree */
+static void
+brasero_data_project_node_linked_cb (gpointer data,
+				     gpointer user_data)
+{
+	BraseroDataProjectNodesData *callback_data = user_data;
+	BraseroFileNode *node = data;
+	const gchar *uri;
+
+	uri = g_hash_table_lookup (callback_data->node_uris, node);
+	brasero_data_project_add_node_real (callback_data->project, node, NULL, uri);
+
+	if (node->is_file)
+		callback_data->size_changed = TRUE;
+
+#ifdef BUILD_INOTIFY
+
+	if (!node->is_monitored) {
+		if (node->is_grafted)
+			brasero_file_monitor_single_file (BRASERO_FILE_MONITOR (callback_data->project),
+							  uri,
+							  node);
+
+		if (!node->is_file)
+			brasero_file_monitor_directory_contents (BRASERO_FILE_MONITOR (callback_data->project),
+								 uri,
+								 node);
+		node->is_monitored = TRUE;
+	}
+
+#endif
+
+}
+
+/**
+ * Same as brasero_data_project_add_node_from_info () for a whole list of
+ * entries of a directory being explored (uris and infos are in the same
+ * order). The nodes are sorted once and merged with the children of parent
+ * in a single pass.
+ */
+
+void
+brasero_data_project_add_nodes_from_info (BraseroDataProject *self,
+					  BraseroFileNode *parent,
+					  GSList *uris,
+					  GSList *infos)
+{
+	BraseroDataProjectClass *klass;
+	BraseroDataProjectPrivate *priv;
+	BraseroDataProjectNodesData callback_data;
+	BraseroFileTreeStats *stats;
+	GSList *others_infos = NULL;
+	GSList *others_uris = NULL;
+	GHashTable *node_uris;
+	GSList *nodes = NULL;
+	guint parent_depth;
+	GSList *iter_info;
+	GSList *iter;
+
+	g_return_if_fail (BRASERO_IS_DATA_PROJECT (self));
+	g_return_if_fail (parent != NULL);
+
+	priv = BRASERO_DATA_PROJECT_PRIVATE (self);
+
+	node_uris = g_hash_table_new (g_direct_hash, g_direct_equal);
+	stats = brasero_file_node_get_tree_stats (priv->root, NULL);
+	parent_depth = brasero_file_node_get_depth (parent);
+
+	for (iter = uris, iter_info = infos; iter && iter_info; iter = iter->next, iter_info = iter_info->next) {
+		BraseroFileNode *node;
+
+		if (!brasero_data_project_node_info_is_plain (self, parent, parent_depth, iter->data, iter_info->data)) {
+			others_uris = g_slist_prepend (others_uris, iter->data);
+			others_infos = g_slist_prepend (others_infos, iter_info->data);
+			continue;
+		}
+
+		node = brasero_file_node_new (BRASERO_FILE_NODE_ARENA (priv->root), g_file_info_get_name (iter_info->data));
+		brasero_file_node_set_from_info (node, stats, iter_info->data);
+
+		nodes = g_slist_prepend (nodes, node);
+		g_hash_table_insert (node_uris, node, iter->data);
+	}
+
+	if (!nodes)
+		goto others;
+
+	/* Keep the order of arrival for nodes which compare equal */
+	nodes = g_slist_reverse (nodes);
+	nodes = g_slist_sort (nodes, priv->sort_func);
+
+	klass = BRASERO_DATA_PROJECT_GET_CLASS (self);
+	if (klass->nodes_adding)
+		klass->nodes_adding (self, parent);
+
+	callback_data.project = self;
+	callback_data.node_uris = node_uris;
+	callback_data.size_changed = FALSE;
+	brasero_file_node_add_list (parent,
+				    nodes,
+				    priv->sort_func,
+				    brasero_data_project_node_linked_cb,
+				    &callback_data);
+
+	if (klass->nodes_added)
+		klass->nodes_added (self, parent);
+
+	g_slist_free (nodes);
+
+	if (callback_data.size_changed)
+		g_signal_emit (self,
+			       brasero_data_project_signals [SIZE_CHANGED_SIGNAL],
+			       0);
+
+others:
+	g_hash_table_destroy (node_uris);
+
+	/* These ones may need to ask the user so do them last once all the
+	 * above nodes are in the tree */
+	others_uris = g_slist_reverse (others_uris);
+	others_infos = g_slist_reverse (others_infos);
+	for (iter = others_uris, iter_info = others_infos; iter && iter_info; iter = iter->next, iter_info = iter_info->next)
+		brasero_data_project_add_node_from_info (self, iter->data, iter_info->data, parent);
+
+	g_slist_free (others_uris);
+	g_slist_free (others_infos);
+}
+
 /**
  * Export tree internals into a track 
  */
@@ -2856,37 +3035,360 @@ brasero_data_project_improve_image_size_accuracy (goffset sectors,
 	return sectors;
 }
 
-goffset
-brasero_data_project_get_max_space (BraseroDataProject *self)
+/**
+ * Spanning: each disc is filled with top nodes (files or folders) that were
+ * not burnt yet. Top nodes are sorted by decreasing size and taken as long as
+ * they fit; then, if there are not too many of them, a bounded branch and
+ * bound search tries to find a combination filling the disc better.
+ */
+
+/* Above that number of candidates we keep the greedy result */
+#define BRASERO_DATA_PROJECT_SPAN_EXACT_MAX	256
+
+/* Maximum number of nodes explored by the branch and bound search */
+#define BRASERO_DATA_PROJECT_SPAN_BUDGET	200000
+
+struct _BraseroSpanItem {
+	BraseroFileNode *node;
+	goffset sectors;
+};
+typedef struct _BraseroSpanItem BraseroSpanItem;
+
+struct _BraseroSpanSearch {
+	BraseroSpanItem *items;
+	guint num;
+
+	goffset max_sectors;
+	goffset *remaining;
+
+	gboolean *current;
+	gboolean *selected;
+	goffset best;
+
+	guint budget;
+};
+typedef struct _BraseroSpanSearch BraseroSpanSearch;
+
+static gint
+brasero_data_project_span_item_sort (gconstpointer a,
+				     gconstpointer b)
+{
+	const BraseroSpanItem *item_a = a;
+	const BraseroSpanItem *item_b = b;
+
+	if (item_a->sectors > item_b->sectors)
+		return -1;
+
+	if (item_a->sectors < item_b->sectors)
+		return 1;
+
+	return 0;
+}
+
+static gboolean
+brasero_data_project_is_spanned (BraseroDataProject *self,
+				 BraseroFileNode *node)
 {
 	BraseroDataProjectPrivate *priv;
-	BraseroFileNode *children;
-	goffset max_sectors = 0;
 
 	priv = BRASERO_DATA_PROJECT_PRIVATE (self);
+	return priv->spanned && g_hash_table_lookup (priv->spanned, node) != NULL;
+}
 
-	/* When empty this is an error */
-	if (!g_hash_table_size (priv->grafts))
-		return 0;
+/**
+ * A URI grafted at several places in the tree ends up only once on the disc
+ * (like files sharing an inode with mkisofs and libisofs) so below top the
+ * size of its nodes is only counted for the first of them. Returns the size
+ * of all the others.
+ */
 
-	children = BRASERO_FILE_NODE_CHILDREN (priv->root);
-	while (children) {
-		goffset child_sectors;
+static guint64
+brasero_data_project_get_duplicate_sectors (BraseroDataProject *self,
+					    BraseroFileNode *top,
+					    gboolean *has_duplicates)
+{
+	BraseroDataProjectPrivate *priv;
+	GHashTableIter iter;
+	guint64 retval = 0;
+	gpointer value;
+
+	priv = BRASERO_DATA_PROJECT_PRIVATE (self);
+
+	g_hash_table_iter_init (&iter, priv->grafts);
+	while (g_hash_table_iter_next (&iter, NULL, &value)) {
+		BraseroURINode *uri_node;
+		gboolean counted = FALSE;
+		GSList *nodes;
+
+		uri_node = value;
 
-		if (g_slist_find (priv->spanned, children)) {
-			children = children->next;
+		/* Created folders all share the same URI */
+		if (uri_node->uri == NEW_FOLDER
+		|| !uri_node->nodes
+		|| !uri_node->nodes->next)
 			continue;
+
+		for (nodes = uri_node->nodes; nodes; nodes = nodes->next) {
+			BraseroFileNode *node;
+
+			node = nodes->data;
+			if (node->is_imported
+			|| !brasero_file_node_is_ancestor (top, node))
+				continue;
+
+			if (!counted) {
+				counted = TRUE;
+				continue;
+			}
+
+			if (has_duplicates)
+				*has_duplicates = TRUE;
+
+			retval += BRASERO_FILE_NODE_SECTORS (node);
 		}
+	}
 
-		if (children->is_file)
-			child_sectors = BRASERO_FILE_NODE_SECTORS (children);
-		else
-			child_sectors = brasero_data_project_get_folder_sectors (self, children);
+	return retval;
+}
 
-		max_sectors = MAX (max_sectors, child_sectors);
-		children = children->next;
+/**
+ * Returns the size of a directory and its contents. The totals kept on the
+ * nodes count each place a URI is grafted at so duplicates are removed. They
+ * are searched only when the tree changed and if there are any.
+ */
+
+static guint64
+brasero_data_project_get_total_sectors (BraseroDataProject *self,
+					BraseroFileNode *node)
+{
+	BraseroDataProjectPrivate *priv;
+	BraseroFileTreeStats *stats;
+	guint64 duplicates;
+	guint64 total;
+
+	priv = BRASERO_DATA_PROJECT_PRIVATE (self);
+
+	stats = BRASERO_FILE_NODE_STATS (priv->root);
+	if (!priv->duplicates_valid || priv->duplicate_changes != stats->changes) {
+		gboolean has_duplicates = FALSE;
+
+		priv->duplicate_sectors = brasero_data_project_get_duplicate_sectors (self,
+										      priv->root,
+										      &has_duplicates);
+		priv->has_duplicates = has_duplicates;
+		priv->duplicate_changes = stats->changes;
+		priv->duplicates_valid = TRUE;
+	}
+
+	total = BRASERO_FILE_NODE_TOTAL_SECTORS (node);
+	if (!priv->has_duplicates)
+		return total;
+
+	if (node == priv->root)
+		duplicates = priv->duplicate_sectors;
+	else
+		duplicates = brasero_data_project_get_duplicate_sectors (self, node, NULL);
+
+	return total > duplicates? total - duplicates:0;
+}
+
+/**
+ * Returns an array of all the top nodes not spanned yet with their size,
+ * sorted by decreasing size.
+ */
+
+static GArray *
+brasero_data_project_span_get_items (BraseroDataProject *self)
+{
+	BraseroDataProjectPrivate *priv;
+	BraseroFileNode *children;
+	GArray *items;
+
+	priv = BRASERO_DATA_PROJECT_PRIVATE (self);
+
+	items = g_array_new (FALSE, FALSE, sizeof (BraseroSpanItem));
+	for (children = BRASERO_FILE_NODE_CHILDREN (priv->root); children; children = children->next) {
+		BraseroSpanItem item;
+
+		if (brasero_data_project_is_spanned (self, children))
+			continue;
+
+		item.node = children;
+		item.sectors = children->is_file? BRASERO_FILE_NODE_SECTORS (children):brasero_data_project_get_total_sectors (self, children);
+		g_array_append_val (items, item);
+	}
+
+	g_array_sort (items, brasero_data_project_span_item_sort);
+	return items;
+}
+
+static void
+brasero_data_project_span_search (BraseroSpanSearch *search,
+				  guint index,
+				  goffset total)
+{
+	if (total > search->best) {
+		search->best = total;
+		memcpy (search->selected, search->current, search->num * sizeof (gboolean));
+	}
+
+	if (index >= search->num
+	||  search->best == search->max_sectors
+	|| !search->budget)
+		return;
+
+	search->budget --;
+
+	/* Even by taking all that remains we can't do better */
+	if (total + search->remaining [index] <= search->best)
+		return;
+
+	if (total + search->items [index].sectors <= search->max_sectors) {
+		search->current [index] = TRUE;
+		brasero_data_project_span_search (search,
+						  index + 1,
+						  total + search->items [index].sectors);
+		search->current [index] = FALSE;
+	}
+
+	brasero_data_project_span_search (search, index + 1, total);
+}
+
+/**
+ * Selects in items (sorted by decreasing size) the ones to put on a disc of
+ * max_sectors. Returns the number of sectors used.
+ */
+
+static goffset
+brasero_data_project_span_pack (GArray *items,
+				goffset max_sectors,
+				gboolean *selected)
+{
+	BraseroSpanSearch search;
+	goffset total = 0;
+	guint i;
+
+	/* Best fit decreasing: that's already close to optimal most of the
+	 * time and it gives the search a good bound to start with. */
+	for (i = 0; i < items->len; i ++) {
+		BraseroSpanItem *item;
+
+		item = &g_array_index (items, BraseroSpanItem, i);
+		selected [i] = (total + item->sectors <= max_sectors);
+		if (selected [i])
+			total += item->sectors;
+	}
+
+	if (total == max_sectors
+	||  items->len < 2
+	||  items->len > BRASERO_DATA_PROJECT_SPAN_EXACT_MAX)
+		return total;
+
+	search.items = (BraseroSpanItem *) items->data;
+	search.num = items->len;
+	search.max_sectors = max_sectors;
+	search.best = total;
+	search.budget = BRASERO_DATA_PROJECT_SPAN_BUDGET;
+	search.selected = selected;
+	search.current = g_new0 (gboolean, items->len);
+	search.remaining = g_new0 (goffset, items->len + 1);
+
+	for (i = items->len; i > 0; i --) {
+		goffset sectors;
+
+		/* Items that can't fit anyway don't count */
+		sectors = search.items [i - 1].sectors;
+		if (sectors > max_sectors)
+			sectors = 0;
+
+		search.remaining [i - 1] = search.remaining [i] + sectors;
 	}
 
+	brasero_data_project_span_search (&search, 0, 0);
+
+	if (search.best > total)
+		BRASERO_BURN_LOG ("Improved spanning from %" G_GOFFSET_FORMAT " to %" G_GOFFSET_FORMAT " sectors",
+				  total,
+				  search.best);
+
+	g_free (search.current);
+	g_free (search.remaining);
+	return search.best;
+}
+
+/**
+ * Returns the number of discs of max_sectors needed to burn what remains of
+ * the project and the ratio of the space used on these discs. Returns 0 if
+ * some of the top nodes are too large for such a disc.
+ */
+
+guint
+brasero_data_project_span_get_disc_num (BraseroDataProject *self,
+					goffset max_sectors,
+					gdouble *fill_ratio)
+{
+	BraseroDataProjectPrivate *priv;
+	goffset total_sectors = 0;
+	gboolean *selected;
+	guint disc_num = 0;
+	GArray *items;
+
+	priv = BRASERO_DATA_PROJECT_PRIVATE (self);
+
+	if (fill_ratio)
+		*fill_ratio = 0.0;
+
+	if (max_sectors <= 0 || !g_hash_table_size (priv->grafts))
+		return 0;
+
+	items = brasero_data_project_span_get_items (self);
+	if (items->len && g_array_index (items, BraseroSpanItem, 0).sectors > max_sectors) {
+		g_array_free (items, TRUE);
+		return 0;
+	}
+
+	selected = g_new0 (gboolean, items->len);
+	while (items->len) {
+		guint i;
+
+		total_sectors += brasero_data_project_span_pack (items, max_sectors, selected);
+		disc_num ++;
+
+		/* Remove what went on this disc keeping the order */
+		for (i = items->len; i > 0; i --) {
+			if (selected [i - 1])
+				g_array_remove_index (items, i - 1);
+		}
+	}
+
+	g_free (selected);
+	g_array_free (items, TRUE);
+
+	if (fill_ratio && disc_num)
+		*fill_ratio = (gdouble) total_sectors / ((gdouble) max_sectors * disc_num);
+
+	return disc_num;
+}
+
+goffset
+brasero_data_project_get_max_space (BraseroDataProject *self)
+{
+	BraseroDataProjectPrivate *priv;
+	goffset max_sectors = 0;
+	GArray *items;
+
+	priv = BRASERO_DATA_PROJECT_PRIVATE (self);
+
+	/* When empty this is an error */
+	if (!g_hash_table_size (priv->grafts))
+		return 0;
+
+	/* Items are sorted so the first one is the largest */
+	items = brasero_data_project_span_get_items (self);
+	if (items->len)
+		max_sectors = g_array_index (items, BraseroSpanItem, 0).sectors;
+
+	g_array_free (items, TRUE);
 	return max_sectors;
 }
 
@@ -2899,8 +3401,10 @@ brasero_data_project_span (BraseroDataProject *self,
 {
 	MakeTrackDataSpan callback_data;
 	BraseroDataProjectPrivate *priv;
-	BraseroFileNode *children;
 	goffset total_sectors = 0;
+	gboolean *selected;
+	GArray *items;
+	guint i;
 
 	priv = BRASERO_DATA_PROJECT_PRIVATE (self);
 
@@ -2916,30 +3420,20 @@ brasero_data_project_span (BraseroDataProject *self,
 	if (joliet)
 		callback_data.fs_type |= BRASERO_IMAGE_FS_JOLIET;
 
-	children = BRASERO_FILE_NODE_CHILDREN (priv->root);
-	while (children) {
-		goffset child_sectors;
+	if (!priv->spanned)
+		priv->spanned = g_hash_table_new (g_direct_hash, g_direct_equal);
 
-		if (g_slist_find (priv->spanned, children)) {
-			children = children->next;
-			continue;
-		}
+	items = brasero_data_project_span_get_items (self);
+	selected = g_new0 (gboolean, items->len);
+	total_sectors = brasero_data_project_span_pack (items, max_sectors, selected);
 
-		if (children->is_file)
-			child_sectors = BRASERO_FILE_NODE_SECTORS (children);
-		else
-			child_sectors = brasero_data_project_get_folder_sectors (self, children);
+	for (i = 0; i < items->len; i ++) {
+		BraseroFileNode *children;
 
-		/* if the top directory is too large, continue */
-		if (child_sectors + total_sectors > max_sectors) {
-			children = children->next;
+		if (!selected [i])
 			continue;
-		}
 
-		/* FIXME: we need a better algorithm here that would add first
-		 * the biggest top folders/files and that would try to fill as
-		 * much as possible the disc. */
-		total_sectors += child_sectors;
+		children = g_array_index (items, BraseroSpanItem, i).node;
 
 		/* Take care of joliet non compliant nodes */
 		if (callback_data.fs_type & BRASERO_IMAGE_FS_JOLIET) {
@@ -2987,10 +3481,12 @@ brasero_data_project_span (BraseroDataProject *self,
 			callback_data.dir_num ++;
 		}
 
-		priv->spanned = g_slist_prepend (priv->spanned, children);
-		children = children->next;
+		g_hash_table_insert (priv->spanned, children, children);
 	}
 
+	g_free (selected);
+	g_array_free (items, TRUE);
+
 	/* This means it's finished */
 	if (!callback_data.grafts) {
 		BRASERO_BURN_LOG ("No graft found for spanning");
@@ -3023,8 +3519,8 @@ brasero_data_project_span_possible (BraseroDataProject *self,
 				    goffset max_sectors)
 {
 	BraseroDataProjectPrivate *priv;
-	gboolean has_data_left = FALSE;
-	BraseroFileNode *children;
+	BraseroBurnResult result;
+	GArray *items;
 
 	priv = BRASERO_DATA_PROJECT_PRIVATE (self);
 
@@ -3032,33 +3528,18 @@ brasero_data_project_span_possible (BraseroDataProject *self,
 	if (!g_hash_table_size (priv->grafts))
 		return BRASERO_BURN_ERR;
 
-	children = BRASERO_FILE_NODE_CHILDREN (priv->root);
-	while (children) {
-		goffset child_sectors;
-
-		if (g_slist_find (priv->spanned, children)) {
-			children = children->next;
-			continue;
-		}
-
-		if (children->is_file)
-			child_sectors = BRASERO_FILE_NODE_SECTORS (children);
-		else
-			child_sectors = brasero_data_project_get_folder_sectors (self, children);
-
-		/* Find at least one file or directory that can be spanned */
-		if (child_sectors < max_sectors)
-			return BRASERO_BURN_RETRY;
-
-		/* if the top directory is too large, continue */
-		children = children->next;
-		has_data_left = TRUE;
-	}
-
-	if (has_data_left)
-		return BRASERO_BURN_ERR;
+	/* Find at least one file or directory that can be spanned; since items
+	 * are sorted the smallest is the last one */
+	items = brasero_data_project_span_get_items (self);
+	if (!items->len)
+		result = BRASERO_BURN_OK;
+	else if (g_array_index (items, BraseroSpanItem, items->len - 1).sectors < max_sectors)
+		result = BRASERO_BURN_RETRY;
+	else
+		result = BRASERO_BURN_ERR;
 
-	return BRASERO_BURN_OK;
+	g_array_free (items, TRUE);
+	return result;
 }
 
 BraseroBurnResult
@@ -3075,7 +3556,7 @@ brasero_data_project_span_again (BraseroDataProject *self)
 
 	children = BRASERO_FILE_NODE_CHILDREN (priv->root);
 	while (children) {
-		if (!g_slist_find (priv->spanned, children))
+		if (!brasero_data_project_is_spanned (self, children))
 			return BRASERO_BURN_RETRY;
 
 		children = children->next;
@@ -3090,8 +3571,10 @@ brasero_data_project_span_stop (BraseroDataProject *self)
 	BraseroDataProjectPrivate *priv;
 
 	priv = BRASERO_DATA_PROJECT_PRIVATE (self);
-	g_slist_free (priv->spanned);
-	priv->spanned = NULL;
+	if (priv->spanned) {
+		g_hash_table_destroy (priv->spanned);
+		priv->spanned = NULL;
+	}
 }
 
 gboolean
@@ -3228,7 +3711,7 @@ brasero_data_project_create_path (BraseroDataProject *self,
 		len = end - path;
 		name = g_strndup (path, len);
 
-		node = brasero_file_node_new_loading (name);
+		node = brasero_file_node_new_loading (BRASERO_FILE_NODE_ARENA (priv->root), name);
 		brasero_file_node_add (parent, node, priv->sort_func);
 		parent = node;
 		g_free (name);
@@ -3381,9 +3864,9 @@ brasero_data_project_add_path (BraseroDataProject *self,
 		 * - we don't check for sibling
 		 * - we set right from the start the right name */
 		if (uri != NEW_FOLDER)
-			node = brasero_file_node_new_loading (path);
+			node = brasero_file_node_new_loading (BRASERO_FILE_NODE_ARENA (priv->root), path);
 		else
-			node = brasero_file_node_new_empty_folder (path);
+			node = brasero_file_node_new_empty_folder (BRASERO_FILE_NODE_ARENA (priv->root), path);
 
 		brasero_file_node_add (parent, node, priv->sort_func);
 
@@ -3424,18 +3907,7 @@ brasero_data_project_add_excluded_uri (BraseroDataProject *self,
 	/* Then get all the nodes from the first grafted parent URI.
 	 * NOTE: here we don't check the graft uri itself since there is a graft
 	 * but there are probably no node. */
-	parent_uri = g_path_get_dirname (uri);
-	while (strcmp (parent_uri, G_DIR_SEPARATOR_S) && strchr (parent_uri, G_DIR_SEPARATOR)) {
-		/* keep going up until we reach root URI in grafts */
-		graft = g_hash_table_lookup (priv->grafts, parent_uri);
-		if (graft)
-			break;
-
-		graft = NULL;
-		parent_uri = dirname (parent_uri);
-	}
-	g_free (parent_uri);
-
+	graft = brasero_uri_tree_lookup_parent (priv->graft_tree, uri, NULL);
 	if (!graft)
 		return folders;
 
@@ -3680,83 +4152,44 @@ brasero_data_project_load_contents (BraseroDataProject *self,
 }
 
 /**
- * get the size of the whole tree in sectors 
+ * get the size of the whole tree in sectors; all directories keep the
+ * total of their contents up to date so that's mostly the root's.
  */
-static void
-brasero_data_project_sum_graft_size_cb (gpointer key,
-					BraseroURINode *graft,
-					guint *sum_value)
-{
-	BraseroFileNode *node;
-
-	if (!graft->nodes)
-		return;
-
-	node = graft->nodes->data;
-	*sum_value += BRASERO_FILE_NODE_SECTORS (node);
-}
-
 goffset
 brasero_data_project_get_sectors (BraseroDataProject *self)
 {
 	BraseroDataProjectPrivate *priv;
-	guint retval = 0;
 
 	priv = BRASERO_DATA_PROJECT_PRIVATE (self);
+	if (!priv->root)
+		return 0;
 
-	/* make the sum of all graft sizes provided they have nodes */
-	g_hash_table_foreach (priv->grafts,
-			      (GHFunc) brasero_data_project_sum_graft_size_cb,
-			      &retval);
-	return retval;
-}
-
-struct _BraseroFileSize {
-	goffset sum;
-	BraseroFileNode *node;
-};
-typedef struct _BraseroFileSize BraseroFileSize;
-
-static void
-brasero_data_project_folder_size_cb (const gchar *uri,
-				     BraseroURINode *graft,
-				     BraseroFileSize *size)
-{
-	GSList *iter;
-
-	for (iter = graft->nodes; iter; iter = iter->next) {
-		BraseroFileNode *node;
-
-		node = iter->data;
-		if (node == size->node)
-			continue;
-
-		if (brasero_file_node_is_ancestor (size->node, node)) {
-			size->sum += BRASERO_FILE_NODE_SECTORS (node);
-			return;
-		}
-	}
+	return brasero_data_project_get_total_sectors (self, priv->root);
 }
 
 goffset
 brasero_data_project_get_folder_sectors (BraseroDataProject *self,
 					 BraseroFileNode *node)
 {
-	BraseroDataProjectPrivate *priv;
-	BraseroFileSize size;
-
 	if (node->is_file)
 		return 0;
 
-	priv = BRASERO_DATA_PROJECT_PRIVATE (self);
+	return brasero_data_project_get_total_sectors (self, node);
+}
 
-	size.node = node;
-	size.sum = BRASERO_FILE_NODE_SECTORS (node);
+/**
+ * Returns the memory (in bytes) taken by the nodes of the tree and their names
+ */
+gsize
+brasero_data_project_get_memory_usage (BraseroDataProject *self)
+{
+	BraseroDataProjectPrivate *priv;
 
-	g_hash_table_foreach (priv->grafts,
-			      (GHFunc) brasero_data_project_folder_size_cb,
-			      &size);
-	return size.sum;
+	priv = BRASERO_DATA_PROJECT_PRIVATE (self);
+	if (!priv->root)
+		return 0;
+
+	return brasero_file_node_arena_get_size (BRASERO_FILE_NODE_ARENA (priv->root));
 }
 
 static void
@@ -3775,6 +4208,7 @@ brasero_data_project_init (BraseroDataProject *object)
 	/* create the necessary hash tables */
 	priv->grafts = g_hash_table_new (g_str_hash,
 					 g_str_equal);
+	priv->graft_tree = brasero_uri_tree_new ();
 	priv->joliet = g_hash_table_new (brasero_data_project_joliet_hash,
 					 brasero_data_project_joliet_equal);
 	priv->reference = g_hash_table_new (g_direct_hash,
@@ -3820,7 +4254,7 @@ brasero_data_project_watch_path (BraseroDataProject *project,
 	for (iter = array; iter && *iter && parent; iter ++) {
 		BraseroFileNode *node;
 
-		node = brasero_file_node_new_virtual (*iter);
+		node = brasero_file_node_new_virtual (BRASERO_FILE_NODE_ARENA (priv->root), *iter);
 		brasero_file_node_add (parent, node, NULL);
 		parent = node;
 	}
@@ -3873,7 +4307,7 @@ brasero_data_project_clear (BraseroDataProject *self)
 	priv = BRASERO_DATA_PROJECT_PRIVATE (self);
 
 	if (priv->spanned) {
-		g_slist_free (priv->spanned);
+		g_hash_table_destroy (priv->spanned);
 		priv->spanned = NULL;
 	}
 
@@ -3882,6 +4316,7 @@ brasero_data_project_clear (BraseroDataProject *self)
 	g_hash_table_foreach_remove (priv->grafts,
 				     (GHRFunc) brasero_data_project_clear_grafts_cb,
 				     NULL);
+	brasero_uri_tree_remove_all (priv->graft_tree);
 
 	g_hash_table_foreach_remove (priv->joliet,
 				     (GHRFunc) brasero_data_project_clear_joliet_cb,
@@ -3893,6 +4328,7 @@ brasero_data_project_clear (BraseroDataProject *self)
 	/* no need to give a stats since we're destroying it */
 	brasero_file_node_destroy (priv->root, NULL);
 	priv->root = NULL;
+	priv->duplicates_valid = FALSE;
 
 #ifdef BUILD_INOTIFY
 
@@ -3935,6 +4371,11 @@ brasero_data_project_finalize (GObject *object)
 		priv->grafts = NULL;
 	}
 
+	if (priv->graft_tree) {
+		brasero_uri_tree_free (priv->graft_tree);
+		priv->graft_tree = NULL;
+	}
+
 	if (priv->joliet) {
 		g_hash_table_destroy (priv->joliet);
 		priv->joliet = NULL;
@@ -4306,6 +4747,15 @@ brasero_data_project_file_moved (BraseroFileMonitor *monitor,
 	}
 }
 
+static void
+brasero_data_project_empty_graft_cb (const gchar *uri,
+				     BraseroURINode *graft,
+				     GSList **list)
+{
+	if (!graft->nodes)
+		*list = g_slist_prepend (*list, graft->uri);
+}
+
 static void
 brasero_data_project_file_removed (BraseroFileMonitor *monitor,
 				   BraseroFileMonitorType type,
@@ -4315,6 +4765,9 @@ brasero_data_project_file_removed (BraseroFileMonitor *monitor,
 	BraseroDataProjectPrivate *priv;
 	BraseroURINode *uri_node;
 	BraseroFileNode *node;
+	GSList *excluded = NULL;
+	GSList *nodes;
+	GSList *iter;
 	gchar *uri;
 
 	priv = BRASERO_DATA_PROJECT_PRIVATE (monitor);
@@ -4334,13 +4787,38 @@ brasero_data_project_file_removed (BraseroFileMonitor *monitor,
 
 	/* a graft must have been created or already existed. */
 	uri_node = g_hash_table_lookup (priv->grafts, uri);
-	g_free (uri);
 
 	/* check if we can remove it (no more nodes) */
-	if (!uri_node || uri_node->nodes)
+	if (uri_node && uri_node->nodes) {
+		g_free (uri);
+		return;
+	}
+
+	/* The file can still be in the tree where one of its parents is
+	 * grafted a second time */
+	nodes = brasero_data_project_uri_to_nodes (BRASERO_DATA_PROJECT (monitor), uri);
+	if (nodes) {
+		g_slist_free (nodes);
+		g_free (uri);
+		return;
+	}
+
+	/* The URIs below which were only kept to be excluded (no node) are
+	 * useless now that the file is gone from the whole tree */
+	brasero_uri_tree_foreach_child (priv->graft_tree,
+					uri,
+					(GHFunc) brasero_data_project_empty_graft_cb,
+					&excluded);
+	for (iter = excluded; iter; iter = iter->next)
+		brasero_data_project_uri_remove_graft (BRASERO_DATA_PROJECT (monitor), iter->data);
+	g_slist_free (excluded);
+	g_free (uri);
+
+	if (!uri_node)
 		return;
 
 	g_hash_table_remove (priv->grafts, uri_node->uri);
+	brasero_uri_tree_remove (priv->graft_tree, uri_node->uri);
 	brasero_utils_unregister_string (uri_node->uri);
 	g_free (uri_node);
 }
@@ -90,6 +90,14 @@ struct _BraseroDataProjectClass
 						 BraseroFileNode *node,
 						 const gchar *uri);
 
+	/* Called around the addition of a batch of children of parent
+	 * (the contents of a directory being explored). node_added is
+	 * still called for each node of the batch in between. */
+	void		(*nodes_adding)		(BraseroDataProject *project,
+						 BraseroFileNode *parent);
+	void		(*nodes_added)		(BraseroDataProject *project,
+						 BraseroFileNode *parent);
+
 	/* This is more an unparent signal. It shouldn't be assumed that the
 	 * node was destroyed or not destroyed. Like the above function, it is
 	 * also called when a node is moved. */
@@ -133,6 +141,9 @@ goffset
 brasero_data_project_get_folder_sectors (BraseroDataProject *project,
 					 BraseroFileNode *node);
 
+gsize
+brasero_data_project_get_memory_usage (BraseroDataProject *project);
+
 gboolean
 brasero_data_project_get_contents (BraseroDataProject *project,
 				   GSList **grafts,
@@ -173,6 +184,11 @@ brasero_data_project_add_node_from_info (BraseroDataProject *project,
 					 const gchar *uri,
 					 GFileInfo *info,
 					 BraseroFileNode *parent);
+void
+brasero_data_project_add_nodes_from_info (BraseroDataProject *project,
+					  BraseroFileNode *parent,
+					  GSList *uris,
+					  GSList *infos);
 BraseroFileNode *
 brasero_data_project_add_empty_directory (BraseroDataProject *project,
 					  const gchar *name,
@@ -264,6 +280,11 @@ brasero_data_project_span_possible (BraseroDataProject *project,
 goffset
 brasero_data_project_get_max_space (BraseroDataProject *self);
 
+guint
+brasero_data_project_span_get_disc_num (BraseroDataProject *project,
+					goffset max_sectors,
+					gdouble *fill_ratio);
+
 void
 brasero_data_project_span_stop (BraseroDataProject *project);
 
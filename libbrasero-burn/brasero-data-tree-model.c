@@ -55,6 +55,8 @@ enum {
 	ROW_REMOVED,
 	ROW_CHANGED,
 	ROWS_REORDERED,
+	ROWS_ADDING,
+	ROWS_ADDED,
 	LAST_SIGNAL
 };
 
@@ -87,6 +89,34 @@ end:
 	return TRUE;
 }
 
+static void
+brasero_data_tree_model_nodes_adding (BraseroDataProject *project,
+				      BraseroFileNode *parent)
+{
+	g_signal_emit (project,
+		       brasero_data_tree_model_signals [ROWS_ADDING],
+		       0,
+		       parent);
+
+	/* chain up this function */
+	if (BRASERO_DATA_PROJECT_CLASS (brasero_data_tree_model_parent_class)->nodes_adding)
+		BRASERO_DATA_PROJECT_CLASS (brasero_data_tree_model_parent_class)->nodes_adding (project, parent);
+}
+
+static void
+brasero_data_tree_model_nodes_added (BraseroDataProject *project,
+				     BraseroFileNode *parent)
+{
+	g_signal_emit (project,
+		       brasero_data_tree_model_signals [ROWS_ADDED],
+		       0,
+		       parent);
+
+	/* chain up this function */
+	if (BRASERO_DATA_PROJECT_CLASS (brasero_data_tree_model_parent_class)->nodes_added)
+		BRASERO_DATA_PROJECT_CLASS (brasero_data_tree_model_parent_class)->nodes_added (project, parent);
+}
+
 static void
 brasero_data_tree_model_node_removed (BraseroDataProject *project,
 				      BraseroFileNode *former_parent,
@@ -186,6 +216,8 @@ brasero_data_tree_model_class_init (BraseroDataTreeModelClass *klass)
 	object_class->finalize = brasero_data_tree_model_finalize;
 
 	data_project_class->node_added = brasero_data_tree_model_node_added;
+	data_project_class->nodes_adding = brasero_data_tree_model_nodes_adding;
+	data_project_class->nodes_added = brasero_data_tree_model_nodes_added;
 	data_project_class->node_removed = brasero_data_tree_model_node_removed;
 	data_project_class->node_changed = brasero_data_tree_model_node_changed;
 	data_project_class->node_reordered = brasero_data_tree_model_node_reordered;
@@ -233,6 +265,26 @@ brasero_data_tree_model_class_init (BraseroDataTreeModelClass *klass)
 			  2,
 			  G_TYPE_POINTER,
 			  G_TYPE_POINTER);
+	brasero_data_tree_model_signals [ROWS_ADDING] = 
+	    g_signal_new ("rows_adding",
+			  G_TYPE_FROM_CLASS (klass),
+			  G_SIGNAL_RUN_LAST|G_SIGNAL_NO_RECURSE,
+			  0,
+			  NULL, NULL,
+			  g_cclosure_marshal_VOID__POINTER,
+			  G_TYPE_NONE,
+			  1,
+			  G_TYPE_POINTER);
+	brasero_data_tree_model_signals [ROWS_ADDED] = 
+	    g_signal_new ("rows_added",
+			  G_TYPE_FROM_CLASS (klass),
+			  G_SIGNAL_RUN_LAST|G_SIGNAL_NO_RECURSE,
+			  0,
+			  NULL, NULL,
+			  g_cclosure_marshal_VOID__POINTER,
+			  G_TYPE_NONE,
+			  1,
+			  G_TYPE_POINTER);
 }
 
 BraseroDataTreeModel *
@@ -59,6 +59,9 @@ struct _BraseroDataVFSPrivate
 	GHashTable *loading;
 	GHashTable *directories;
 
+	/* Entries of explored directories waiting to be added */
+	GHashTable *pending;
+
 	BraseroFilteredUri *filtered;
 
 	BraseroIOJobBase *load_uri;
@@ -84,6 +87,18 @@ enum {
 
 static gulong brasero_data_vfs_signals [LAST_SIGNAL] = { 0 };
 
+/* Minimum number of entries of a directory added at once. After that the
+ * batches grow with the number of entries already added. */
+#define BRASERO_DATA_VFS_BATCH_MIN	128
+
+struct _BraseroDataVFSPending {
+	GSList *uris;
+	GSList *infos;
+	guint num;
+	guint flushed;
+};
+typedef struct _BraseroDataVFSPending BraseroDataVFSPending;
+
 
 G_DEFINE_TYPE (BraseroDataVFS, brasero_data_vfs, BRASERO_TYPE_DATA_SESSION);
 
@@ -249,6 +264,23 @@ brasero_data_vfs_remove_from_hash (BraseroDataVFS *self,
 	g_hash_table_remove (h_table, uri);
 }
 
+static void
+brasero_data_vfs_pending_free (gpointer data)
+{
+	BraseroDataVFSPending *pending = data;
+
+	g_slist_foreach (pending->uris, (GFunc) g_free, NULL);
+	g_slist_free (pending->uris);
+
+	g_slist_foreach (pending->infos, (GFunc) g_object_unref, NULL);
+	g_slist_free (pending->infos);
+
+	g_free (pending);
+}
+
+static void brasero_data_vfs_directory_flush (BraseroDataVFS *self,
+					      const gchar *parent_uri);
+
 /**
  * Explore and add the contents of a directory already loaded
  */
@@ -264,6 +296,11 @@ brasero_data_vfs_directory_load_end (GObject *object,
 
 	priv = BRASERO_DATA_VFS_PRIVATE (self);
 
+	if (!cancelled)
+		brasero_data_vfs_directory_flush (self, uri);
+
+	g_hash_table_remove (priv->pending, uri);
+
 	nodes = g_hash_table_lookup (priv->directories, uri);
 	for (; nodes; nodes = nodes->next) {
 		BraseroFileNode *parent;
@@ -382,6 +419,113 @@ brasero_data_vfs_directory_check_symlink_loop (BraseroDataVFS *self,
 	return FALSE;
 }
 
+/**
+ * Add the pending entries of a directory to all the nodes exploring it
+ */
+static void
+brasero_data_vfs_directory_flush (BraseroDataVFS *self,
+				  const gchar *parent_uri)
+{
+	BraseroDataVFSPending *pending;
+	BraseroDataVFSPrivate *priv;
+	GSList *infos;
+	GSList *nodes;
+	GSList *uris;
+	GSList *iter;
+
+	priv = BRASERO_DATA_VFS_PRIVATE (self);
+
+	pending = g_hash_table_lookup (priv->pending, parent_uri);
+	if (!pending || !pending->num)
+		return;
+
+	uris = g_slist_reverse (pending->uris);
+	infos = g_slist_reverse (pending->infos);
+	pending->uris = NULL;
+	pending->infos = NULL;
+	pending->flushed += pending->num;
+	pending->num = 0;
+
+	/* add nodes for all parents */
+	nodes = g_hash_table_lookup (priv->directories, parent_uri);
+	for (iter = nodes; iter; iter = iter->next) {
+		BraseroFileNode *parent;
+		GSList *add_infos = NULL;
+		GSList *add_uris = NULL;
+		GSList *iter_info;
+		GSList *iter_uri;
+		guint reference;
+
+		reference = GPOINTER_TO_INT (iter->data);
+		parent = brasero_data_project_reference_get (BRASERO_DATA_PROJECT (self), reference);
+		if (!parent)
+			continue;
+
+		for (iter_uri = uris, iter_info = infos; iter_uri; iter_uri = iter_uri->next, iter_info = iter_info->next) {
+			GFileInfo *info = iter_info->data;
+			gchar *uri = iter_uri->data;
+
+			/* Removed as a symlink loop for a previous parent */
+			if (!uri)
+				continue;
+
+			if (parent->is_root) {
+				/* This may be true in some rare situations (when the root of a
+				 * volume has been added like burn:/// */
+				brasero_data_project_add_loading_node (BRASERO_DATA_PROJECT (self),
+								       uri,
+								       parent);
+				continue;
+			}
+
+			if (g_file_info_get_is_symlink (info)) {
+				if (brasero_data_vfs_directory_check_symlink_loop (self, parent, uri, info)) {
+					brasero_data_project_exclude_uri (BRASERO_DATA_PROJECT (self), uri);
+					if (g_hash_table_lookup (priv->loading, uri))
+						g_signal_emit (self,
+							       brasero_data_vfs_signals [RECURSIVE_SIGNAL],
+							       0,
+							       uri);
+
+					g_free (uri);
+					iter_uri->data = NULL;
+					continue;
+				}
+
+				if (!priv->replace_sym) {
+					/* This is to workaround a small inconsistency
+					 * in GVFS burn:// backend. When there is a
+					 * symlink in burn:// and we are asked not to 
+					 * follow symlinks then the file type is not
+					 * G_FILE_TYPE_SYMBOLIC_LINK */
+					g_file_info_set_file_type (info, G_FILE_TYPE_SYMBOLIC_LINK);
+				}
+			}
+
+			add_uris = g_slist_prepend (add_uris, uri);
+			add_infos = g_slist_prepend (add_infos, info);
+		}
+
+		if (!add_uris)
+			continue;
+
+		add_uris = g_slist_reverse (add_uris);
+		add_infos = g_slist_reverse (add_infos);
+		brasero_data_project_add_nodes_from_info (BRASERO_DATA_PROJECT (self),
+							  parent,
+							  add_uris,
+							  add_infos);
+		g_slist_free (add_uris);
+		g_slist_free (add_infos);
+	}
+
+	g_slist_foreach (uris, (GFunc) g_free, NULL);
+	g_slist_free (uris);
+
+	g_slist_foreach (infos, (GFunc) g_object_unref, NULL);
+	g_slist_free (infos);
+}
+
 static void
 brasero_data_vfs_directory_load_result (GObject *owner,
 					GError *error,
@@ -391,10 +535,9 @@ brasero_data_vfs_directory_load_result (GObject *owner,
 {
 	BraseroDataVFS *self = BRASERO_DATA_VFS (owner);
 	BraseroDataVFSPrivate *priv;
+	BraseroDataVFSPending *pending;
 	gchar *parent_uri = data;
 	const gchar *name;
-	GSList *nodes;
-	GSList *iter;
 
 	priv = BRASERO_DATA_VFS_PRIVATE (self);
 
@@ -432,52 +575,19 @@ brasero_data_vfs_directory_load_result (GObject *owner,
 		}
 	}
 
-	/* add node for all parents */
-	nodes = g_hash_table_lookup (priv->directories, parent_uri);
-	for (iter = nodes; iter; iter = iter->next) {
-		guint reference;
-		BraseroFileNode *parent;
-
-		reference = GPOINTER_TO_INT (iter->data);
-		parent = brasero_data_project_reference_get (BRASERO_DATA_PROJECT (self), reference);
-		if (!parent)
-			continue;
-
-		if (parent->is_root) {
-			/* This may be true in some rare situations (when the root of a
-			 * volume has been added like burn:/// */
-			brasero_data_project_add_loading_node (BRASERO_DATA_PROJECT (self),
-							       uri,
-							       parent);
-			 continue;
-		}
-
-		if (g_file_info_get_is_symlink (info)) {
-			if (brasero_data_vfs_directory_check_symlink_loop (self, parent, uri, info)) {
-				brasero_data_project_exclude_uri (BRASERO_DATA_PROJECT (self), uri);
-				if (g_hash_table_lookup (priv->loading, uri))
-					g_signal_emit (self,
-						       brasero_data_vfs_signals [RECURSIVE_SIGNAL],
-						       0,
-						       uri);
-				return;
-			}
+	/* Entries are added in batches to the tree */
+	pending = g_hash_table_lookup (priv->pending, parent_uri);
+	if (!pending) {
+		pending = g_new0 (BraseroDataVFSPending, 1);
+		g_hash_table_insert (priv->pending, parent_uri, pending);
+	}
 
-			if (!priv->replace_sym) {
-				/* This is to workaround a small inconsistency
-				 * in GVFS burn:// backend. When there is a
-				 * symlink in burn:// and we are asked not to 
-				 * follow symlinks then the file type is not
-				 * G_FILE_TYPE_SYMBOLIC_LINK */
-				g_file_info_set_file_type (info, G_FILE_TYPE_SYMBOLIC_LINK);
-			}
-		}
+	pending->uris = g_slist_prepend (pending->uris, g_strdup (uri));
+	pending->infos = g_slist_prepend (pending->infos, g_object_ref (info));
+	pending->num ++;
 
-		brasero_data_project_add_node_from_info (BRASERO_DATA_PROJECT (self),
-							 uri,
-							 info,
-							 parent);
-	}
+	if (pending->num >= MAX (BRASERO_DATA_VFS_BATCH_MIN, pending->flushed))
+		brasero_data_vfs_directory_flush (self, parent_uri);
 }
 
 static gboolean
@@ -975,6 +1085,9 @@ brasero_data_vfs_clear (BraseroDataVFS *self)
 
 	priv = BRASERO_DATA_VFS_PRIVATE (self);
 
+	/* Drop the entries not added yet */
+	g_hash_table_remove_all (priv->pending);
+
 	/* Stop all VFS operations */
 	if (priv->load_uri) {
 		brasero_io_cancel_by_base (priv->load_uri);
@@ -1063,6 +1176,10 @@ brasero_data_vfs_init (BraseroDataVFS *object)
 	/* create the hash tables */
 	priv->loading = g_hash_table_new (g_str_hash, g_str_equal);
 	priv->directories = g_hash_table_new (g_str_hash, g_str_equal);
+	priv->pending = g_hash_table_new_full (g_str_hash,
+					       g_str_equal,
+					       NULL,
+					       brasero_data_vfs_pending_free);
 }
 
 static void
@@ -1084,6 +1201,11 @@ brasero_data_vfs_finalize (GObject *object)
 		priv->directories = NULL;
 	}
 
+	if (priv->pending) {
+		g_hash_table_destroy (priv->pending);
+		priv->pending = NULL;
+	}
+
 	if (priv->filtered) {
 		g_object_unref (priv->filtered);
 		priv->filtered = NULL;
@@ -43,6 +43,390 @@
 #include "brasero-file-node.h"
 #include "brasero-io.h"
 
+/* Number of children a directory must have before we start indexing its
+ * children (names and positions) rather than walking the list of children
+ * each time. */
+#define BRASERO_FILE_NODE_INDEX_THRESHOLD	64
+
+/* Number of nodes per arena block and size of the blocks for names */
+#define BRASERO_FILE_NODE_ARENA_NODES		1024
+#define BRASERO_FILE_NODE_ARENA_NAMES		65536
+
+/**
+ * Nodes are allocated by blocks; destroyed nodes are kept in a list to be
+ * reused. Names are packed in big blocks and are only released when the
+ * whole arena is (that is when the tree is destroyed).
+ */
+
+struct _BraseroFileNodeArena {
+	GSList *node_blocks;
+	guint node_blocks_used;
+	BraseroFileNode *free_nodes;
+
+	GSList *name_blocks;
+	gsize name_blocks_used;
+
+	gsize size;
+};
+
+struct _BraseroFileNodeIndex {
+	/* name (owned by the child) -> child */
+	GHashTable *names;
+
+	/* Number of children whose name was already in the table. As long
+	 * as it is not 0 the table can't be trusted to return the first
+	 * child in the list with a given name. */
+	guint collisions;
+
+	/* Children in list order. When the list is modified, the array is
+	 * truncated at the position of the change and is completed again
+	 * the next time it is needed. */
+	GPtrArray *children;
+
+	/* child -> position in children + 1 */
+	GHashTable *positions;
+
+	/* sorted positions of hidden children in children */
+	GArray *hidden;
+
+	guint complete:1;
+};
+
+static void
+brasero_file_node_index_add_name (BraseroFileNode *parent,
+				  BraseroFileNode *child)
+{
+	BraseroFileNodeIndex *index;
+	const gchar *name;
+
+	index = parent->index;
+	if (!index || !index->names)
+		return;
+
+	name = BRASERO_FILE_NODE_NAME (child);
+	if (g_hash_table_lookup (index->names, name))
+		index->collisions ++;
+	else
+		g_hash_table_insert (index->names, (gpointer) name, child);
+}
+
+static void
+brasero_file_node_index_free (BraseroFileNode *node)
+{
+	BraseroFileNodeIndex *index;
+
+	index = node->index;
+	if (!index)
+		return;
+
+	if (index->names)
+		g_hash_table_destroy (index->names);
+
+	if (index->children) {
+		g_ptr_array_free (index->children, TRUE);
+		g_hash_table_destroy (index->positions);
+		g_array_free (index->hidden, TRUE);
+	}
+
+	g_free (index);
+	node->index = NULL;
+}
+
+static void
+brasero_file_node_index_remove_name (BraseroFileNode *parent,
+				     BraseroFileNode *child)
+{
+	BraseroFileNodeIndex *index;
+	BraseroFileNode *indexed;
+	const gchar *name;
+
+	index = parent->index;
+	if (!index || !index->names)
+		return;
+
+	name = BRASERO_FILE_NODE_NAME (child);
+	indexed = g_hash_table_lookup (index->names, name);
+	if (indexed == child) {
+		if (index->collisions) {
+			/* Another child has the same name and we don't know
+			 * which one it is; it'll be rebuilt when needed. */
+			g_hash_table_destroy (index->names);
+			index->names = NULL;
+			index->collisions = 0;
+			return;
+		}
+
+		g_hash_table_remove (index->names, name);
+	}
+	else if (indexed && index->collisions)
+		index->collisions --;
+}
+
+static void
+brasero_file_node_index_build_names (BraseroFileNode *parent)
+{
+	BraseroFileNode *iter;
+
+	if (!parent->index)
+		parent->index = g_new0 (BraseroFileNodeIndex, 1);
+
+	parent->index->names = g_hash_table_new (g_str_hash, g_str_equal);
+	parent->index->collisions = 0;
+
+	for (iter = BRASERO_FILE_NODE_CHILDREN (parent); iter; iter = iter->next)
+		brasero_file_node_index_add_name (parent, iter);
+}
+
+/**
+ * Indexes the children not indexed yet. If until is not NULL, it stops once
+ * until was indexed so that children added one after the other in sorted
+ * order only cost the positions between them.
+ */
+
+static void
+brasero_file_node_index_complete (BraseroFileNode *parent,
+				  const BraseroFileNode *until)
+{
+	BraseroFileNodeIndex *index;
+	BraseroFileNode *iter;
+
+	index = parent->index;
+	if (index->complete)
+		return;
+
+	/* Start from the last child whose position is still valid */
+	if (index->children->len)
+		iter = g_ptr_array_index (index->children, index->children->len - 1);
+	else
+		iter = NULL;
+
+	iter = iter? iter->next:BRASERO_FILE_NODE_CHILDREN (parent);
+	for (; iter; iter = iter->next) {
+		guint pos;
+
+		pos = index->children->len;
+		if (iter->is_hidden)
+			g_array_append_val (index->hidden, pos);
+
+		g_hash_table_insert (index->positions, iter, GUINT_TO_POINTER (pos + 1));
+		g_ptr_array_add (index->children, iter);
+
+		if (iter == until)
+			return;
+	}
+
+	index->complete = TRUE;
+}
+
+static void
+brasero_file_node_index_build_positions (BraseroFileNode *parent)
+{
+	BraseroFileNodeIndex *index;
+
+	if (!parent->index)
+		parent->index = g_new0 (BraseroFileNodeIndex, 1);
+
+	index = parent->index;
+	index->children = g_ptr_array_new ();
+	index->positions = g_hash_table_new (g_direct_hash, g_direct_equal);
+	index->hidden = g_array_new (FALSE, FALSE, sizeof (guint));
+	index->complete = FALSE;
+
+	brasero_file_node_index_complete (parent, NULL);
+}
+
+/**
+ * Called whenever the children list of parent changed from position pos.
+ * Positions before pos are still valid.
+ */
+
+static void
+brasero_file_node_index_invalidate (BraseroFileNode *parent,
+				    guint pos)
+{
+	BraseroFileNodeIndex *index;
+	guint i;
+
+	index = parent->index;
+	if (!index || !index->children)
+		return;
+
+	index->complete = FALSE;
+	if (pos >= index->children->len)
+		return;
+
+	for (i = pos; i < index->children->len; i ++)
+		g_hash_table_remove (index->positions, g_ptr_array_index (index->children, i));
+
+	g_ptr_array_set_size (index->children, pos);
+
+	while (index->hidden->len
+	&&     g_array_index (index->hidden, guint, index->hidden->len - 1) >= pos)
+		g_array_set_size (index->hidden, index->hidden->len - 1);
+}
+
+static BraseroFileNodeIndex *
+brasero_file_node_index_get_positions (const BraseroFileNode *parent)
+{
+	/* NOTE: parent is only const for the callers; the index is a cache */
+	if (!parent->index || !parent->index->children)
+		return NULL;
+
+	brasero_file_node_index_complete ((BraseroFileNode *) parent, NULL);
+	return parent->index;
+}
+
+/* Returns the position of node in the index + 1 or 0 if it isn't a child */
+static guint
+brasero_file_node_index_lookup (const BraseroFileNode *parent,
+				const BraseroFileNode *node)
+{
+	BraseroFileNodeIndex *index;
+	guint pos;
+
+	index = parent->index;
+	pos = GPOINTER_TO_UINT (g_hash_table_lookup (index->positions, node));
+	if (pos || index->complete)
+		return pos;
+
+	brasero_file_node_index_complete ((BraseroFileNode *) parent, node);
+	return GPOINTER_TO_UINT (g_hash_table_lookup (index->positions, node));
+}
+
+/* Returns the number of hidden children before position pos */
+static guint
+brasero_file_node_index_hidden_before (BraseroFileNodeIndex *index,
+				       guint pos)
+{
+	guint low = 0;
+	guint high;
+
+	high = index->hidden->len;
+	while (low < high) {
+		guint middle;
+
+		middle = (low + high) / 2;
+		if (g_array_index (index->hidden, guint, middle) < pos)
+			low = middle + 1;
+		else
+			high = middle;
+	}
+
+	return low;
+}
+
+static BraseroFileNodeArena *
+brasero_file_node_arena_new (void)
+{
+	return g_new0 (BraseroFileNodeArena, 1);
+}
+
+static void
+brasero_file_node_arena_free (BraseroFileNodeArena *arena)
+{
+	g_slist_foreach (arena->node_blocks, (GFunc) g_free, NULL);
+	g_slist_free (arena->node_blocks);
+
+	g_slist_foreach (arena->name_blocks, (GFunc) g_free, NULL);
+	g_slist_free (arena->name_blocks);
+
+	g_free (arena);
+}
+
+/**
+ * Returns the memory used by the nodes and names of a tree in bytes.
+ */
+
+gsize
+brasero_file_node_arena_get_size (BraseroFileNodeArena *arena)
+{
+	return arena->size;
+}
+
+static BraseroFileNode *
+brasero_file_node_arena_alloc (BraseroFileNodeArena *arena)
+{
+	BraseroFileNode *node;
+
+	if (!arena)
+		return g_new0 (BraseroFileNode, 1);
+
+	if (arena->free_nodes) {
+		node = arena->free_nodes;
+		arena->free_nodes = node->next;
+		memset (node, 0, sizeof (BraseroFileNode));
+	}
+	else {
+		if (!arena->node_blocks
+		||   arena->node_blocks_used >= BRASERO_FILE_NODE_ARENA_NODES) {
+			arena->node_blocks = g_slist_prepend (arena->node_blocks, g_new0 (BraseroFileNode, BRASERO_FILE_NODE_ARENA_NODES));
+			arena->node_blocks_used = 0;
+			arena->size += sizeof (BraseroFileNode) * BRASERO_FILE_NODE_ARENA_NODES;
+		}
+
+		node = ((BraseroFileNode *) arena->node_blocks->data) + arena->node_blocks_used;
+		arena->node_blocks_used ++;
+	}
+
+	node->is_arena = TRUE;
+	return node;
+}
+
+static void
+brasero_file_node_arena_release (BraseroFileNodeArena *arena,
+				 BraseroFileNode *node)
+{
+	if (!node->is_arena) {
+		g_free (node);
+		return;
+	}
+
+	/* No arena given: the whole tree is being destroyed and the node will
+	 * be released with its arena */
+	if (!arena)
+		return;
+
+	node->next = arena->free_nodes;
+	arena->free_nodes = node;
+}
+
+static void
+brasero_file_node_set_name (BraseroFileNodeArena *arena,
+			    BraseroFileNode *node,
+			    const gchar *name)
+{
+	gchar *copy;
+	gsize len;
+
+	if (!arena) {
+		node->union1.name = g_strdup (name);
+		return;
+	}
+
+	len = strlen (name) + 1;
+	if (len > BRASERO_FILE_NODE_ARENA_NAMES) {
+		/* That one gets a block of its own */
+		copy = g_malloc (len);
+		arena->name_blocks = g_slist_prepend (arena->name_blocks, copy);
+		arena->name_blocks_used = BRASERO_FILE_NODE_ARENA_NAMES;
+		arena->size += len;
+	}
+	else {
+		if (!arena->name_blocks
+		||   arena->name_blocks_used + len > BRASERO_FILE_NODE_ARENA_NAMES) {
+			arena->name_blocks = g_slist_prepend (arena->name_blocks, g_malloc (BRASERO_FILE_NODE_ARENA_NAMES));
+			arena->name_blocks_used = 0;
+			arena->size += BRASERO_FILE_NODE_ARENA_NAMES;
+		}
+
+		copy = ((gchar *) arena->name_blocks->data) + arena->name_blocks_used;
+		arena->name_blocks_used += len;
+	}
+
+	memcpy (copy, name, len);
+	node->union1.name = copy;
+	node->is_arena_name = TRUE;
+}
 
 BraseroFileNode *
 brasero_file_node_root_new (void)
@@ -54,6 +438,7 @@ brasero_file_node_root_new (void)
 	root->is_imported = TRUE;
 
 	root->union3.stats = g_new0 (BraseroFileTreeStats, 1);
+	root->union3.stats->arena = brasero_file_node_arena_new ();
 	return root;
 }
 
@@ -299,6 +684,7 @@ brasero_file_node_need_resort (BraseroFileNode *node,
 
 		head = brasero_file_node_insert (head, node, sort_func, &newpos);
 		parent->union2.children = head;
+		brasero_file_node_index_invalidate (parent, newpos);
 
 		/* create an array to reflect the changes */
 		/* NOTE: hidden nodes are not taken into account. */
@@ -332,6 +718,7 @@ brasero_file_node_need_resort (BraseroFileNode *node,
 
 		/* we started from oldpos so newpos needs updating */
 		newpos += oldpos;
+		brasero_file_node_index_invalidate (parent, oldpos);
 
 		/* create an array to reflect the changes. */
 		/* NOTE: hidden nodes are not taken into account. */
@@ -401,6 +788,7 @@ brasero_file_node_sort_children (BraseroFileNode *parent,
 
 	/* set the new order */
 	parent->union2.children = new_order;
+	brasero_file_node_index_invalidate (parent, 0);
 
 	return array;
 }
@@ -480,6 +868,7 @@ brasero_file_node_reverse_children (BraseroFileNode *parent)
 
 end:
 
+	brasero_file_node_index_invalidate (parent, 0);
 	array = g_new (gint, size);
 
 	for (i = 0; i < firstfile; i ++)
@@ -495,54 +884,181 @@ BraseroFileNode *
 brasero_file_node_nth_child (BraseroFileNode *parent,
 			     guint nth)
 {
+	BraseroFileNodeIndex *index;
 	BraseroFileNode *peers;
 	guint pos;
 
 	if (!parent)
 		return NULL;
 
+	index = brasero_file_node_index_get_positions (parent);
+	if (index) {
+		if (nth >= index->children->len)
+			return NULL;
+
+		return g_ptr_array_index (index->children, nth);
+	}
+
 	peers = BRASERO_FILE_NODE_CHILDREN (parent);
 	for (pos = 0; pos < nth && peers; pos ++)
 		peers = peers->next;
 
+	if (pos >= BRASERO_FILE_NODE_INDEX_THRESHOLD)
+		brasero_file_node_index_build_positions (parent);
+
 	return peers;
 }
 
+BraseroFileNode *
+brasero_file_node_nth_visible_child (BraseroFileNode *parent,
+				     guint nth)
+{
+	BraseroFileNodeIndex *index;
+	BraseroFileNode *peers;
+	guint pos;
+	guint i;
+
+	if (!parent)
+		return NULL;
+
+	index = brasero_file_node_index_get_positions (parent);
+	if (index) {
+		if (nth >= index->children->len - index->hidden->len)
+			return NULL;
+
+		/* Skip hidden */
+		pos = nth;
+		for (i = 0; i < index->hidden->len; i ++) {
+			if (g_array_index (index->hidden, guint, i) > pos)
+				break;
+			pos ++;
+		}
+
+		return g_ptr_array_index (index->children, pos);
+	}
+
+	peers = BRASERO_FILE_NODE_CHILDREN (parent);
+	while (peers && peers->is_hidden)
+		peers = peers->next;
+
+	for (pos = 0; pos < nth && peers; pos ++) {
+		peers = peers->next;
+
+		/* Skip hidden */
+		while (peers && peers->is_hidden)
+			peers = peers->next;
+	}
+
+	if (pos >= BRASERO_FILE_NODE_INDEX_THRESHOLD)
+		brasero_file_node_index_build_positions (parent);
+
+	return peers;
+}
+
+/**
+ * NOTE: hidden nodes are not counted
+ */
+
 guint
 brasero_file_node_get_n_children (const BraseroFileNode *node)
 {
+	BraseroFileNodeIndex *index;
 	BraseroFileNode *children;
+	guint total = 0;
 	guint num = 0;
 
 	if (!node)
 		return 0;
 
+	index = brasero_file_node_index_get_positions (node);
+	if (index)
+		return index->children->len - index->hidden->len;
+
 	for (children = BRASERO_FILE_NODE_CHILDREN (node); children; children = children->next) {
+		total ++;
 		if (children->is_hidden)
 			continue;
 		num ++;
 	}
 
+	if (total >= BRASERO_FILE_NODE_INDEX_THRESHOLD)
+		brasero_file_node_index_build_positions ((BraseroFileNode *) node);
+
 	return num;
 }
 
 guint
 brasero_file_node_get_pos_as_child (BraseroFileNode *node)
 {
+	BraseroFileNodeIndex *index;
 	BraseroFileNode *parent;
 	BraseroFileNode *peers;
 	guint pos = 0;
 
-	if (!node)
+	if (!node || !node->parent)
+		return 0;
+
+	parent = node->parent;
+	index = parent->index;
+	if (index && index->children) {
+		pos = brasero_file_node_index_lookup (parent, node);
+		if (!pos)
+			return index->children->len;
+
+		return pos - 1;
+	}
+
+	for (peers = BRASERO_FILE_NODE_CHILDREN (parent); peers; peers = peers->next) {
+		if (peers == node)
+			break;
+		pos ++;
+	}
+
+	if (pos >= BRASERO_FILE_NODE_INDEX_THRESHOLD)
+		brasero_file_node_index_build_positions (parent);
+
+	return pos;
+}
+
+/**
+ * Same as above but hidden nodes are not taken into account
+ */
+
+guint
+brasero_file_node_get_visible_pos_as_child (BraseroFileNode *node)
+{
+	BraseroFileNodeIndex *index;
+	BraseroFileNode *parent;
+	BraseroFileNode *peers;
+	guint total = 0;
+	guint pos = 0;
+
+	if (!node || !node->parent)
 		return 0;
 
 	parent = node->parent;
+	index = parent->index;
+	if (index && index->children) {
+		pos = brasero_file_node_get_pos_as_child (node);
+		return pos - brasero_file_node_index_hidden_before (index, pos);
+	}
+
 	for (peers = BRASERO_FILE_NODE_CHILDREN (parent); peers; peers = peers->next) {
 		if (peers == node)
 			break;
+
+		total ++;
+
+		/* Don't increment when is_hidden */
+		if (peers->is_hidden)
+			continue;
+
 		pos ++;
 	}
 
+	if (total >= BRASERO_FILE_NODE_INDEX_THRESHOLD)
+		brasero_file_node_index_build_positions (parent);
+
 	return pos;
 }
 
@@ -582,17 +1098,28 @@ brasero_file_node_check_name_existence (BraseroFileNode *parent,
 				        const gchar *name)
 {
 	BraseroFileNode *iter;
+	gboolean indexed;
+	guint num = 0;
 
 	if (name && name [0] == '\0')
 		return NULL;
 
+	indexed = (parent->index && parent->index->names);
+	if (indexed && !parent->index->collisions)
+		return g_hash_table_lookup (parent->index->names, name);
+
 	iter = BRASERO_FILE_NODE_CHILDREN (parent);
 	for (; iter; iter = iter->next) {
 		if (!strcmp (name, BRASERO_FILE_NODE_NAME (iter)))
-			return iter;
+			break;
+		num ++;
 	}
 
-	return NULL;
+	/* That directory is big enough to deserve an index */
+	if (!indexed && num >= BRASERO_FILE_NODE_INDEX_THRESHOLD)
+		brasero_file_node_index_build_names (parent);
+
+	return iter;
 }
 
 BraseroFileNode *
@@ -675,6 +1202,46 @@ brasero_file_node_check_imported_sibling (BraseroFileNode *node)
 	return NULL;
 }
 
+static void
+brasero_file_node_sizes_changed (BraseroFileNode *node)
+{
+	BraseroFileNode *root;
+
+	root = brasero_file_node_get_root (node, NULL);
+	if (root)
+		BRASERO_FILE_NODE_STATS (root)->changes ++;
+}
+
+static void
+brasero_file_node_add_total (BraseroFileNode *parent,
+			     gint64 sectors)
+{
+	BraseroFileNode *root = NULL;
+
+	for (; parent; parent = parent->parent) {
+		parent->total_sectors += sectors;
+		root = parent;
+	}
+
+	if (root && root->is_root)
+		BRASERO_FILE_NODE_STATS (root)->changes ++;
+}
+
+/**
+ * To be called after the size, the type or the imported status of a node in
+ * the tree changed; old_total is BRASERO_FILE_NODE_TOTAL_SECTORS () before.
+ */
+void
+brasero_file_node_total_changed (BraseroFileNode *node,
+				 guint64 old_total)
+{
+	gint64 diff;
+
+	diff = (gint64) BRASERO_FILE_NODE_TOTAL_SECTORS (node) - (gint64) old_total;
+	if (diff)
+		brasero_file_node_add_total (node->parent, diff);
+}
+
 void
 brasero_file_node_graft (BraseroFileNode *file_node,
 			 BraseroURINode *uri_node)
@@ -711,6 +1278,8 @@ brasero_file_node_graft (BraseroFileNode *file_node,
 
 	graft->node = uri_node;
 	uri_node->nodes = g_slist_prepend (uri_node->nodes, file_node);
+
+	brasero_file_node_sizes_changed (file_node);
 }
 
 void
@@ -741,32 +1310,44 @@ brasero_file_node_ungraft (BraseroFileNode *node)
 		if (parent->is_grafted)
 			break;
 	}
+
+	brasero_file_node_sizes_changed (node);
 }
 
 void
 brasero_file_node_rename (BraseroFileNode *node,
 			  const gchar *name)
 {
-	g_free (BRASERO_FILE_NODE_NAME (node));
+	/* The index uses the name as key so it must be updated */
+	if (node->parent)
+		brasero_file_node_index_remove_name (node->parent, node);
+
+	/* Names in the arena are released with it */
+	if (!node->is_arena_name)
+		g_free (BRASERO_FILE_NODE_NAME (node));
+
+	node->is_arena_name = FALSE;
 	if (node->is_grafted)
 		node->union1.graft->name = g_strdup (name);
 	else
 		node->union1.name = g_strdup (name);
+
+	if (node->parent)
+		brasero_file_node_index_add_name (node->parent, node);
 }
 
-void
-brasero_file_node_add (BraseroFileNode *parent,
-		       BraseroFileNode *node,
-		       GCompareFunc sort_func)
+/**
+ * Updates sizes and statistics once node was linked to parent
+ */
+
+static void
+brasero_file_node_added (BraseroFileNode *parent,
+			 BraseroFileNode *node)
 {
 	BraseroFileTreeStats *stats;
 	guint depth = 0;
 
-	parent->union2.children = brasero_file_node_insert (BRASERO_FILE_NODE_CHILDREN (parent),
-							    node,
-							    sort_func,
-							    NULL);
-	node->parent = parent;
+	brasero_file_node_add_total (parent, BRASERO_FILE_NODE_TOTAL_SECTORS (node));
 
 	if (BRASERO_FILE_NODE_VIRTUAL (node))
 		return;
@@ -803,16 +1384,92 @@ brasero_file_node_add (BraseroFileNode *parent,
 	node->is_deep = TRUE;
 }
 
+void
+brasero_file_node_add (BraseroFileNode *parent,
+		       BraseroFileNode *node,
+		       GCompareFunc sort_func)
+{
+	guint newpos = 0;
+
+	parent->union2.children = brasero_file_node_insert (BRASERO_FILE_NODE_CHILDREN (parent),
+							    node,
+							    sort_func,
+							    &newpos);
+	node->parent = parent;
+	brasero_file_node_index_add_name (parent, node);
+	brasero_file_node_index_invalidate (parent, newpos);
+	brasero_file_node_added (parent, node);
+}
+
+/**
+ * Adds several nodes to parent: nodes must be sorted with sort_func
+ * (g_slist_sort () keeps the order of equal nodes as successive calls to
+ * brasero_file_node_add () would) so that they can be merged with the
+ * children in a single pass. nodes must not be hidden.
+ * Nodes are linked one after the other; func is called for each node once
+ * it is in the tree and before the next one is linked.
+ */
+
+void
+brasero_file_node_add_list (BraseroFileNode *parent,
+			    GSList *nodes,
+			    GCompareFunc sort_func,
+			    GFunc func,
+			    gpointer user_data)
+{
+	BraseroFileNode *child;
+	BraseroFileNode *last = NULL;
+	guint pos = 0;
+	GSList *iter;
+
+	child = BRASERO_FILE_NODE_CHILDREN (parent);
+	for (iter = nodes; iter; iter = iter->next) {
+		BraseroFileNode *node;
+
+		node = iter->data;
+
+		/* Hidden nodes are always last */
+		while (child && !child->is_hidden && sort_func (child, node) <= 0) {
+			last = child;
+			child = child->next;
+			pos ++;
+		}
+
+		node->next = child;
+		if (last)
+			last->next = node;
+		else
+			parent->union2.children = node;
+
+		node->parent = parent;
+		brasero_file_node_index_add_name (parent, node);
+		brasero_file_node_index_invalidate (parent, pos);
+		brasero_file_node_added (parent, node);
+
+		if (func)
+			func (node, user_data);
+
+		/* The children after node may have changed in func */
+		last = node;
+		child = node->next;
+		pos ++;
+	}
+}
+
 void
 brasero_file_node_set_from_info (BraseroFileNode *node,
 				 BraseroFileTreeStats *stats,
 				 GFileInfo *info)
 {
+	guint64 old_total;
+
 	/* NOTE: the name will never be replaced here since that means
 	 * we could replace a previously set name (that triggered the
 	 * creation of a graft). If someone wants to set a new name,
 	 * then rename_node is the function. */
 
+	old_total = BRASERO_FILE_NODE_TOTAL_SECTORS (node);
+
 	if (node->parent) {
 		/* update the stats since a file could have been added to the tree but
 		 * at this point we didn't know what it was (a file or a directory).
@@ -846,6 +1503,7 @@ brasero_file_node_set_from_info (BraseroFileNode *node,
 	node->is_symlink = (g_file_info_get_file_type (info) == G_FILE_TYPE_SYMBOLIC_LINK);
 
 	if (node->is_file) {
+		BraseroFileNode *iter;
 		guint sectors;
 		gint sectors_diff;
 
@@ -871,36 +1529,45 @@ brasero_file_node_set_from_info (BraseroFileNode *node,
 			stats->num_2GiB --;
 		}
 
+		/* In case it was a directory before */
+		brasero_file_node_index_free (node);
+		node->total_sectors = 0;
+
 		/* The node isn't grafted and it's a file. So we must propagate
 		 * its size up to the parent graft node. */
 		/* NOTE: we used to accumulate all the directory contents till
 		 * the end and process all of entries at once, when it was
 		 * finished. We had to do that to calculate the whole size. */
 		sectors_diff = sectors - BRASERO_FILE_NODE_SECTORS (node);
-		for (; node; node = node->parent) {
-			node->union3.sectors += sectors_diff;
-			if (node->is_grafted)
+		for (iter = node; iter; iter = iter->parent) {
+			iter->union3.sectors += sectors_diff;
+			if (iter->is_grafted)
 				break;
 		}
 	}
 	else	/* since that's directory then it must be explored now */
 		node->is_exploring = TRUE;
+
+	if (node->parent)
+		brasero_file_node_total_changed (node, old_total);
 }
 
 BraseroFileNode *
-brasero_file_node_new_loading (const gchar *name)
+brasero_file_node_new_loading (BraseroFileNodeArena *arena,
+			       const gchar *name)
 {
 	BraseroFileNode *node;
 
-	node = g_new0 (BraseroFileNode, 1);
-	node->union1.name = g_strdup (name);
+	node = brasero_file_node_arena_alloc (arena);
+	brasero_file_node_set_name (arena, node, name);
 	node->is_loading = TRUE;
 
 	return node;
 }
 
 BraseroFileNode *
-brasero_file_node_new_virtual (const gchar *name)
+brasero_file_node_new_virtual (BraseroFileNodeArena *arena,
+			       const gchar *name)
 {
 	BraseroFileNode *node;
 
@@ -908,8 +1575,8 @@ brasero_file_node_new_virtual (const gchar *name)
 	 * parents (and therefore replacable) and hidden (not displayed in the
 	 * GtkTreeModel). They are used as 'placeholders' to trigger
 	 * name-collision signal. */
-	node = g_new0 (BraseroFileNode, 1);
-	node->union1.name = g_strdup (name);
+	node = brasero_file_node_arena_alloc (arena);
+	brasero_file_node_set_name (arena, node, name);
 	node->is_fake = TRUE;
 	node->is_hidden = TRUE;
 
@@ -917,24 +1584,26 @@ brasero_file_node_new_virtual (const gchar *name)
 }
 
 BraseroFileNode *
-brasero_file_node_new (const gchar *name)
+brasero_file_node_new (BraseroFileNodeArena *arena,
+		       const gchar *name)
 {
 	BraseroFileNode *node;
 
-	node = g_new0 (BraseroFileNode, 1);
-	node->union1.name = g_strdup (name);
+	node = brasero_file_node_arena_alloc (arena);
+	brasero_file_node_set_name (arena, node, name);
 
 	return node;
 }
 
 BraseroFileNode *
-brasero_file_node_new_imported_session_file (GFileInfo *info)
+brasero_file_node_new_imported_session_file (BraseroFileNodeArena *arena,
+					     GFileInfo *info)
 {
 	BraseroFileNode *node;
 
 	/* Create the node information */
-	node = g_new0 (BraseroFileNode, 1);
-	node->union1.name = g_strdup (g_file_info_get_name (info));
+	node = brasero_file_node_arena_alloc (arena);
+	brasero_file_node_set_name (arena, node, g_file_info_get_name (info));
 	node->is_file = (g_file_info_get_file_type (info) != G_FILE_TYPE_DIRECTORY);
 	node->is_imported = TRUE;
 
@@ -949,13 +1618,14 @@ brasero_file_node_new_imported_session_file (GFileInfo *info)
 }
 
 BraseroFileNode *
-brasero_file_node_new_empty_folder (const gchar *name)
+brasero_file_node_new_empty_folder (BraseroFileNodeArena *arena,
+				    const gchar *name)
 {
 	BraseroFileNode *node;
 
 	/* Create the node information */
-	node = g_new0 (BraseroFileNode, 1);
-	node->union1.name = g_strdup (name);
+	node = brasero_file_node_arena_alloc (arena);
+	brasero_file_node_set_name (arena, node, name);
 	node->is_fake = TRUE;
 
 	return node;
@@ -966,11 +1636,13 @@ brasero_file_node_unlink (BraseroFileNode *node)
 {
 	BraseroFileNode *iter;
 	BraseroImport *import;
+	guint pos;
 
 	if (!node->parent)
 		return;
 
 	iter = BRASERO_FILE_NODE_CHILDREN (node->parent);
+	brasero_file_node_add_total (node->parent, - (gint64) BRASERO_FILE_NODE_TOTAL_SECTORS (node));
 
 	/* handle the size change for previous parent */
 	if (!node->is_grafted
@@ -989,14 +1661,18 @@ brasero_file_node_unlink (BraseroFileNode *node)
 	node->is_deep = FALSE;
 
 	if (iter == node) {
+		brasero_file_node_index_remove_name (node->parent, node);
+		brasero_file_node_index_invalidate (node->parent, 0);
 		node->parent->union2.children = node->next;
 		node->parent = NULL;
 		node->next = NULL;
 		return;
 	}
 
-	for (; iter->next; iter = iter->next) {
+	for (pos = 1; iter->next; iter = iter->next, pos ++) {
 		if (iter->next == node) {
+			brasero_file_node_index_remove_name (node->parent, node);
+			brasero_file_node_index_invalidate (node->parent, pos);
 			iter->next = node->next;
 			node->parent = NULL;
 			node->next = NULL;
@@ -1050,6 +1726,7 @@ brasero_file_node_move_to (BraseroFileNode *node,
 			   GCompareFunc sort_func)
 {
 	BraseroFileTreeStats *stats;
+	guint newpos = 0;
 	guint depth = 0;
 
 	/* NOTE: for the time being no backend supports moving imported files */
@@ -1060,8 +1737,11 @@ brasero_file_node_move_to (BraseroFileNode *node,
 	parent->union2.children = brasero_file_node_insert (BRASERO_FILE_NODE_CHILDREN (parent),
 							    node,
 							    sort_func,
-							    NULL);
+							    &newpos);
 	node->parent = parent;
+	brasero_file_node_index_add_name (parent, node);
+	brasero_file_node_index_invalidate (parent, newpos);
+	brasero_file_node_add_total (parent, BRASERO_FILE_NODE_TOTAL_SECTORS (node));
 
 	if (!node->is_grafted) {
 		BraseroFileNode *parent;
@@ -1096,6 +1776,7 @@ brasero_file_node_destroy_with_children (BraseroFileNode *node,
 	BraseroFileNode *next;
 	BraseroImport *import;
 	BraseroGraft *graft;
+	gboolean free_name;
 
 	/* destroy all children recursively */
 	for (child = BRASERO_FILE_NODE_CHILDREN (node); child; child = next) {
@@ -1127,6 +1808,7 @@ brasero_file_node_destroy_with_children (BraseroFileNode *node,
 	}
 
 	/* destruction */
+	free_name = !node->is_arena_name;
 	import = BRASERO_FILE_NODE_IMPORT (node);
 	graft = BRASERO_FILE_NODE_GRAFT (node);
 	if (graft) {
@@ -1138,7 +1820,8 @@ brasero_file_node_destroy_with_children (BraseroFileNode *node,
 		if (uri_node)
 			uri_node->nodes = g_slist_remove (uri_node->nodes, node);
 
-		g_free (graft->name);
+		if (free_name)
+			g_free (graft->name);
 		g_free (graft);
 	}
 	else if (import) {
@@ -1148,20 +1831,27 @@ brasero_file_node_destroy_with_children (BraseroFileNode *node,
 			brasero_file_node_destroy_with_children (child, stats);
 		}
 
-		g_free (import->name);
+		if (free_name)
+			g_free (import->name);
 		g_free (import);
 	}
-	else
+	else if (free_name)
 		g_free (BRASERO_FILE_NODE_NAME (node));
 
 	/* destroy the node */
 	if (node->is_file && !node->is_imported && BRASERO_FILE_NODE_MIME (node))
 		brasero_utils_unregister_string (BRASERO_FILE_NODE_MIME (node));
 
-	if (node->is_root)
-		g_free (BRASERO_FILE_NODE_STATS (node));
+	brasero_file_node_index_free (node);
 
-	g_free (node);
+	if (node->is_root) {
+		/* All the nodes below are released at once */
+		brasero_file_node_arena_free (BRASERO_FILE_NODE_ARENA (node));
+		g_free (BRASERO_FILE_NODE_STATS (node));
+		g_free (node);
+	}
+	else
+		brasero_file_node_arena_release (stats? stats->arena:NULL, node);
 }
 
 /**
@@ -1193,25 +1883,47 @@ brasero_file_node_save_imported_children (BraseroFileNode *node,
 					  BraseroFileTreeStats *stats,
 					  GCompareFunc sort_func)
 {
+	BraseroFileNode *prev = NULL;
 	BraseroFileNode *iter;
+	BraseroFileNode *next;
 	BraseroImport *import;
 
-	/* clean children */
-	for (iter = BRASERO_FILE_NODE_CHILDREN (node); iter; iter = iter->next) {
-		if (!iter->is_imported)
+	/* The children list is going to change */
+	brasero_file_node_index_free (node);
+
+	/* clean children (destroyed nodes may be reused at once so unchain
+	 * them first) */
+	for (iter = BRASERO_FILE_NODE_CHILDREN (node); iter; iter = next) {
+		next = iter->next;
+
+		if (!iter->is_imported) {
+			if (prev)
+				prev->next = next;
+			else
+				node->union2.children = next;
+
 			brasero_file_node_destroy_with_children (iter, stats);
+			continue;
+		}
 
 		if (!iter->is_file)
 			brasero_file_node_save_imported_children (iter, stats, sort_func);
+
+		prev = iter;
 	}
 
+	/* Only imported nodes (which don't count) are left */
+	node->total_sectors = 0;
+
 	/* restore all replaced children */
 	import = BRASERO_FILE_NODE_IMPORT (node);
 	if (!import)
 		return;
 
-	for (iter = import->replaced; iter; iter = iter->next)
+	for (iter = import->replaced; iter; iter = next) {
+		next = iter->next;
 		brasero_file_node_insert (iter, node, sort_func, NULL);
+	}
 
 	/* remove import */
 	node->union1.name = import->name;
@@ -40,6 +40,7 @@
 G_BEGIN_DECLS
 
 typedef struct _BraseroFileNode BraseroFileNode;
+typedef struct _BraseroFileNodeIndex BraseroFileNodeIndex;
 
 struct _BraseroURINode {
 	/* List of all nodes that share the same URI */
@@ -70,12 +71,21 @@ typedef struct _BraseroImport BraseroImport;
  * - number of files over 2 GiB
  */
 
+typedef struct _BraseroFileNodeArena BraseroFileNodeArena;
+
 struct _BraseroFileTreeStats {
 	guint children;
 	guint num_dir;
 	guint num_deep;
 	guint num_2GiB;
 	guint num_sym;
+
+	/* Incremented whenever a size or a graft changes in the tree so that
+	 * values computed from them can be cached */
+	guint changes;
+
+	/* Where the nodes of the tree and their names are allocated */
+	BraseroFileNodeArena *arena;
 };
 typedef struct _BraseroFileTreeStats BraseroFileTreeStats;
 
@@ -122,6 +132,15 @@ struct _BraseroFileNode {
 		BraseroFileTreeStats *stats;
 	} union3;
 
+	/* For directories: sum of the sectors of all the files (not imported)
+	 * below, nested grafts included. It is updated along all the parents
+	 * whenever the size of one of them changes. */
+	guint total_sectors;
+
+	/* Lookup structures for directories with a lot of children. It is
+	 * built lazily and is NULL for files and small directories. */
+	BraseroFileNodeIndex *index;
+
 	/* type of node */
 	guint is_root:1;
 	guint is_fake:1;
@@ -160,6 +179,10 @@ struct _BraseroFileNode {
 
 	guint is_expanded:1; /* Used to choose the icon for folders */
 
+	/* The node and its name were allocated in the tree arena */
+	guint is_arena:1;
+	guint is_arena_name:1;
+
 	/* this is a ref count a max of 255 should be enough */
 	guint is_visible:7;
 };
@@ -185,9 +208,18 @@ struct _BraseroFileNode {
 #define BRASERO_FILE_NODE_SECTORS(MACRO_node)					\
 	((guint64) ((MACRO_node)->is_root?0:(MACRO_node)->union3.sectors))
 
+/** Size of the node with all its contents (imported files are not counted) */
+#define BRASERO_FILE_NODE_TOTAL_SECTORS(MACRO_node)				\
+	((guint64) ((MACRO_node)->is_file?						\
+		    ((MACRO_node)->is_imported?0:(MACRO_node)->union3.sectors):	\
+		    (MACRO_node)->total_sectors))
+
 #define BRASERO_FILE_NODE_STATS(MACRO_root)					\
 	((MACRO_root)->is_root?(MACRO_root)->union3.stats:NULL)
 
+#define BRASERO_FILE_NODE_ARENA(MACRO_root)					\
+	((MACRO_root)->is_root?(MACRO_root)->union3.stats->arena:NULL)
+
 #define BRASERO_FILE_NODE_VIRTUAL(MACRO_node)					\
 	((MACRO_node)->is_hidden && (MACRO_node)->is_fake)
 
@@ -199,6 +231,9 @@ struct _BraseroFileNode {
 BraseroFileNode *
 brasero_file_node_root_new (void);
 
+gsize
+brasero_file_node_arena_get_size (BraseroFileNodeArena *arena);
+
 BraseroFileNode *
 brasero_file_node_get_root (BraseroFileNode *node,
 			    guint *depth);
@@ -211,6 +246,10 @@ BraseroFileNode *
 brasero_file_node_nth_child (BraseroFileNode *parent,
 			     guint nth);
 
+BraseroFileNode *
+brasero_file_node_nth_visible_child (BraseroFileNode *parent,
+				     guint nth);
+
 guint
 brasero_file_node_get_depth (BraseroFileNode *node);
 
@@ -221,7 +260,7 @@ guint
 brasero_file_node_get_n_children (const BraseroFileNode *node);
 
 guint
-brasero_file_node_get_pos_as_child (BraseroFileNode *node);
+brasero_file_node_get_visible_pos_as_child (BraseroFileNode *node);
 
 gboolean
 brasero_file_node_is_ancestor (BraseroFileNode *parent,
@@ -247,20 +286,32 @@ brasero_file_node_add (BraseroFileNode *parent,
 		       BraseroFileNode *child,
 		       GCompareFunc sort_func);
 
+void
+brasero_file_node_add_list (BraseroFileNode *parent,
+			    GSList *nodes,
+			    GCompareFunc sort_func,
+			    GFunc func,
+			    gpointer user_data);
+
 BraseroFileNode *
-brasero_file_node_new (const gchar *name);
+brasero_file_node_new (BraseroFileNodeArena *arena,
+		       const gchar *name);
 
 BraseroFileNode *
-brasero_file_node_new_virtual (const gchar *name);
+brasero_file_node_new_virtual (BraseroFileNodeArena *arena,
+			       const gchar *name);
 
 BraseroFileNode *
-brasero_file_node_new_loading (const gchar *name);
+brasero_file_node_new_loading (BraseroFileNodeArena *arena,
+			       const gchar *name);
 
 BraseroFileNode *
-brasero_file_node_new_empty_folder (const gchar *name);
+brasero_file_node_new_empty_folder (BraseroFileNodeArena *arena,
+				    const gchar *name);
 
 BraseroFileNode *
-brasero_file_node_new_imported_session_file (GFileInfo *info);
+brasero_file_node_new_imported_session_file (BraseroFileNodeArena *arena,
+					     GFileInfo *info);
 
 /**
  * If there are any change in the order it cannot be handled in these functions
@@ -274,6 +325,10 @@ brasero_file_node_set_from_info (BraseroFileNode *node,
 				 BraseroFileTreeStats *stats,
 				 GFileInfo *info);
 
+void
+brasero_file_node_total_changed (BraseroFileNode *node,
+				 guint64 old_total);
+
 void
 brasero_file_node_graft (BraseroFileNode *file_node,
 			 BraseroURINode *uri_node);
@@ -88,6 +88,9 @@ brasero_plugin_check_media_restrictions (BraseroPlugin *plugin,
 void
 brasero_plugin_check_plugin_ready (BraseroPlugin *plugin);
 
+guint
+brasero_plugin_get_generation (void);
+
 G_END_DECLS
 
 #endif
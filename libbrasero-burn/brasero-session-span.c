@@ -218,6 +218,83 @@ brasero_session_span_possible (BraseroSessionSpan *session)
 	return BRASERO_BURN_RETRY;
 }
 
+/**
+ * brasero_session_span_get_disc_num:
+ * @session: a #BraseroSessionSpan
+ * @fill_ratio: a #gdouble or %NULL
+ *
+ * Plans how the data not burnt yet through brasero_session_span_next () would
+ * be spread over media of the size of the one inserted in the #BraseroDrive
+ * set for @session (see brasero_burn_session_set_burner ()) and returns how
+ * many of them would be needed. If @fill_ratio is not %NULL, it is set to the
+ * ratio of the space used on these media.
+ *
+ * Return value: a #guint. 0 if some data can't fit on such a medium.
+ **/
+
+guint
+brasero_session_span_get_disc_num (BraseroSessionSpan *session,
+				   gdouble *fill_ratio)
+{
+	GSList *tracks;
+	guint disc_num = 0;
+	goffset max_sectors = 0;
+	goffset disc_sectors = 0;
+	goffset total_sectors = 0;
+	BraseroSessionSpanPrivate *priv;
+
+	g_return_val_if_fail (BRASERO_IS_SESSION_SPAN (session), 0);
+
+	priv = BRASERO_SESSION_SPAN_PRIVATE (session);
+
+	if (fill_ratio)
+		*fill_ratio = 0.0;
+
+	max_sectors = brasero_burn_session_get_available_medium_space (BRASERO_BURN_SESSION (session));
+	if (max_sectors <= 0)
+		return 0;
+
+	if (priv->last_track) {
+		tracks = g_slist_find (priv->track_list, priv->last_track);
+		tracks = tracks->next;
+	}
+	else if (priv->track_list)
+		tracks = priv->track_list;
+	else
+		tracks = brasero_burn_session_get_tracks (BRASERO_BURN_SESSION (session));
+
+	if (tracks && BRASERO_IS_TRACK_DATA_CFG (tracks->data))
+		return brasero_track_data_cfg_span_get_disc_num (BRASERO_TRACK_DATA_CFG (tracks->data),
+								 max_sectors,
+								 fill_ratio);
+
+	/* This is the common case: tracks are burnt in order (see
+	 * brasero_session_span_next ()) */
+	for (; tracks; tracks = tracks->next) {
+		goffset track_blocks = 0;
+
+		brasero_track_get_size (BRASERO_TRACK (tracks->data),
+					&track_blocks,
+					NULL);
+
+		if (track_blocks >= max_sectors)
+			return 0;
+
+		if (!disc_num || track_blocks + disc_sectors >= max_sectors) {
+			disc_num ++;
+			disc_sectors = 0;
+		}
+
+		disc_sectors += track_blocks;
+		total_sectors += track_blocks;
+	}
+
+	if (fill_ratio && disc_num)
+		*fill_ratio = (gdouble) total_sectors / ((gdouble) max_sectors * disc_num);
+
+	return disc_num;
+}
+
 /**
  * brasero_session_span_start:
  * @session: a #BraseroSessionSpan
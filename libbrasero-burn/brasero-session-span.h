@@ -77,6 +77,10 @@ brasero_session_span_next (BraseroSessionSpan *session);
 goffset
 brasero_session_span_get_max_space (BraseroSessionSpan *session);
 
+guint
+brasero_session_span_get_disc_num (BraseroSessionSpan *session,
+				   gdouble *fill_ratio);
+
 void
 brasero_session_span_stop (BraseroSessionSpan *session);
 
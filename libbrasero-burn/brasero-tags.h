@@ -48,6 +48,15 @@ G_BEGIN_DECLS
 
 #define BRASERO_TRACK_MEDIUM_WRONG_CHECKSUM_TAG		"track::medium::error::checksum::list"
 
+/**
+ * Checksums of an image computed alongside the one set with
+ * brasero_track_set_checksum () (strings)
+ */
+
+#define BRASERO_TRACK_CHECKSUM_MD5_TAG			"track::checksum::md5"
+#define BRASERO_TRACK_CHECKSUM_SHA1_TAG			"track::checksum::sha1"
+#define BRASERO_TRACK_CHECKSUM_SHA256_TAG		"track::checksum::sha256"
+
 /**
  * Strings
  */
@@ -82,8 +82,14 @@ struct _BraseroTrackDataCfgPrivate
 	gint sort_column;
 	GtkSortType sort_type;
 
+	/* Parent of the batch of nodes being added (see rows-adding) */
+	BraseroFileNode *batch_parent;
+
 	guint joliet_rename:1;
 
+	guint batch_empty:1;
+	guint batch_changed:1;
+
 	guint deep_directory:1;
 	guint G2_files:1;
 };
@@ -141,31 +147,6 @@ static gulong brasero_track_data_cfg_signals [LAST_SIGNAL] = { 0 };
  * GtkTreeModel part
  */
 
-static guint
-brasero_track_data_cfg_get_pos_as_child (BraseroFileNode *node)
-{
-	BraseroFileNode *parent;
-	BraseroFileNode *peers;
-	guint pos = 0;
-
-	if (!node)
-		return 0;
-
-	parent = node->parent;
-	for (peers = BRASERO_FILE_NODE_CHILDREN (parent); peers; peers = peers->next) {
-		if (peers == node)
-			break;
-
-		/* Don't increment when is_hidden */
-		if (peers->is_hidden)
-			continue;
-
-		pos ++;
-	}
-
-	return pos;
-}
-
 static GtkTreePath *
 brasero_track_data_cfg_node_to_path (BraseroTrackDataCfg *self,
 				     BraseroFileNode *node)
@@ -176,7 +157,7 @@ brasero_track_data_cfg_node_to_path (BraseroTrackDataCfg *self,
 	for (; node->parent && !node->is_root; node = node->parent) {
 		guint nth;
 
-		nth = brasero_track_data_cfg_get_pos_as_child (node);
+		nth = brasero_file_node_get_visible_pos_as_child (node);
 		gtk_tree_path_prepend_index (path, nth);
 	}
 
@@ -218,31 +199,6 @@ brasero_track_data_cfg_iter_parent (GtkTreeModel *model,
 	return TRUE;
 }
 
-static BraseroFileNode *
-brasero_track_data_cfg_nth_child (BraseroFileNode *parent,
-				  guint nth)
-{
-	BraseroFileNode *peers;
-	gint pos;
-
-	if (!parent)
-		return NULL;
-
-	peers = BRASERO_FILE_NODE_CHILDREN (parent);
-	while (peers && peers->is_hidden)
-		peers = peers->next;
-		
-	for (pos = 0; pos < nth && peers; pos ++) {
-		peers = peers->next;
-
-		/* Skip hidden */
-		while (peers && peers->is_hidden)
-			peers = peers->next;
-	}
-
-	return peers;
-}
-
 static gboolean
 brasero_track_data_cfg_iter_nth_child (GtkTreeModel *model,
 				       GtkTreeIter *iter,
@@ -270,7 +226,7 @@ brasero_track_data_cfg_iter_nth_child (GtkTreeModel *model,
 	else
 		node = brasero_data_project_get_root (BRASERO_DATA_PROJECT (priv->tree));
 
-	iter->user_data = brasero_track_data_cfg_nth_child (node, n);
+	iter->user_data = brasero_file_node_nth_visible_child (node, n);
 	if (!iter->user_data)
 		return FALSE;
 
@@ -279,25 +235,6 @@ brasero_track_data_cfg_iter_nth_child (GtkTreeModel *model,
 	return TRUE;
 }
 
-static guint
-brasero_track_data_cfg_get_n_children (const BraseroFileNode *node)
-{
-	BraseroFileNode *children;
-	guint num = 0;
-
-	if (!node)
-		return 0;
-
-	for (children = BRASERO_FILE_NODE_CHILDREN (node); children; children = children->next) {
-		if (children->is_hidden)
-			continue;
-
-		num ++;
-	}
-
-	return num;
-}
-
 static gint
 brasero_track_data_cfg_iter_n_children (GtkTreeModel *model,
 					 GtkTreeIter *iter)
@@ -310,7 +247,7 @@ brasero_track_data_cfg_iter_n_children (GtkTreeModel *model,
 	if (iter == NULL) {
 		/* special case */
 		node = brasero_data_project_get_root (BRASERO_DATA_PROJECT (priv->tree));
-		return brasero_track_data_cfg_get_n_children (node);
+		return brasero_file_node_get_n_children (node);
 	}
 
 	/* make sure that iter comes from us */
@@ -325,10 +262,10 @@ brasero_track_data_cfg_iter_n_children (GtkTreeModel *model,
 		return 0;
 
 	/* return at least one for the bogus row labelled "empty". */
-	if (!brasero_track_data_cfg_get_n_children (node))
+	if (!brasero_file_node_get_n_children (node))
 		return 1;
 
-	return brasero_track_data_cfg_get_n_children (node);
+	return brasero_file_node_get_n_children (node);
 }
 
 static gboolean
@@ -419,7 +356,7 @@ brasero_track_data_cfg_iter_children (GtkTreeModel *model,
 	}
 
 	iter->stamp = priv->stamp;
-	if (!brasero_track_data_cfg_get_n_children (node)) {
+	if (!brasero_file_node_get_n_children (node)) {
 		/* This is a directory but it hasn't got any child; yet
 		 * we show a row written empty for that. Set bogus in
 		 * user_data and put parent in user_data. */
@@ -794,7 +731,7 @@ brasero_track_data_cfg_get_value (GtkTreeModel *model,
 				return;
 			}
 
-			nb_items = brasero_track_data_cfg_get_n_children (node);
+			nb_items = brasero_file_node_get_n_children (node);
 			if (!nb_items)
 				g_value_set_string (value, _("Empty"));
 			else {
@@ -939,7 +876,7 @@ brasero_track_data_cfg_path_to_node (BraseroTrackDataCfg *self,
 		BraseroFileNode *parent;
 
 		parent = node;
-		node = brasero_track_data_cfg_nth_child (parent, indices [i]);
+		node = brasero_file_node_nth_visible_child (parent, indices [i]);
 		if (!node)
 			return NULL;
 	}
@@ -968,7 +905,7 @@ brasero_track_data_cfg_get_iter (GtkTreeModel *model,
 	if (!root)
 		return FALSE;
 		
-	node = brasero_track_data_cfg_nth_child (root, indices [0]);
+	node = brasero_file_node_nth_visible_child (root, indices [0]);
 	if (!node)
 		return FALSE;
 
@@ -976,13 +913,13 @@ brasero_track_data_cfg_get_iter (GtkTreeModel *model,
 		BraseroFileNode *parent;
 
 		parent = node;
-		node = brasero_track_data_cfg_nth_child (parent, indices [i]);
+		node = brasero_file_node_nth_visible_child (parent, indices [i]);
 		if (!node) {
 			/* There is one case where this can happen and
 			 * is allowed: that's when the parent is an
 			 * empty directory. Then index must be 0. */
 			if (!parent->is_file
-			&&  !brasero_track_data_cfg_get_n_children (parent)
+			&&  !brasero_file_node_get_n_children (parent)
 			&&   indices [i] == 0) {
 				iter->stamp = priv->stamp;
 				iter->user_data = parent;
@@ -1498,7 +1435,15 @@ brasero_track_data_cfg_node_added (BraseroDataProject *project,
 	gtk_tree_path_free (path);
 
 	parent = node->parent;
-	if (!parent->is_root) {
+	if (parent == priv->batch_parent && !priv->batch_empty) {
+		/* Part of a batch: the parent row is changed once at the end */
+		priv->batch_changed = TRUE;
+	}
+	else if (!parent->is_root) {
+		/* The first row of a batch removes the BOGUS row below */
+		if (parent == priv->batch_parent)
+			priv->batch_empty = FALSE;
+
 		/* Tell the tree that the parent changed (since the number of children
 		 * changed as well). */
 		iter.user_data = parent;
@@ -1509,7 +1454,7 @@ brasero_track_data_cfg_node_added (BraseroDataProject *project,
 		/* Check if the parent of this node is empty if so remove the BOGUS row.
 		 * Do it afterwards to prevent the parent row to be collapsed if it was
 		 * previously expanded. */
-		if (parent && brasero_track_data_cfg_get_n_children (parent) == 1) {
+		if (parent && brasero_file_node_get_n_children (parent) == 1) {
 			gtk_tree_path_append_index (path, 1);
 			gtk_tree_model_row_deleted (GTK_TREE_MODEL (self), path);
 		}
@@ -1534,6 +1479,49 @@ brasero_track_data_cfg_node_added (BraseroDataProject *project,
 //		node->is_visible = TRUE;
 }
 
+static void
+brasero_track_data_cfg_nodes_adding (BraseroDataProject *project,
+				     BraseroFileNode *parent,
+				     BraseroTrackDataCfg *self)
+{
+	BraseroTrackDataCfgPrivate *priv;
+
+	priv = BRASERO_TRACK_DATA_CFG_PRIVATE (self);
+
+	/* Rows are still inserted one by one but the parent row only needs to
+	 * change once (unless its BOGUS row has to be removed first). */
+	priv->batch_parent = parent;
+	priv->batch_empty = (brasero_file_node_get_n_children (parent) == 0);
+	priv->batch_changed = FALSE;
+}
+
+static void
+brasero_track_data_cfg_nodes_added (BraseroDataProject *project,
+				    BraseroFileNode *parent,
+				    BraseroTrackDataCfg *self)
+{
+	BraseroTrackDataCfgPrivate *priv;
+
+	priv = BRASERO_TRACK_DATA_CFG_PRIVATE (self);
+
+	if (priv->batch_changed && !parent->is_root) {
+		GtkTreePath *path;
+		GtkTreeIter iter;
+
+		iter.stamp = priv->stamp;
+		iter.user_data = parent;
+		iter.user_data2 = GINT_TO_POINTER (BRASERO_ROW_REGULAR);
+
+		path = brasero_track_data_cfg_node_to_path (self, parent);
+		gtk_tree_model_row_changed (GTK_TREE_MODEL (self), path, &iter);
+		gtk_tree_path_free (path);
+	}
+
+	priv->batch_parent = NULL;
+	priv->batch_empty = FALSE;
+	priv->batch_changed = FALSE;
+}
+
 static guint
 brasero_track_data_cfg_convert_former_position (BraseroFileNode *former_parent,
                                                 guint former_position)
@@ -1607,7 +1595,7 @@ brasero_track_data_cfg_node_removed (BraseroDataProject *project,
 	 * add a bogus row. If it hasn't got children then it only remains our
 	 * node in the list.
 	 * NOTE: parent has to be a directory. */
-	if (!former_parent->is_root && !brasero_track_data_cfg_get_n_children (former_parent)) {
+	if (!former_parent->is_root && !brasero_file_node_get_n_children (former_parent)) {
 		GtkTreeIter iter;
 
 		iter.stamp = priv->stamp;
@@ -1673,7 +1661,7 @@ brasero_track_data_cfg_node_changed (BraseroDataProject *project,
 								      NULL);
 
 		/* add the row */
-		if (!brasero_track_data_cfg_get_n_children (node))  {
+		if (!brasero_file_node_get_n_children (node))  {
 			iter.user_data2 = GINT_TO_POINTER (BRASERO_ROW_BOGUS);
 			gtk_tree_path_append_index (path, 0);
 
@@ -2023,7 +2011,7 @@ brasero_track_data_cfg_reset (BraseroTrackDataCfg *track)
 	brasero_track_data_clean_autorun (track);
 
 	root = brasero_data_project_get_root (BRASERO_DATA_PROJECT (priv->tree));
-	num = brasero_track_data_cfg_get_n_children (root);
+	num = brasero_file_node_get_n_children (root);
 
 	brasero_data_project_reset (BRASERO_DATA_PROJECT (priv->tree));
 
@@ -3044,6 +3032,33 @@ brasero_track_data_cfg_span_max_space (BraseroTrackDataCfg *track)
 	return brasero_data_project_get_max_space (BRASERO_DATA_PROJECT (priv->tree));
 }
 
+/**
+ * brasero_track_data_cfg_span_get_disc_num:
+ * @track: a #BraseroTrackDataCfg
+ * @sectors: a #goffset
+ * @fill_ratio: a #gdouble or %NULL
+ *
+ * Plans how the files remaining in the tree after calls to
+ * brasero_track_data_cfg_span () would be spread over discs of @sectors
+ * and returns how many of them would be needed. If @fill_ratio is not
+ * %NULL, it is set to the ratio of the space used on these discs.
+ *
+ * Return value: a #guint. 0 if some files can't fit on such a disc.
+ **/
+
+guint
+brasero_track_data_cfg_span_get_disc_num (BraseroTrackDataCfg *track,
+					  goffset sectors,
+					  gdouble *fill_ratio)
+{
+	BraseroTrackDataCfgPrivate *priv;
+
+	priv = BRASERO_TRACK_DATA_CFG_PRIVATE (track);
+	return brasero_data_project_span_get_disc_num (BRASERO_DATA_PROJECT (priv->tree),
+						       sectors,
+						       fill_ratio);
+}
+
 /**
  * This is to handle the icon for the image
  */
@@ -3304,6 +3319,14 @@ brasero_track_data_cfg_init (BraseroTrackDataCfg *object)
 			  "row-added",
 			  G_CALLBACK (brasero_track_data_cfg_node_added),
 			  object);
+	g_signal_connect (priv->tree,
+			  "rows-adding",
+			  G_CALLBACK (brasero_track_data_cfg_nodes_adding),
+			  object);
+	g_signal_connect (priv->tree,
+			  "rows-added",
+			  G_CALLBACK (brasero_track_data_cfg_nodes_added),
+			  object);
 	g_signal_connect (priv->tree,
 			  "row-changed",
 			  G_CALLBACK (brasero_track_data_cfg_node_changed),
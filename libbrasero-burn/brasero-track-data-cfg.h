@@ -167,6 +167,11 @@ brasero_track_data_cfg_span_possible (BraseroTrackDataCfg *track,
 goffset
 brasero_track_data_cfg_span_max_space (BraseroTrackDataCfg *track);
 
+guint
+brasero_track_data_cfg_span_get_disc_num (BraseroTrackDataCfg *track,
+					  goffset sectors,
+					  gdouble *fill_ratio);
+
 void
 brasero_track_data_cfg_span_stop (BraseroTrackDataCfg *track);
 
@@ -321,10 +321,18 @@ brasero_track_stream_cfg_results_cb (GObject *obj,
 	brasero_track_changed (BRASERO_TRACK (obj));
 }
 
+#define BRASERO_TRACK_STREAM_CFG_IO_FLAGS	(BRASERO_IO_INFO_PERM|			\
+						 BRASERO_IO_INFO_MIME|			\
+						 BRASERO_IO_INFO_URGENT|		\
+						 BRASERO_IO_INFO_METADATA|		\
+						 BRASERO_IO_INFO_METADATA_MISSING_CODEC|	\
+						 BRASERO_IO_INFO_METADATA_THUMBNAIL)
+
 static void
 brasero_track_stream_cfg_get_info (BraseroTrackStreamCfg *track)
 {
 	BraseroTrackStreamCfgPrivate *priv;
+	GFileInfo *info;
 	gchar *uri;
 
 	priv = BRASERO_TRACK_STREAM_CFG_PRIVATE (track);
@@ -346,14 +354,21 @@ brasero_track_stream_cfg_get_info (BraseroTrackStreamCfg *track)
 
 	priv->loading = TRUE;
 	uri = brasero_track_stream_get_source (BRASERO_TRACK_STREAM (track), TRUE);
+
+	/* Files that were already analysed (possibly during a previous
+	 * session) are in the metadata cache */
+	info = brasero_io_get_file_info_cached (uri, BRASERO_TRACK_STREAM_CFG_IO_FLAGS);
+	if (info) {
+		BRASERO_BURN_LOG ("Metadata cache hit for %s", uri);
+		brasero_track_stream_cfg_results_cb (G_OBJECT (track), NULL, uri, info, NULL);
+		g_object_unref (info);
+		g_free (uri);
+		return;
+	}
+
 	brasero_io_get_file_info (uri,
 				  priv->load_uri,
-				  BRASERO_IO_INFO_PERM|
-				  BRASERO_IO_INFO_MIME|
-				  BRASERO_IO_INFO_URGENT|
-				  BRASERO_IO_INFO_METADATA|
-				  BRASERO_IO_INFO_METADATA_MISSING_CODEC|
-				  BRASERO_IO_INFO_METADATA_THUMBNAIL,
+				  BRASERO_TRACK_STREAM_CFG_IO_FLAGS,
 				  track);
 	g_free (uri);
 }
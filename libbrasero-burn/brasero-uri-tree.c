@@ -0,0 +1,396 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 8; tab-width: 8 -*- */
+/*
+ * Libbrasero-burn
+ * Copyright (C) Philippe Rouquier 2005-2009 <bonfire-app@wanadoo.fr>
+ *
+ * Libbrasero-burn is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * The Libbrasero-burn authors hereby grant permission for non-GPL compatible
+ * GStreamer plugins to be used and distributed together with GStreamer
+ * and Libbrasero-burn. This permission is above and beyond the permissions granted
+ * by the GPL license by which Libbrasero-burn is covered. If you modify this code
+ * you may extend this exception to your version of the code, but you are not
+ * obligated to do so. If you do not wish to do so, delete this exception
+ * statement from your version.
+ * 
+ * Libbrasero-burn is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to:
+ * 	The Free Software Foundation, Inc.,
+ * 	51 Franklin Street, Fifth Floor
+ * 	Boston, MA  02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <string.h>
+
+#include <glib.h>
+
+#include "brasero-uri-tree.h"
+
+/**
+ * Each edge holds a whole substring (radix tree) so that long URIs sharing
+ * the same beginning don't cost one node per character. Siblings never start
+ * with the same character.
+ */
+
+typedef struct _BraseroUriTreeNode BraseroUriTreeNode;
+struct _BraseroUriTreeNode {
+	gchar *label;
+	gsize len;
+
+	gpointer data;
+
+	BraseroUriTreeNode *children;
+	BraseroUriTreeNode *next;
+
+	guint has_data:1;
+};
+
+struct _BraseroUriTree {
+	BraseroUriTreeNode root;
+};
+
+BraseroUriTree *
+brasero_uri_tree_new (void)
+{
+	return g_new0 (BraseroUriTree, 1);
+}
+
+static void
+brasero_uri_tree_node_free (BraseroUriTreeNode *node)
+{
+	while (node) {
+		BraseroUriTreeNode *next;
+
+		next = node->next;
+		brasero_uri_tree_node_free (node->children);
+		g_free (node->label);
+		g_free (node);
+		node = next;
+	}
+}
+
+void
+brasero_uri_tree_remove_all (BraseroUriTree *tree)
+{
+	brasero_uri_tree_node_free (tree->root.children);
+	tree->root.children = NULL;
+	tree->root.has_data = FALSE;
+	tree->root.data = NULL;
+}
+
+void
+brasero_uri_tree_free (BraseroUriTree *tree)
+{
+	brasero_uri_tree_remove_all (tree);
+	g_free (tree);
+}
+
+static BraseroUriTreeNode *
+brasero_uri_tree_node_get_child (BraseroUriTreeNode *node,
+				 gchar c)
+{
+	BraseroUriTreeNode *child;
+
+	for (child = node->children; child; child = child->next) {
+		if (child->label [0] == c)
+			return child;
+	}
+	return NULL;
+}
+
+static void
+brasero_uri_tree_node_set_label (BraseroUriTreeNode *node,
+				 const gchar *label,
+				 gsize len)
+{
+	gchar *tmp;
+
+	tmp = g_strndup (label, len);
+	g_free (node->label);
+	node->label = tmp;
+	node->len = len;
+}
+
+void
+brasero_uri_tree_insert (BraseroUriTree *tree,
+			 const gchar *uri,
+			 gpointer data)
+{
+	BraseroUriTreeNode *node;
+
+	node = &tree->root;
+	while (uri [0] != '\0') {
+		BraseroUriTreeNode *child;
+		BraseroUriTreeNode *middle;
+		BraseroUriTreeNode **link;
+		gsize common;
+
+		child = brasero_uri_tree_node_get_child (node, uri [0]);
+		if (!child) {
+			child = g_new0 (BraseroUriTreeNode, 1);
+			brasero_uri_tree_node_set_label (child, uri, strlen (uri));
+			child->next = node->children;
+			node->children = child;
+			node = child;
+			break;
+		}
+
+		for (common = 1; common < child->len && uri [common] == child->label [common]; common ++);
+		if (common == child->len) {
+			node = child;
+			uri += common;
+			continue;
+		}
+
+		/* Split the edge where the URI diverges */
+		middle = g_new0 (BraseroUriTreeNode, 1);
+		brasero_uri_tree_node_set_label (middle, child->label, common);
+		brasero_uri_tree_node_set_label (child, child->label + common, child->len - common);
+
+		for (link = &node->children; *link != child; link = &(*link)->next);
+		*link = middle;
+		middle->next = child->next;
+		middle->children = child;
+		child->next = NULL;
+
+		node = middle;
+		uri += common;
+	}
+
+	node->data = data;
+	node->has_data = TRUE;
+}
+
+/**
+ * Returns the node whose path from the root spells out uri exactly (the
+ * parent is returned as well).
+ */
+
+static BraseroUriTreeNode *
+brasero_uri_tree_find (BraseroUriTree *tree,
+		       const gchar *uri,
+		       BraseroUriTreeNode **parent)
+{
+	BraseroUriTreeNode *node;
+
+	node = &tree->root;
+	if (parent)
+		*parent = NULL;
+
+	while (uri [0] != '\0') {
+		BraseroUriTreeNode *child;
+
+		child = brasero_uri_tree_node_get_child (node, uri [0]);
+		if (!child || strncmp (uri, child->label, child->len))
+			return NULL;
+
+		if (parent)
+			*parent = node;
+
+		node = child;
+		uri += child->len;
+	}
+
+	return node;
+}
+
+gpointer
+brasero_uri_tree_lookup (BraseroUriTree *tree,
+			 const gchar *uri)
+{
+	BraseroUriTreeNode *node;
+
+	node = brasero_uri_tree_find (tree, uri, NULL);
+	if (!node || !node->has_data)
+		return NULL;
+
+	return node->data;
+}
+
+/**
+ * A node without data and with a single child is merged with it to keep the
+ * tree compressed.
+ */
+
+static void
+brasero_uri_tree_node_merge_child (BraseroUriTreeNode *node)
+{
+	BraseroUriTreeNode *child;
+	gchar *label;
+
+	child = node->children;
+	if (!child || child->next || node->has_data || !node->label)
+		return;
+
+	label = g_strconcat (node->label, child->label, NULL);
+	g_free (node->label);
+	node->label = label;
+	node->len += child->len;
+
+	node->children = child->children;
+	node->data = child->data;
+	node->has_data = child->has_data;
+
+	g_free (child->label);
+	g_free (child);
+}
+
+gpointer
+brasero_uri_tree_remove (BraseroUriTree *tree,
+			 const gchar *uri)
+{
+	BraseroUriTreeNode *parent;
+	BraseroUriTreeNode *node;
+	gpointer data;
+
+	node = brasero_uri_tree_find (tree, uri, &parent);
+	if (!node || !node->has_data)
+		return NULL;
+
+	data = node->data;
+	node->data = NULL;
+	node->has_data = FALSE;
+
+	if (!parent) {
+		/* That's the root (empty URI) */
+		return data;
+	}
+
+	if (!node->children) {
+		BraseroUriTreeNode **link;
+
+		for (link = &parent->children; *link != node; link = &(*link)->next);
+		*link = node->next;
+
+		g_free (node->label);
+		g_free (node);
+
+		brasero_uri_tree_node_merge_child (parent);
+	}
+	else
+		brasero_uri_tree_node_merge_child (node);
+
+	return data;
+}
+
+/**
+ * Returns the data of the longest URI in the tree which is a parent of uri
+ * (uri itself is not considered). parent_len is set to its length.
+ */
+
+gpointer
+brasero_uri_tree_lookup_parent (BraseroUriTree *tree,
+				const gchar *uri,
+				gsize *parent_len)
+{
+	BraseroUriTreeNode *node;
+	gpointer data = NULL;
+	gsize depth = 0;
+
+	node = &tree->root;
+	while (uri [depth] != '\0') {
+		BraseroUriTreeNode *child;
+
+		if (depth && node->has_data && uri [depth] == G_DIR_SEPARATOR) {
+			data = node->data;
+			if (parent_len)
+				*parent_len = depth;
+		}
+
+		child = brasero_uri_tree_node_get_child (node, uri [depth]);
+		if (!child || strncmp (uri + depth, child->label, child->len))
+			break;
+
+		node = child;
+		depth += child->len;
+	}
+
+	return data;
+}
+
+static void
+brasero_uri_tree_node_foreach (BraseroUriTreeNode *node,
+			       GString *prefix,
+			       GHFunc func,
+			       gpointer user_data)
+{
+	BraseroUriTreeNode *child;
+	gsize len;
+
+	len = prefix->len;
+	g_string_append_len (prefix, node->label, node->len);
+
+	if (node->has_data)
+		func (prefix->str, node->data, user_data);
+
+	for (child = node->children; child; child = child->next)
+		brasero_uri_tree_node_foreach (child, prefix, func, user_data);
+
+	g_string_truncate (prefix, len);
+}
+
+/**
+ * Calls func for all URIs below uri (uri itself is not included).
+ */
+
+void
+brasero_uri_tree_foreach_child (BraseroUriTree *tree,
+				const gchar *uri,
+				GHFunc func,
+				gpointer user_data)
+{
+	BraseroUriTreeNode *node;
+	GString *prefix;
+	gsize depth = 0;
+
+	node = &tree->root;
+	prefix = g_string_new (NULL);
+
+	while (uri [depth] != '\0') {
+		BraseroUriTreeNode *child;
+		gsize matched;
+
+		child = brasero_uri_tree_node_get_child (node, uri [depth]);
+		if (!child)
+			goto end;
+
+		for (matched = 0; matched < child->len && uri [depth + matched] == child->label [matched]; matched ++);
+		if (uri [depth + matched] == '\0' && matched < child->len) {
+			/* uri ends in the middle of that edge */
+			if (child->label [matched] == G_DIR_SEPARATOR) {
+				g_string_append_len (prefix, uri, depth);
+				brasero_uri_tree_node_foreach (child, prefix, func, user_data);
+			}
+			goto end;
+		}
+
+		if (matched < child->len)
+			goto end;
+
+		node = child;
+		depth += child->len;
+	}
+
+	/* uri ends on a node boundary: only the edges starting with a
+	 * separator lead to children */
+	node = brasero_uri_tree_node_get_child (node, G_DIR_SEPARATOR);
+	if (node) {
+		g_string_append (prefix, uri);
+		brasero_uri_tree_node_foreach (node, prefix, func, user_data);
+	}
+
+end:
+	g_string_free (prefix, TRUE);
+}
@@ -0,0 +1,83 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 8; tab-width: 8 -*- */
+/*
+ * Libbrasero-burn
+ * Copyright (C) Philippe Rouquier 2005-2009 <bonfire-app@wanadoo.fr>
+ *
+ * Libbrasero-burn is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * The Libbrasero-burn authors hereby grant permission for non-GPL compatible
+ * GStreamer plugins to be used and distributed together with GStreamer
+ * and Libbrasero-burn. This permission is above and beyond the permissions granted
+ * by the GPL license by which Libbrasero-burn is covered. If you modify this code
+ * you may extend this exception to your version of the code, but you are not
+ * obligated to do so. If you do not wish to do so, delete this exception
+ * statement from your version.
+ * 
+ * Libbrasero-burn is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to:
+ * 	The Free Software Foundation, Inc.,
+ * 	51 Franklin Street, Fifth Floor
+ * 	Boston, MA  02110-1301, USA.
+ */
+
+#ifndef _BRASERO_URI_TREE_H
+#define _BRASERO_URI_TREE_H
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/**
+ * Maps URIs to data like a GHashTable but stores them in a compressed prefix
+ * tree so that the closest registered parent of a URI or all the registered
+ * URIs below one can be found in a single walk. A URI is considered to be
+ * below another one if it starts with it followed by a separator.
+ */
+
+typedef struct _BraseroUriTree BraseroUriTree;
+
+BraseroUriTree *
+brasero_uri_tree_new (void);
+
+void
+brasero_uri_tree_free (BraseroUriTree *tree);
+
+void
+brasero_uri_tree_insert (BraseroUriTree *tree,
+			 const gchar *uri,
+			 gpointer data);
+
+gpointer
+brasero_uri_tree_remove (BraseroUriTree *tree,
+			 const gchar *uri);
+
+void
+brasero_uri_tree_remove_all (BraseroUriTree *tree);
+
+gpointer
+brasero_uri_tree_lookup (BraseroUriTree *tree,
+			 const gchar *uri);
+
+gpointer
+brasero_uri_tree_lookup_parent (BraseroUriTree *tree,
+				const gchar *uri,
+				gsize *parent_len);
+
+/* func must not modify the tree */
+void
+brasero_uri_tree_foreach_child (BraseroUriTree *tree,
+				const gchar *uri,
+				GHFunc func,
+				gpointer user_data);
+
+G_END_DECLS
+
+#endif /* _BRASERO_URI_TREE_H */
@@ -282,6 +282,11 @@ brasero_burn_caps_finalize (GObject *object)
 		cobj->priv->groups = NULL;
 	}
 
+	if (cobj->priv->links_cache) {
+		g_hash_table_destroy (cobj->priv->links_cache);
+		cobj->priv->links_cache = NULL;
+	}
+
 	g_slist_foreach (cobj->priv->caps_list, (GFunc) brasero_caps_free, NULL);
 	g_slist_free (cobj->priv->caps_list);
 
@@ -315,6 +320,7 @@ brasero_burn_caps_init (BraseroBurnCaps *obj)
 	GSettings *settings;
 
 	obj->priv = g_new0 (BraseroBurnCapsPrivate, 1);
+	obj->priv->links_cache = brasero_caps_link_cache_new ();
 
 	settings = g_settings_new (BRASERO_SCHEMA_CONFIG);
 	obj->priv->group_str = g_settings_get_string (settings, BRASERO_ENGINE_GROUP_KEY);
@@ -79,6 +79,10 @@ struct BraseroBurnCapsPrivate {
 
 	gchar *group_str;
 	guint group_id;
+
+	/* Memoised results of capability searches */
+	GHashTable *links_cache;
+	guint links_generation;
 };
 
 typedef struct {
@@ -117,6 +121,9 @@ BraseroBurnResult
 brasero_caps_link_check_recorder_flags_for_input (BraseroCapsLink *link,
                                                   BraseroBurnFlag session_flags);
 
+GHashTable *
+brasero_caps_link_cache_new (void);
+
 G_END_DECLS
 
 #endif /* BURN_CAPS_H */
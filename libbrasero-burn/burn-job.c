@@ -32,6 +32,9 @@
 #  include <config.h>
 #endif
 
+/* Needed for splice () and F_SETPIPE_SZ */
+#define _GNU_SOURCE
+
 #include <string.h>
 #include <errno.h>
 #include <fcntl.h>
@@ -106,6 +109,14 @@ struct BraseroJobPrivate {
 
 #define BRASERO_JOB_PRIVATE(o)  (G_TYPE_INSTANCE_GET_PRIVATE ((o), BRASERO_TYPE_JOB, BraseroJobPrivate))
 
+/* Pipes between jobs hold that many ms of data at the write rate so the
+ * recorder doesn't underrun when the job feeding it stalls briefly */
+#define BRASERO_JOB_PIPE_BUFFER_TIME		500
+#define BRASERO_JOB_PIPE_MIN_SIZE		65536
+#define BRASERO_JOB_PIPE_DEFAULT_MAX_SIZE	1048576
+
+#define BRASERO_JOB_FORWARD_BUFFER_SIZE		65536
+
 enum {
 	PROP_NONE,
 	PROP_OUTPUT,
@@ -706,6 +717,53 @@ brasero_job_get_next_active (BraseroJob *self)
 	return NULL;
 }
 
+static void
+brasero_job_set_pipe_size (BraseroJob *self,
+			   int fd)
+{
+#ifdef F_SETPIPE_SZ
+	BraseroBurnSession *session;
+	BraseroJobPrivate *priv;
+	gchar *contents = NULL;
+	guint64 max_size;
+	guint64 rate;
+	guint64 size;
+
+	priv = BRASERO_JOB_PRIVATE (self);
+	session = brasero_task_ctx_get_session (priv->ctx);
+
+	/* No real time constraint when not writing to a disc */
+	rate = brasero_burn_session_get_rate (session);
+	if (!rate)
+		return;
+
+	/* Unprivileged processes can't go beyond that limit */
+	max_size = BRASERO_JOB_PIPE_DEFAULT_MAX_SIZE;
+	if (g_file_get_contents ("/proc/sys/fs/pipe-max-size", &contents, NULL, NULL)) {
+		max_size = g_ascii_strtoull (contents, NULL, 10);
+		g_free (contents);
+	}
+
+	size = rate * BRASERO_JOB_PIPE_BUFFER_TIME / 1000;
+	size = MIN (size, max_size);
+	if (size <= BRASERO_JOB_PIPE_MIN_SIZE)
+		return;
+
+	while (size > BRASERO_JOB_PIPE_MIN_SIZE) {
+		if (fcntl (fd, F_SETPIPE_SZ, (int) size) >= 0) {
+			BRASERO_JOB_LOG (self,
+					 "pipe size set to %"G_GUINT64_FORMAT" (rate = %"G_GUINT64_FORMAT")",
+					 size,
+					 rate);
+			return;
+		}
+
+		/* That can fail if the user exceeded its quota of pipe pages */
+		size /= 2;
+	}
+#endif
+}
+
 static BraseroBurnResult
 brasero_job_item_start (BraseroTaskItem *item,
 		        GError **error)
@@ -776,6 +834,8 @@ brasero_job_item_start (BraseroTaskItem *item,
 		priv->input = g_new0 (BraseroJobInput, 1);
 		priv->input->in = fd [0];
 		priv->input->out = fd [1];
+
+		brasero_job_set_pipe_size (self, fd [1]);
 	}
 
 	klass = BRASERO_JOB_GET_CLASS (self);
@@ -1324,6 +1384,104 @@ brasero_job_get_fd_out (BraseroJob *self, int *fd_out)
 	return BRASERO_BURN_OK;
 }
 
+/**
+ * Moves up to len bytes from fd_in to the output of the job. Whenever
+ * possible the data doesn't go through user space (splice ()). forwarded
+ * is set to 0 at the end of the input. BRASERO_BURN_RETRY is returned when
+ * a non blocking descriptor is not ready.
+ */
+
+BraseroBurnResult
+brasero_job_forward_fd (BraseroJob *self,
+			int fd_in,
+			gsize len,
+			gsize *forwarded,
+			GError **error)
+{
+	gchar *buffer;
+	gssize read_bytes;
+	gssize total = 0;
+	int fd_out = -1;
+	int errsv;
+
+	g_return_val_if_fail (forwarded != NULL, BRASERO_BURN_ERR);
+
+	*forwarded = 0;
+	if (brasero_job_get_fd_out (self, &fd_out) != BRASERO_BURN_OK) {
+		g_set_error (error,
+			     BRASERO_BURN_ERROR,
+			     BRASERO_BURN_ERROR_GENERAL,
+			     _("An internal error occurred"));
+		return BRASERO_BURN_ERR;
+	}
+
+#ifdef SPLICE_F_MOVE
+	read_bytes = splice (fd_in,
+			     NULL,
+			     fd_out,
+			     NULL,
+			     len,
+			     SPLICE_F_MOVE|SPLICE_F_MORE);
+	if (read_bytes >= 0) {
+		*forwarded = read_bytes;
+		return BRASERO_BURN_OK;
+	}
+
+	errsv = errno;
+	if (errsv == EAGAIN || errsv == EINTR)
+		return BRASERO_BURN_RETRY;
+
+	/* Any other error than unsupported descriptors is fatal */
+	if (errsv != EINVAL && errsv != ENOSYS)
+		goto error;
+#endif
+
+	buffer = g_malloc (MIN (len, BRASERO_JOB_FORWARD_BUFFER_SIZE));
+	read_bytes = read (fd_in, buffer, MIN (len, BRASERO_JOB_FORWARD_BUFFER_SIZE));
+	if (read_bytes < 0) {
+		errsv = errno;
+		g_free (buffer);
+
+		if (errsv == EAGAIN || errsv == EINTR)
+			return BRASERO_BURN_RETRY;
+
+		goto error;
+	}
+
+	/* What was read can't be put back so write it all */
+	while (total < read_bytes) {
+		gssize written;
+
+		written = write (fd_out, buffer + total, read_bytes - total);
+		if (written < 0) {
+			errsv = errno;
+			if (errsv == EAGAIN || errsv == EINTR) {
+				g_usleep (500);
+				continue;
+			}
+
+			g_free (buffer);
+			goto error;
+		}
+
+		total += written;
+	}
+
+	g_free (buffer);
+	*forwarded = read_bytes;
+	return BRASERO_BURN_OK;
+
+error:
+
+	BRASERO_JOB_LOG (self, "data couldn't be forwarded (%s)", g_strerror (errsv));
+	g_set_error (error,
+		     BRASERO_BURN_ERROR,
+		     BRASERO_BURN_ERROR_GENERAL,
+		     _("Data could not be written (%s)"),
+		     g_strerror (errsv));
+	return BRASERO_BURN_ERR;
+}
+
 BraseroBurnResult
 brasero_job_get_image_output (BraseroJob *self,
 			      gchar **image,
@@ -193,6 +193,13 @@ brasero_job_get_output_type (BraseroJob *job, BraseroTrackType *type);
 BraseroBurnResult
 brasero_job_get_fd_out (BraseroJob *job, int *fd_out);
 
+BraseroBurnResult
+brasero_job_forward_fd (BraseroJob *job,
+			int fd_in,
+			gsize len,
+			gsize *forwarded,
+			GError **error);
+
 BraseroBurnResult
 brasero_job_get_image_output (BraseroJob *job,
 			      gchar **image,
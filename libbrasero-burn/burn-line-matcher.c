@@ -0,0 +1,264 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 8; tab-width: 8 -*- */
+/*
+ * Libbrasero-burn
+ * Copyright (C) Philippe Rouquier 2005-2009 <bonfire-app@wanadoo.fr>
+ *
+ * Libbrasero-burn is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * The Libbrasero-burn authors hereby grant permission for non-GPL compatible
+ * GStreamer plugins to be used and distributed together with GStreamer
+ * and Libbrasero-burn. This permission is above and beyond the permissions granted
+ * by the GPL license by which Libbrasero-burn is covered. If you modify this code
+ * you may extend this exception to your version of the code, but you are not
+ * obligated to do so. If you do not wish to do so, delete this exception
+ * statement from your version.
+ * 
+ * Libbrasero-burn is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to:
+ * 	The Free Software Foundation, Inc.,
+ * 	51 Franklin Street, Fifth Floor
+ * 	Boston, MA  02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <string.h>
+
+#include <glib.h>
+
+#include "burn-line-matcher.h"
+
+/**
+ * The automaton is a DFA: failure links are resolved at build time so that
+ * matching costs one table lookup per character. To keep the table small,
+ * bytes are first mapped to classes; all bytes which don't appear in any
+ * pattern share class 0 which always leads back to the root.
+ */
+
+struct _BraseroLineMatcher {
+	const BraseroLinePattern *patterns;
+	guint *lengths;
+
+	guchar classes [256];
+	guint num_classes;
+
+	guint num_states;
+	guint *next;
+
+	/* Index of the first pattern ending in a state or -1, and the next
+	 * state down the failure links that has one (0 for none) */
+	gint *output;
+	guint *dict;
+
+	/* Index of the next pattern with the same string or -1 */
+	gint *same;
+};
+
+static guint
+brasero_line_matcher_add_state (BraseroLineMatcher *self)
+{
+	guint state;
+	guint i;
+
+	state = self->num_states ++;
+	for (i = 0; i < self->num_classes; i ++)
+		self->next [state * self->num_classes + i] = G_MAXUINT;
+
+	self->output [state] = -1;
+	self->dict [state] = 0;
+	return state;
+}
+
+static void
+brasero_line_matcher_build_links (BraseroLineMatcher *self)
+{
+	guint *fail;
+	guint *queue;
+	guint head, tail;
+	guint c;
+
+	fail = g_new0 (guint, self->num_states);
+	queue = g_new (guint, self->num_states);
+	head = tail = 0;
+
+	/* Direct children of the root fail to the root */
+	for (c = 0; c < self->num_classes; c ++) {
+		guint child;
+
+		child = self->next [c];
+		if (child == G_MAXUINT)
+			self->next [c] = 0;
+		else
+			queue [tail ++] = child;
+	}
+
+	/* Breadth first so that the failure state of a state is complete
+	 * before it is used */
+	while (head < tail) {
+		guint state;
+
+		state = queue [head ++];
+		for (c = 0; c < self->num_classes; c ++) {
+			guint *child;
+			guint target;
+
+			child = self->next + state * self->num_classes + c;
+			target = self->next [fail [state] * self->num_classes + c];
+			if (*child == G_MAXUINT) {
+				*child = target;
+				continue;
+			}
+
+			fail [*child] = target;
+			if (self->output [target] >= 0)
+				self->dict [*child] = target;
+			else
+				self->dict [*child] = self->dict [target];
+
+			queue [tail ++] = *child;
+		}
+	}
+
+	g_free (queue);
+	g_free (fail);
+}
+
+BraseroLineMatcher *
+brasero_line_matcher_new (const BraseroLinePattern *patterns,
+			  guint num_patterns)
+{
+	BraseroLineMatcher *self;
+	guint max_states = 1;
+	guint i;
+
+	self = g_new0 (BraseroLineMatcher, 1);
+	self->patterns = patterns;
+	self->lengths = g_new (guint, num_patterns);
+	self->same = g_new (gint, num_patterns);
+
+	/* Give a class to every byte used in a pattern */
+	self->num_classes = 1;
+	for (i = 0; i < num_patterns; i ++) {
+		const guchar *iter;
+
+		self->lengths [i] = strlen (patterns [i].pattern);
+		max_states += self->lengths [i];
+
+		for (iter = (const guchar *) patterns [i].pattern; *iter; iter ++) {
+			if (!self->classes [*iter])
+				self->classes [*iter] = self->num_classes ++;
+		}
+	}
+
+	self->next = g_new (guint, max_states * self->num_classes);
+	self->output = g_new (gint, max_states);
+	self->dict = g_new (guint, max_states);
+	brasero_line_matcher_add_state (self);
+
+	/* Build the trie */
+	for (i = 0; i < num_patterns; i ++) {
+		const guchar *iter;
+		guint state = 0;
+
+		for (iter = (const guchar *) patterns [i].pattern; *iter; iter ++) {
+			guint *child;
+
+			child = self->next + state * self->num_classes + self->classes [*iter];
+			if (*child == G_MAXUINT)
+				*child = brasero_line_matcher_add_state (self);
+
+			state = *child;
+		}
+
+		self->same [i] = -1;
+		if (!state)
+			continue;
+
+		/* The same string can be used with another type; keep them all
+		 * in the order of the table */
+		if (self->output [state] >= 0) {
+			gint last;
+
+			for (last = self->output [state]; self->same [last] >= 0; last = self->same [last]);
+			self->same [last] = i;
+		}
+		else
+			self->output [state] = i;
+	}
+
+	brasero_line_matcher_build_links (self);
+	return self;
+}
+
+void
+brasero_line_matcher_free (BraseroLineMatcher *self)
+{
+	if (!self)
+		return;
+
+	g_free (self->lengths);
+	g_free (self->next);
+	g_free (self->output);
+	g_free (self->dict);
+	g_free (self->same);
+	g_free (self);
+}
+
+/**
+ * Returns the id of the first pattern in the table found in line or -1.
+ */
+
+gint
+brasero_line_matcher_match (BraseroLineMatcher *self,
+			    const gchar *line)
+{
+	const guchar *iter;
+	gint best = -1;
+	guint state = 0;
+	guint pos;
+
+	for (iter = (const guchar *) line, pos = 1; *iter; iter ++, pos ++) {
+		guint match;
+
+		state = self->next [state * self->num_classes + self->classes [*iter]];
+		if (!state)
+			continue;
+
+		match = self->output [state] >= 0 ? state:self->dict [state];
+		for (; match; match = self->dict [match]) {
+			gint index;
+
+			for (index = self->output [match]; index >= 0; index = self->same [index]) {
+				/* A prefix must end where it started from the start */
+				if (self->patterns [index].type == BRASERO_LINE_MATCH_PREFIX
+				&&  self->lengths [index] != pos)
+					continue;
+
+				if (best < 0 || index < best)
+					best = index;
+
+				/* The others come later in the table */
+				break;
+			}
+		}
+
+		/* Nothing can beat the first pattern */
+		if (best == 0)
+			break;
+	}
+
+	if (best < 0)
+		return -1;
+
+	return self->patterns [best].id;
+}
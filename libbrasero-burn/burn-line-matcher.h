@@ -0,0 +1,72 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 8; tab-width: 8 -*- */
+/*
+ * Libbrasero-burn
+ * Copyright (C) Philippe Rouquier 2005-2009 <bonfire-app@wanadoo.fr>
+ *
+ * Libbrasero-burn is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * The Libbrasero-burn authors hereby grant permission for non-GPL compatible
+ * GStreamer plugins to be used and distributed together with GStreamer
+ * and Libbrasero-burn. This permission is above and beyond the permissions granted
+ * by the GPL license by which Libbrasero-burn is covered. If you modify this code
+ * you may extend this exception to your version of the code, but you are not
+ * obligated to do so. If you do not wish to do so, delete this exception
+ * statement from your version.
+ * 
+ * Libbrasero-burn is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to:
+ * 	The Free Software Foundation, Inc.,
+ * 	51 Franklin Street, Fifth Floor
+ * 	Boston, MA  02110-1301, USA.
+ */
+
+#ifndef _BURN_LINE_MATCHER_H
+#define _BURN_LINE_MATCHER_H
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/**
+ * Finds which of a set of patterns appears in a line of output in a single
+ * pass over the line (Aho-Corasick). When several patterns match, the one
+ * which comes first in the table wins so that a table can replace a chain of
+ * if (strstr ()) / else if (strstr ()) and keep its priorities.
+ */
+
+typedef enum {
+	BRASERO_LINE_MATCH_CONTAINS	= 0,
+	BRASERO_LINE_MATCH_PREFIX	= 1
+} BraseroLineMatchType;
+
+typedef struct _BraseroLinePattern BraseroLinePattern;
+struct _BraseroLinePattern {
+	const gchar *pattern;
+	BraseroLineMatchType type;
+	gint id;
+};
+
+typedef struct _BraseroLineMatcher BraseroLineMatcher;
+
+BraseroLineMatcher *
+brasero_line_matcher_new (const BraseroLinePattern *patterns,
+			  guint num_patterns);
+
+void
+brasero_line_matcher_free (BraseroLineMatcher *matcher);
+
+gint
+brasero_line_matcher_match (BraseroLineMatcher *matcher,
+			    const gchar *line);
+
+G_END_DECLS
+
+#endif /* _BURN_LINE_MATCHER_H */
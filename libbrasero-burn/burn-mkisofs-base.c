@@ -51,12 +51,23 @@
 #include "brasero-track.h"
 #include "burn-mkisofs-base.h"
 
+/* Lines are accumulated and written by blocks of that size */
+#define BRASERO_MKISOFS_BASE_BUFFER_SIZE	65536
+
+struct _BraseroMkisofsList {
+	gint fd;
+	GString *buffer;
+
+	guint has_lines:1;
+};
+typedef struct _BraseroMkisofsList BraseroMkisofsList;
+
 struct _BraseroMkisofsBase {
 	const gchar *emptydir;
 	const gchar *videodir;
 
-	gint grafts_fd;
-	gint excluded_fd;
+	BraseroMkisofsList grafts_list;
+	BraseroMkisofsList excluded_list;
 
 	GHashTable *grafts;
 
@@ -71,6 +82,69 @@ struct _BraseroWriteGraftData {
 };
 typedef struct _BraseroWriteGraftData BraseroWriteGraftData;
 
+static BraseroBurnResult
+_open_list (BraseroMkisofsList *list,
+	    const gchar *path,
+	    GError **error)
+{
+	list->fd = open (path, O_WRONLY|O_TRUNC|O_EXCL);
+	if (list->fd == -1) {
+		g_set_error (error,
+			     BRASERO_BURN_ERROR,
+			     BRASERO_BURN_ERROR_GENERAL,
+			     "%s",
+			     g_strerror (errno));
+		return BRASERO_BURN_ERR;
+	}
+
+	list->buffer = g_string_sized_new (BRASERO_MKISOFS_BASE_BUFFER_SIZE);
+	return BRASERO_BURN_OK;
+}
+
+static void
+_close_list (BraseroMkisofsList *list)
+{
+	if (list->fd > 0) {
+		close (list->fd);
+		list->fd = -1;
+	}
+
+	if (list->buffer) {
+		g_string_free (list->buffer, TRUE);
+		list->buffer = NULL;
+	}
+}
+
+static BraseroBurnResult
+_flush_list (BraseroMkisofsList *list, GError **error)
+{
+	gsize written = 0;
+
+	while (written < list->buffer->len) {
+		gssize w_len;
+
+		w_len = write (list->fd,
+			       list->buffer->str + written,
+			       list->buffer->len - written);
+		if (w_len < 0) {
+			if (errno == EINTR)
+				continue;
+
+			g_set_error (error,
+				     BRASERO_BURN_ERROR,
+				     BRASERO_BURN_ERROR_GENERAL,
+				     "%s",
+				     g_strerror (errno));
+			return BRASERO_BURN_ERR;
+		}
+
+		written += w_len;
+	}
+
+	g_string_truncate (list->buffer, 0);
+	return BRASERO_BURN_OK;
+}
+
 static void
 brasero_mkisofs_base_clean (BraseroMkisofsBase *base)
 {
@@ -78,10 +152,8 @@ brasero_mkisofs_base_clean (BraseroMkisofsBase *base)
 	 * graft and excluded list, flags and that's what
 	 * we're going to use when we'll start the image 
 	 * creation */
-	if (base->grafts_fd)
-		close (base->grafts_fd);
-	if (base->excluded_fd)
-		close (base->excluded_fd);
+	_close_list (&base->grafts_list);
+	_close_list (&base->excluded_list);
 	if (base->grafts) {
 		g_hash_table_destroy (base->grafts);
 		base->grafts = NULL;
@@ -89,34 +161,19 @@ brasero_mkisofs_base_clean (BraseroMkisofsBase *base)
 }
 
 static BraseroBurnResult
-_write_line (int fd, const gchar *filepath, GError **error)
+_write_line (BraseroMkisofsList *list, const gchar *filepath, GError **error)
 {
-	gint len;
-	gint w_len;
+	/* Lines are separated, not terminated, by a newline */
+	if (list->has_lines)
+		g_string_append_c (list->buffer, '\n');
 
-	if (lseek (fd, 0, SEEK_CUR)
-	&&  write (fd, "\n", 1) != 1) {
-		g_set_error (error,
-			     BRASERO_BURN_ERROR,
-			     BRASERO_BURN_ERROR_GENERAL,
-			     "%s",
-			     g_strerror (errno));
-		return BRASERO_BURN_ERR;
-	}
+	g_string_append (list->buffer, filepath);
+	list->has_lines = TRUE;
 
-	len = strlen (filepath);
-	w_len = write (fd, filepath, len);
-
-	if (w_len != len) {
-		g_set_error (error,
-			     BRASERO_BURN_ERROR,
-			     BRASERO_BURN_ERROR_GENERAL,
-			     "%s",
-			     g_strerror (errno));
-		return BRASERO_BURN_ERR;
-	}
+	if (list->buffer->len < BRASERO_MKISOFS_BASE_BUFFER_SIZE)
+		return BRASERO_BURN_OK;
 
-	return BRASERO_BURN_OK;
+	return _flush_list (list, error);
 }
 
 static BraseroBurnResult
@@ -202,7 +259,7 @@ brasero_mkisofs_base_write_excluded (BraseroMkisofsBase *base,
 	/* we just ignore if localpath is NULL:
 	 * - it could be a non local whose graft point couldn't be downloaded */
 	if (localpath)
-		result = _write_line (base->excluded_fd, localpath, error);
+		result = _write_line (&base->excluded_list, localpath, error);
 
 	g_free (localpath);
 	return result;
@@ -303,7 +360,7 @@ brasero_mkisofs_base_write_graft (BraseroMkisofsBase *base,
 		return BRASERO_BURN_ERR;
 	}
 
-	result = _write_line (base->grafts_fd, graft_point, error);
+	result = _write_line (&base->grafts_list, graft_point, error);
 	g_free (graft_point);
 	if (result != BRASERO_BURN_OK)
 		return result;
@@ -415,7 +472,7 @@ brasero_mkisofs_base_empty_directory (BraseroMkisofsBase *base,
 
 	/* Special case for uri = NULL; that is treated as if it were a directory */
 	graft_point = _build_graft_point (base->emptydir, disc_path);
-	result = _write_line (base->grafts_fd, graft_point, error);
+	result = _write_line (&base->grafts_list, graft_point, error);
 	g_free (graft_point);
 
 	return result;
@@ -575,25 +632,14 @@ brasero_mkisofs_base_write_to_files (GSList *grafts,
 	/* initialize base */
 	bzero (&base, sizeof (base));
 
-	base.grafts_fd = open (grafts_path, O_WRONLY|O_TRUNC|O_EXCL);
-	if (base.grafts_fd == -1) {
-		g_set_error (error,
-			     BRASERO_BURN_ERROR,
-			     BRASERO_BURN_ERROR_GENERAL,
-			     "%s",
-			     g_strerror (errno));
-		return BRASERO_BURN_ERR;
-	}
+	result = _open_list (&base.grafts_list, grafts_path, error);
+	if (result != BRASERO_BURN_OK)
+		return result;
 
-	base.excluded_fd = open (excluded_path, O_WRONLY|O_TRUNC|O_EXCL);
-	if (base.excluded_fd == -1) {
-		close (base.excluded_fd);
-		g_set_error (error,
-			     BRASERO_BURN_ERROR,
-			     BRASERO_BURN_ERROR_GENERAL,
-			     "%s",
-			     g_strerror (errno));
-		return BRASERO_BURN_ERR;
+	result = _open_list (&base.excluded_list, excluded_path, error);
+	if (result != BRASERO_BURN_OK) {
+		_close_list (&base.grafts_list);
+		return result;
 	}
 
 	base.use_joliet = use_joliet;
@@ -642,7 +688,8 @@ brasero_mkisofs_base_write_to_files (GSList *grafts,
 			     BRASERO_BURN_ERROR,
 			     BRASERO_BURN_ERROR_GENERAL,
 			     _("VIDEO_TS directory is missing or invalid"));
-		return BRASERO_BURN_ERR;
+		result = BRASERO_BURN_ERR;
+		goto cleanup;
 	}
 
 	/* write the grafts list */
@@ -665,6 +712,14 @@ brasero_mkisofs_base_write_to_files (GSList *grafts,
 			goto cleanup;
 	}
 
+	result = _flush_list (&base.grafts_list, error);
+	if (result != BRASERO_BURN_OK)
+		goto cleanup;
+
+	result = _flush_list (&base.excluded_list, error);
+	if (result != BRASERO_BURN_OK)
+		goto cleanup;
+
 	brasero_mkisofs_base_clean (&base);
 	return BRASERO_BURN_OK;
 
@@ -146,6 +146,27 @@ enum
 static GTypeModuleClass* parent_class = NULL;
 static guint plugin_signals [LAST_SIGNAL] = { 0 };
 
+/* Bumped whenever the state of any plugin changes (activation, priority,
+ * errors) so that cached caps queries can be discarded */
+static gint plugin_generation = 0;
+
+static void
+brasero_plugin_state_changed (void)
+{
+	g_atomic_int_inc (&plugin_generation);
+}
+
+/**
+ * brasero_plugin_get_generation:
+ *
+ * Returns a number that changes every time the state of a plugin changes.
+ **/
+guint
+brasero_plugin_get_generation (void)
+{
+	return g_atomic_int_get (&plugin_generation);
+}
+
 static void
 brasero_plugin_error_free (BraseroPluginError *error)
 {
@@ -170,6 +191,7 @@ brasero_plugin_add_error (BraseroPlugin *plugin,
 	error->type = type;
 
 	priv->errors = g_slist_prepend (priv->errors, error);
+	brasero_plugin_state_changed ();
 }
 
 void
@@ -330,6 +352,8 @@ brasero_plugin_set_active (BraseroPlugin *self, gboolean active)
 	if (was_active == now_active)
 		return;
 
+	brasero_plugin_state_changed ();
+
 	BRASERO_BURN_LOG ("Plugin %s is %s",
 			  brasero_plugin_get_name (self),
 			  now_active?"active":"inactive");
@@ -1185,6 +1209,7 @@ brasero_plugin_priority_changed (GSettings *settings,
 
 	/* At the moment it can only be the priority key */
 	priv->priority = g_settings_get_int (settings, BRASERO_PROPS_PRIORITY_KEY);
+	brasero_plugin_state_changed ();
 
 	is_active = brasero_plugin_get_active (self, FALSE);
 
@@ -1223,6 +1248,10 @@ brasero_plugin_check_plugin_ready (BraseroPlugin *plugin)
 		priv->errors = NULL;
 	}
 
+	/* The plugin may have registered new caps or have had its errors
+	 * fixed */
+	brasero_plugin_state_changed ();
+
 	handle = g_module_open (priv->path, 0);
 	if (!handle) {
 		brasero_plugin_add_error (plugin, BRASERO_PLUGIN_ERROR_MODULE, g_module_error ());
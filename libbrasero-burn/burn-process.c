@@ -327,6 +327,75 @@ brasero_process_watch_child (gpointer data)
 	return FALSE;
 }
 
+/**
+ * Output is read by chunks into the channel buffer which is reused. It is
+ * then split in place into lines which are passed to readfunc. Progress lines
+ * end with '\r' or '\b' (cdrecord/cdrdao) rather than '\n'.
+ */
+
+#define BRASERO_PROCESS_READ_CHUNK	4096
+
+static gboolean
+brasero_process_is_line_end (const gchar *str,
+			     gsize len,
+			     gsize *term_len)
+{
+	switch (str [0]) {
+	case '\b':
+	case '\n':
+	case '\r':
+	case '\0':
+		*term_len = 1;
+		return TRUE;
+
+	case '\xe2':
+		/* Unicode paragraph separator U+2029 */
+		if (len >= 3 && str [1] == '\x80' && str [2] == '\xa9') {
+			*term_len = 3;
+			return TRUE;
+		}
+		return FALSE;
+
+	default:
+		return FALSE;
+	}
+}
+
+static GString *
+brasero_process_get_buffer (BraseroProcess *process,
+			    gint channel_type)
+{
+	BraseroProcessPrivate *priv = BRASERO_PROCESS_PRIVATE (process);
+
+	/* a subclass could have stopped or errored out.
+	 * in this case brasero_process_stop will have 
+	 * been called and the buffer deallocated. So we
+	 * always get it again after calling readfunc */
+	if (channel_type == BRASERO_CHANNEL_STDERR)
+		return priv->err_buffer;
+
+	return priv->out_buffer;
+}
+
+static BraseroBurnResult
+brasero_process_read_line (BraseroProcess *process,
+			   gchar *line,
+			   gint channel_type,
+			   BraseroProcessReadFunc readfunc)
+{
+	if (line [0] == '\0')
+		return BRASERO_BURN_OK;
+
+	BRASERO_JOB_LOG (process,
+			 debug_prefixes [channel_type],
+			 line);
+
+	if (readfunc)
+		return readfunc (process, line);
+
+	return BRASERO_BURN_OK;
+}
+
 static gboolean
 brasero_process_read (BraseroProcess *process,
 		      GIOChannel *channel,
@@ -336,121 +405,97 @@ brasero_process_read (BraseroProcess *process,
 {
 	GString *buffer;
 	GIOStatus status;
+	gsize bytes_read = 0;
+	gsize start, i, len;
 	BraseroBurnResult result = BRASERO_BURN_OK;
-	BraseroProcessPrivate *priv = BRASERO_PROCESS_PRIVATE (process);
 
 	if (!channel)
 		return FALSE;
 
-	if (channel_type == BRASERO_CHANNEL_STDERR)
-		buffer = priv->err_buffer;
-	else
-		buffer = priv->out_buffer;
-
-	if (condition & G_IO_IN) {
-		gsize term;
-		gchar *line = NULL;
-
-		status = g_io_channel_read_line (channel,
-						 &line,
-						 &term,
-						 NULL,
-						 NULL);
-
-		if (status == G_IO_STATUS_AGAIN) {
-			gchar character;
-			/* there wasn't any character ending the line.
-			 * some processes (like cdrecord/cdrdao) produce an
-			 * extra character sometimes */
-			status = g_io_channel_read_chars (channel,
-							  &character,
-							  1,
-							  NULL,
-							  NULL);
-
-			if (status == G_IO_STATUS_NORMAL) {
-				g_string_append_c (buffer, character);
-
-				switch (character) {
-				case '\b':
-				case '\n':
-				case '\r':
-				case '\xe2': /* Unicode paragraph separator */
-				case '\0':
-					BRASERO_JOB_LOG (process,
-							 debug_prefixes [channel_type],
-							 buffer->str);
-
-					if (readfunc && buffer->str [0] != '\0')
-						result = readfunc (process, buffer->str);
-
-					/* a subclass could have stopped or errored out.
-					 * in this case brasero_process_stop will have 
-					 * been called and the buffer deallocated. So we
-					 * check that it still exists */
-					if (channel_type == BRASERO_CHANNEL_STDERR)
-						buffer = priv->err_buffer;
-					else
-						buffer = priv->out_buffer;
-
-					if (buffer)
-						g_string_set_size (buffer, 0);
-
-					if (result != BRASERO_BURN_OK)
-						return FALSE;
-
-					break;
-				default:
-					break;
-				}
-			}
-		}
-		else if (status == G_IO_STATUS_NORMAL) {
-			if (term)
-				line [term - 1] = '\0';
-
-			g_string_append (buffer, line);
-			g_free (line);
+	buffer = brasero_process_get_buffer (process, channel_type);
+	if (!buffer)
+		return FALSE;
 
+	if (!(condition & G_IO_IN)) {
+		if (condition & G_IO_HUP) {
+			/* only handle the HUP when we have read all available lines of output */
 			BRASERO_JOB_LOG (process,
 					 debug_prefixes [channel_type],
-					 buffer->str);
+					 "HUP");
+			return FALSE;
+		}
 
-			if (readfunc && buffer->str [0] != '\0')
-				result = readfunc (process, buffer->str);
+		return TRUE;
+	}
 
-			/* a subclass could have stopped or errored out.
-			 * in this case brasero_process_stop will have 
-			 * been called and the buffer deallocated. So we
-			 * check that it still exists */
-			if (channel_type == BRASERO_CHANNEL_STDERR)
-				buffer = priv->err_buffer;
-			else
-				buffer = priv->out_buffer;
+	/* Append a new chunk after what's left of the last line */
+	len = buffer->len;
+	g_string_set_size (buffer, len + BRASERO_PROCESS_READ_CHUNK);
+	status = g_io_channel_read_chars (channel,
+					  buffer->str + len,
+					  BRASERO_PROCESS_READ_CHUNK,
+					  &bytes_read,
+					  NULL);
+	g_string_set_size (buffer, len + bytes_read);
 
-			if (buffer)
-				g_string_set_size (buffer, 0);
+	if (status == G_IO_STATUS_AGAIN)
+		return TRUE;
 
-			if (result != BRASERO_BURN_OK)
-				return FALSE;
-		}
-		else if (status == G_IO_STATUS_EOF) {
-			BRASERO_JOB_LOG (process, 
-					 debug_prefixes [channel_type],
-					 "EOF");
-			return FALSE;
-		}
-		else
-			return FALSE;
-	}
-	else if (condition & G_IO_HUP) {
-		/* only handle the HUP when we have read all available lines of output */
-		BRASERO_JOB_LOG (process,
+	if (status == G_IO_STATUS_EOF) {
+		/* Flush the last line if it had no end */
+		if (buffer->len)
+			brasero_process_read_line (process,
+						   buffer->str,
+						   channel_type,
+						   readfunc);
+
+		buffer = brasero_process_get_buffer (process, channel_type);
+		if (buffer)
+			g_string_set_size (buffer, 0);
+
+		BRASERO_JOB_LOG (process, 
 				 debug_prefixes [channel_type],
-				 "HUP");
+				 "EOF");
 		return FALSE;
 	}
 
+	if (status != G_IO_STATUS_NORMAL)
+		return FALSE;
+
+	/* Only the new bytes need to be scanned (and the two before in case
+	 * they are the beginning of a paragraph separator) */
+	start = 0;
+	for (i = len > 2 ? len - 2 : 0; i < buffer->len; i ++) {
+		gsize term_len;
+
+		if (!brasero_process_is_line_end (buffer->str + i,
+						  buffer->len - i,
+						  &term_len))
+			continue;
+
+		buffer->str [i] = '\0';
+		result = brasero_process_read_line (process,
+						    buffer->str + start,
+						    channel_type,
+						    readfunc);
+
+		buffer = brasero_process_get_buffer (process, channel_type);
+		if (!buffer)
+			return FALSE;
+
+		if (result != BRASERO_BURN_OK) {
+			g_string_set_size (buffer, 0);
+			return FALSE;
+		}
+
+		i += term_len - 1;
+		start = i + 1;
+	}
+
+	/* Keep the beginning of the next line */
+	if (start)
+		g_string_erase (buffer, 0, start);
+
 	return TRUE;
 }
 
@@ -79,6 +79,7 @@ struct _BraseroTaskCtxPrivate
 	/* used for remaining time */
 	GSList *times;
 	gdouble total_time;
+	gdouble last_time;
 
 	/* used for rates that certain jobs are able to report */
 	guint64 rate;
@@ -104,6 +105,11 @@ G_DEFINE_TYPE (BraseroTaskCtx, brasero_task_ctx, G_TYPE_OBJECT);
 
 #define MAX_VALUE_AVERAGE	16
 
+/* Progress is reported as soon as it changes and not only on clock ticks so
+ * the samples for the remaining time are taken at most every 500 ms. That
+ * way MAX_VALUE_AVERAGE of them still cover the last 8 seconds. */
+#define AVERAGE_INTERVAL	0.5
+
 enum _BraseroTaskCtxSignalType {
 	ACTION_CHANGED_SIGNAL,
 	PROGRESS_CHANGED_SIGNAL,
@@ -474,6 +480,16 @@ brasero_task_ctx_get_average (GSList **values, gdouble value)
 	return average;
 }
 
+static void
+brasero_task_ctx_changed (BraseroTaskCtx *self)
+{
+	BraseroTaskCtxClass *klass;
+
+	klass = BRASERO_TASK_CTX_GET_CLASS (self);
+	if (klass->changed)
+		klass->changed (self);
+}
+
 void
 brasero_task_ctx_report_progress (BraseroTaskCtx *self)
 {
@@ -529,7 +545,10 @@ brasero_task_ctx_report_progress (BraseroTaskCtx *self)
 
 	if (priv->timer) {
 		elapsed = g_timer_elapsed (priv->timer, NULL);
-		if (brasero_task_ctx_get_progress (self, &progress) == BRASERO_BURN_OK) {
+		if ((!priv->times
+		||    elapsed < priv->last_time
+		||    elapsed - priv->last_time >= AVERAGE_INTERVAL)
+		&&  brasero_task_ctx_get_progress (self, &progress) == BRASERO_BURN_OK) {
 			gdouble total_time;
 
 			total_time = (gdouble) elapsed / (gdouble) progress;
@@ -537,6 +556,7 @@ brasero_task_ctx_report_progress (BraseroTaskCtx *self)
 			g_mutex_lock (priv->lock);
 			priv->total_time = brasero_task_ctx_get_average (&priv->times,
 									 total_time);
+			priv->last_time = elapsed;
 			g_mutex_unlock (priv->lock);
 		}
 	}
@@ -616,6 +636,7 @@ brasero_task_ctx_set_written_track (BraseroTaskCtx *self,
 	priv = BRASERO_TASK_CTX_PRIVATE (self);
 
 	priv->written_changed = 1;
+	brasero_task_ctx_changed (self);
 
 	if (priv->use_average_rate) {
 		priv->track_bytes = written;
@@ -661,6 +682,7 @@ brasero_task_ctx_set_progress (BraseroTaskCtx *self,
 	priv = BRASERO_TASK_CTX_PRIVATE (self);
 
 	priv->progress_changed = 1;
+	brasero_task_ctx_changed (self);
 
 	if (priv->use_average_rate) {
 		if (priv->progress < progress)
@@ -766,6 +788,8 @@ brasero_task_ctx_set_current_action (BraseroTaskCtx *self,
 
 	g_mutex_unlock (priv->lock);
 
+	brasero_task_ctx_changed (self);
+
 	return BRASERO_BURN_OK;
 }
 
@@ -63,6 +63,10 @@ struct _BraseroTaskCtxClass
 							 BraseroBurnResult retval,
 							 GError *error);
 
+	/* Called whenever a job reports progress or a new action. It can be
+	 * called from the thread of a job. */
+	void			(* changed)		(BraseroTaskCtx *ctx);
+
 	/* signals */
 	void			(*progress_changed)	(BraseroTaskCtx *task,
 							 gdouble fraction,
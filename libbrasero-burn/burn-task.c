@@ -58,8 +58,14 @@ struct _BraseroTaskPrivate {
 	/* The loop for the task */
 	GMainLoop *loop;
 
-	/* used to poll for progress (every 0.5 sec) */
+	/* used to poll for progress; the interval grows from
+	 * BRASERO_TASK_CLOCK_MIN to BRASERO_TASK_CLOCK_MAX */
 	gint clock_id;
+	guint clock_interval;
+
+	/* progress reported by jobs themselves is coalesced */
+	gint update_pending;
+	gint64 last_update;
 
 	BraseroTaskItem *leader;
 	BraseroTaskItem *first;
@@ -74,8 +80,18 @@ G_DEFINE_TYPE (BraseroTask, brasero_task, BRASERO_TYPE_TASK_CTX);
 
 static GObjectClass *parent_class = NULL;
 
-#define MAX_JOB_START_ATTEMPTS			5
-#define JOB_ATTEMPTS_WAIT_TIME			1
+/* Jobs returning BRASERO_BURN_RETRY from ::start are retried after a delay
+ * that doubles each time until they have been given JOB_START_WAIT_TOTAL */
+#define JOB_START_WAIT_MIN			100	/* ms */
+#define JOB_START_WAIT_MAX			1000	/* ms */
+#define JOB_START_WAIT_TOTAL			5000	/* ms */
+
+/* Polling is fast at first so that short jobs don't wait for a whole tick */
+#define BRASERO_TASK_CLOCK_MIN			100	/* ms */
+#define BRASERO_TASK_CLOCK_MAX			500	/* ms */
+
+/* Maximum rate at which progress is reported */
+#define BRASERO_TASK_UPDATE_INTERVAL		100	/* ms */
 
 void
 brasero_task_add_item (BraseroTask *task, BraseroTaskItem *item)
@@ -111,6 +127,8 @@ brasero_task_reset_real (BraseroTask *task)
 
 	priv->loop = NULL;
 	priv->clock_id = 0;
+	priv->clock_interval = 0;
+	priv->last_update = 0;
 	priv->retval = BRASERO_BURN_OK;
 
 	if (priv->error) {
@@ -156,9 +174,62 @@ brasero_task_clock_tick (gpointer data)
 	}
 
 	/* now call ctx to update progress */
+	priv->last_update = g_get_monotonic_time ();
 	brasero_task_ctx_report_progress (BRASERO_TASK_CTX (data));
 
-	return TRUE;
+	if (priv->clock_interval >= BRASERO_TASK_CLOCK_MAX)
+		return TRUE;
+
+	/* Slow down progressively */
+	priv->clock_interval = MIN (priv->clock_interval * 2, BRASERO_TASK_CLOCK_MAX);
+	priv->clock_id = g_timeout_add (priv->clock_interval,
+					brasero_task_clock_tick,
+					task);
+	return FALSE;
+}
+
+static gboolean
+brasero_task_update (gpointer data)
+{
+	BraseroTask *task = BRASERO_TASK (data);
+	BraseroTaskPrivate *priv;
+
+	priv = BRASERO_TASK_PRIVATE (task);
+
+	g_atomic_int_set (&priv->update_pending, FALSE);
+	if (!brasero_task_is_running (task))
+		return FALSE;
+
+	priv->last_update = g_get_monotonic_time ();
+	brasero_task_ctx_report_progress (BRASERO_TASK_CTX (task));
+	return FALSE;
+}
+
+static void
+brasero_task_changed (BraseroTaskCtx *ctx)
+{
+	BraseroTaskPrivate *priv;
+	gint64 elapsed;
+	guint delay;
+
+	priv = BRASERO_TASK_PRIVATE (ctx);
+
+	/* Only one update at a time, no more often than the interval */
+	if (!g_atomic_int_compare_and_exchange (&priv->update_pending, FALSE, TRUE))
+		return;
+
+	elapsed = (g_get_monotonic_time () - priv->last_update) / 1000;
+	if (elapsed >= 0 && elapsed < BRASERO_TASK_UPDATE_INTERVAL)
+		delay = BRASERO_TASK_UPDATE_INTERVAL - elapsed;
+	else
+		delay = 0;
+
+	/* This may be called from a thread so hold a reference */
+	g_timeout_add_full (G_PRIORITY_DEFAULT,
+			    delay,
+			    brasero_task_update,
+			    g_object_ref (ctx),
+			    g_object_unref);
 }
 
 /**
@@ -248,18 +319,18 @@ brasero_task_wakeup (gpointer user_data)
 }
 
 static BraseroBurnResult
-brasero_task_sleep (BraseroTask *self, guint sec)
+brasero_task_sleep (BraseroTask *self, guint msec)
 {
 	BraseroTaskPrivate *priv;
 
 	priv = BRASERO_TASK_PRIVATE (self);
 
-	BRASERO_BURN_LOG ("wait loop");
+	BRASERO_BURN_LOG ("wait loop (%u ms)", msec);
 
 	priv->loop = g_main_loop_new (NULL, FALSE);
-	priv->clock_id = g_timeout_add_seconds (sec,
-	                                        brasero_task_wakeup,
-	                                        self);
+	priv->clock_id = g_timeout_add (msec,
+	                                brasero_task_wakeup,
+	                                self);
 
 	GDK_THREADS_LEAVE ();  
 	g_main_loop_run (priv->loop);
@@ -281,7 +352,8 @@ brasero_task_start_item (BraseroTask *task,
 			 BraseroTaskItem *item,
 			 GError **error)
 {
-	guint attempts = 0;
+	guint waited = 0;
+	guint wait = JOB_START_WAIT_MIN;
 	BraseroBurnResult result;
 	GError *ret_error = NULL;
 	BraseroTaskItemIFace *klass;
@@ -295,7 +367,7 @@ brasero_task_start_item (BraseroTask *task,
 	result = klass->start (item, &ret_error);
 	while (result == BRASERO_BURN_RETRY) {
 		/* FIXME: a GError?? */
-		if (attempts >= MAX_JOB_START_ATTEMPTS) {
+		if (waited >= JOB_START_WAIT_TOTAL) {
 			if (ret_error)
 				g_propagate_error (error, ret_error);
 
@@ -307,11 +379,12 @@ brasero_task_start_item (BraseroTask *task,
 			ret_error = NULL;
 		}
 
-		result = brasero_task_sleep (task, 1);
+		result = brasero_task_sleep (task, wait);
 		if (result != BRASERO_BURN_OK)
 			return result;
 
-		attempts ++;
+		waited += wait;
+		wait = MIN (wait * 2, JOB_START_WAIT_MAX);
 		result = klass->start (item, &ret_error);
 	}
 
@@ -428,9 +501,11 @@ brasero_task_run_loop (BraseroTask *self,
 
 	priv = BRASERO_TASK_PRIVATE (self);
 
+	priv->last_update = g_get_monotonic_time ();
 	brasero_task_ctx_report_progress (BRASERO_TASK_CTX (self));
 
-	priv->clock_id = g_timeout_add (500,
+	priv->clock_interval = BRASERO_TASK_CLOCK_MIN;
+	priv->clock_id = g_timeout_add (priv->clock_interval,
 					brasero_task_clock_tick,
 					self);
 
@@ -694,6 +769,7 @@ brasero_task_class_init (BraseroTaskClass *klass)
 	object_class->finalize = brasero_task_finalize;
 
 	ctx_class->finished = brasero_task_finished;
+	ctx_class->changed = brasero_task_changed;
 }
 
 static void
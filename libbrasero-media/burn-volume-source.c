@@ -44,6 +44,12 @@
 #include "scsi-mmc1.h"
 #include "scsi-mmc2.h"
 #include "scsi-sbc.h"
+#include "scsi-queue.h"
+
+/* Reads of more blocks than that from a device are split into commands of
+ * that size which are all kept in flight at the same time */
+#define BRASERO_VOL_SRC_CHUNK_BLOCKS		32
+#define BRASERO_VOL_SRC_QUEUE_DEPTH		8
 
 static gint64
 brasero_volume_source_seek_device_handle (BraseroVolSrc *src,
@@ -116,6 +122,106 @@ brasero_volume_source_read_fd (BraseroVolSrc *src,
 	return TRUE;
 }
 
+static gboolean
+brasero_volume_source_readcd_device_handle (BraseroVolSrc *src,
+					    gchar *buffer,
+					    guint blocks,
+					    GError **error);
+
+/**
+ * Returns TRUE if all blocks could be read with queued commands. Otherwise
+ * the caller should issue a single synchronous command which also takes
+ * care of finding the right track mode.
+ */
+
+static gboolean
+brasero_volume_source_read_queued (BraseroVolSrc *src,
+				   gchar *buffer,
+				   guint blocks)
+{
+	BraseroScsiQueue *queue;
+	gboolean success = TRUE;
+	guint num_chunks;
+	guint submitted;
+
+	queue = brasero_scsi_queue_new (src->data, BRASERO_VOL_SRC_QUEUE_DEPTH, NULL);
+	if (!queue)
+		return FALSE;
+
+	num_chunks = (blocks + BRASERO_VOL_SRC_CHUNK_BLOCKS - 1) / BRASERO_VOL_SRC_CHUNK_BLOCKS;
+	submitted = 0;
+
+	while (brasero_scsi_queue_get_pending (queue)
+	||    (success && submitted < num_chunks)) {
+		BraseroScsiResult result;
+		BraseroScsiErrCode code;
+		gpointer chunk = NULL;
+
+		/* Keep the queue full */
+		while (success
+		&&     submitted < num_chunks
+		&&    !brasero_scsi_queue_is_full (queue)) {
+			guint start;
+			guint num;
+
+			start = submitted * BRASERO_VOL_SRC_CHUNK_BLOCKS;
+			num = MIN (BRASERO_VOL_SRC_CHUNK_BLOCKS, blocks - start);
+
+			if (src->read == brasero_volume_source_readcd_device_handle)
+				result = brasero_mmc1_read_block_async (queue,
+									TRUE,
+									src->data_mode,
+									BRASERO_SCSI_BLOCK_HEADER_NONE,
+									BRASERO_SCSI_BLOCK_NO_SUBCHANNEL,
+									src->position + start,
+									num,
+									(unsigned char *) buffer + start * ISO9660_BLOCK_SIZE,
+									num * ISO9660_BLOCK_SIZE,
+									GUINT_TO_POINTER (start),
+									&code);
+			else
+				result = brasero_sbc_read10_block_async (queue,
+									 src->position + start,
+									 num,
+									 (unsigned char *) buffer + start * ISO9660_BLOCK_SIZE,
+									 num * ISO9660_BLOCK_SIZE,
+									 GUINT_TO_POINTER (start),
+									 &code);
+
+			if (result != BRASERO_SCSI_OK) {
+				BRASERO_MEDIA_LOG ("Queuing read failed %s at %lli",
+						   brasero_scsi_strerror (code),
+						   src->position + start);
+				success = FALSE;
+				break;
+			}
+
+			submitted ++;
+		}
+
+		if (!brasero_scsi_queue_get_pending (queue))
+			break;
+
+		/* Wait for all of them even after an error since they write
+		 * into buffer */
+		result = brasero_scsi_queue_wait (queue, &chunk, &code);
+		if (result != BRASERO_SCSI_OK) {
+			BRASERO_MEDIA_LOG ("Queued read failed %s at %lli",
+					   brasero_scsi_strerror (code),
+					   src->position + GPOINTER_TO_UINT (chunk));
+			success = FALSE;
+		}
+	}
+
+	brasero_scsi_queue_free (queue);
+
+	if (!success)
+		return FALSE;
+
+	src->position += blocks;
+	return TRUE;
+}
+
 static gboolean
 brasero_volume_source_readcd_device_handle (BraseroVolSrc *src,
 					    gchar *buffer,
@@ -125,6 +231,10 @@ brasero_volume_source_readcd_device_handle (BraseroVolSrc *src,
 	BraseroScsiResult result;
 	BraseroScsiErrCode code;
 
+	if (blocks > BRASERO_VOL_SRC_CHUNK_BLOCKS
+	&&  brasero_volume_source_read_queued (src, buffer, blocks))
+		return TRUE;
+
 	BRASERO_MEDIA_LOG ("Using READCD. Reading with track mode %i", src->data_mode);
 	result = brasero_mmc1_read_block (src->data,
 					  TRUE,
@@ -192,6 +302,10 @@ brasero_volume_source_read10_device_handle (BraseroVolSrc *src,
 	BraseroScsiResult result;
 	BraseroScsiErrCode code;
 
+	if (blocks > BRASERO_VOL_SRC_CHUNK_BLOCKS
+	&&  brasero_volume_source_read_queued (src, buffer, blocks))
+		return TRUE;
+
 	BRASERO_MEDIA_LOG ("Using READ10");
 	result = brasero_sbc_read10_block (src->data,
 					   src->position,
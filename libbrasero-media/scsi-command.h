@@ -75,6 +75,31 @@ brasero_scsi_command_issue_sync (gpointer command,
 				 gpointer buffer,
 				 int size,
 				 BraseroScsiErrCode *error);
+
+/**
+ * Asynchronous transport used by BraseroScsiQueue. A transport which can't
+ * keep several commands in flight returns FALSE from can_queue and the
+ * queue then issues commands synchronously. sense must remain valid until
+ * the command is reaped. Reaping returns the result of the command whose
+ * id was given at submission.
+ */
+
+gboolean
+brasero_scsi_command_can_queue (BraseroDeviceHandle *handle);
+
+BraseroScsiResult
+brasero_scsi_command_submit (gpointer command,
+			     gpointer buffer,
+			     int size,
+			     uchar *sense,
+			     int id,
+			     BraseroScsiErrCode *error);
+
+BraseroScsiResult
+brasero_scsi_command_reap (BraseroDeviceHandle *handle,
+			   int *id,
+			   BraseroScsiErrCode *error);
+
 G_END_DECLS
 
 #endif /* _BURN_SCSI_COMMAND_H */
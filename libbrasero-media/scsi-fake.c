@@ -0,0 +1,333 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 8; tab-width: 8 -*- */
+/*
+ * Libbrasero-media
+ * Copyright (C) Philippe Rouquier 2005-2009 <bonfire-app@wanadoo.fr>
+ *
+ * Libbrasero-media is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * The Libbrasero-media authors hereby grant permission for non-GPL compatible
+ * GStreamer plugins to be used and distributed together with GStreamer
+ * and Libbrasero-media. This permission is above and beyond the permissions granted
+ * by the GPL license by which Libbrasero-media is covered. If you modify this code
+ * you may extend this exception to your version of the code, but you are not
+ * obligated to do so. If you do not wish to do so, delete this exception
+ * statement from your version.
+ * 
+ * Libbrasero-media is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to:
+ * 	The Free Software Foundation, Inc.,
+ * 	51 Franklin Street, Fifth Floor
+ * 	Boston, MA  02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <errno.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <string.h>
+
+#include <glib.h>
+
+#include "brasero-media-private.h"
+
+#include "scsi-command.h"
+#include "scsi-utils.h"
+#include "scsi-error.h"
+#include "scsi-sense-data.h"
+#include "scsi-opcodes.h"
+#include "scsi-read-capacity.h"
+
+/**
+ * File-backed fake device: it replaces the platform transport (see
+ * --enable-fake-scsi) so that reading code and BraseroScsiQueue can be
+ * tested against an image instead of a drive. Only the commands needed
+ * to read data are emulated.
+ */
+
+#define BRASERO_FAKE_BLOCK_SIZE		2048
+
+struct _BraseroDeviceHandle {
+	int fd;
+	goffset size;
+
+	/* Queued commands are run when submitted; that's their results */
+	GQueue done;
+};
+
+struct _BraseroScsiCmd {
+	uchar cmd [BRASERO_SCSI_CMD_MAX_LEN];
+	BraseroDeviceHandle *handle;
+
+	const BraseroScsiCmdInfo *info;
+};
+typedef struct _BraseroScsiCmd BraseroScsiCmd;
+
+struct _BraseroFakeCompletion {
+	int id;
+	BraseroScsiResult result;
+	BraseroScsiErrCode code;
+};
+typedef struct _BraseroFakeCompletion BraseroFakeCompletion;
+
+#define BRASERO_SCSI_CMD_OPCODE_OFF			0
+#define BRASERO_SCSI_CMD_SET_OPCODE(command)		(command->cmd [BRASERO_SCSI_CMD_OPCODE_OFF] = command->info->opcode)
+
+static BraseroScsiResult
+brasero_fake_read_blocks (BraseroDeviceHandle *handle,
+			  int start,
+			  int num_blocks,
+			  uchar *buffer,
+			  int size,
+			  BraseroScsiErrCode *error)
+{
+	goffset offset;
+	int total = 0;
+
+	offset = (goffset) start * BRASERO_FAKE_BLOCK_SIZE;
+	if (start < 0 || offset + (goffset) num_blocks * BRASERO_FAKE_BLOCK_SIZE > handle->size) {
+		BRASERO_SCSI_SET_ERRCODE (error, BRASERO_SCSI_OUTRANGE_ADDRESS);
+		return BRASERO_SCSI_FAILURE;
+	}
+
+	size = MIN (size, num_blocks * BRASERO_FAKE_BLOCK_SIZE);
+	while (total < size) {
+		ssize_t read_bytes;
+
+		read_bytes = pread (handle->fd,
+				    buffer + total,
+				    size - total,
+				    offset + total);
+		if (read_bytes < 0) {
+			if (errno == EINTR)
+				continue;
+
+			BRASERO_SCSI_SET_ERRCODE (error, BRASERO_SCSI_ERRNO);
+			return BRASERO_SCSI_FAILURE;
+		}
+
+		if (!read_bytes) {
+			BRASERO_SCSI_SET_ERRCODE (error, BRASERO_SCSI_OUTRANGE_ADDRESS);
+			return BRASERO_SCSI_FAILURE;
+		}
+
+		total += read_bytes;
+	}
+
+	return BRASERO_SCSI_OK;
+}
+
+static BraseroScsiResult
+brasero_fake_command_run (BraseroScsiCmd *cmd,
+			  uchar *buffer,
+			  int size,
+			  BraseroScsiErrCode *error)
+{
+	BraseroScsiReadCapacityData *capacity;
+
+	switch (cmd->cmd [BRASERO_SCSI_CMD_OPCODE_OFF]) {
+	case BRASERO_TEST_UNIT_READY_OPCODE:
+		return BRASERO_SCSI_OK;
+
+	case BRASERO_READ_CAPACITY_OPCODE:
+		if (size < (int) sizeof (BraseroScsiReadCapacityData)) {
+			BRASERO_SCSI_SET_ERRCODE (error, BRASERO_SCSI_SIZE_MISMATCH);
+			return BRASERO_SCSI_FAILURE;
+		}
+
+		capacity = (BraseroScsiReadCapacityData *) buffer;
+		BRASERO_SET_32 (capacity->lba, cmd->handle->size / BRASERO_FAKE_BLOCK_SIZE - 1);
+		BRASERO_SET_32 (capacity->block_size, BRASERO_FAKE_BLOCK_SIZE);
+		return BRASERO_SCSI_OK;
+
+	case BRASERO_READ10_OPCODE:
+		/* LBA in bytes 2-5 and length in bytes 7-8 */
+		return brasero_fake_read_blocks (cmd->handle,
+						 BRASERO_GET_32 (cmd->cmd + 2),
+						 BRASERO_GET_16 (cmd->cmd + 7),
+						 buffer,
+						 size,
+						 error);
+
+	case BRASERO_READ_CD_OPCODE:
+		/* LBA in bytes 2-5 and length in bytes 6-8. Only user data
+		 * (bit 4 of byte 9) is available from an image. */
+		if ((cmd->cmd [9] & 0xF8) != 0x10) {
+			BRASERO_SCSI_SET_ERRCODE (error, BRASERO_SCSI_INVALID_FIELD);
+			return BRASERO_SCSI_FAILURE;
+		}
+
+		return brasero_fake_read_blocks (cmd->handle,
+						 BRASERO_GET_32 (cmd->cmd + 2),
+						 BRASERO_GET_24 (cmd->cmd + 6),
+						 buffer,
+						 size,
+						 error);
+
+	default:
+		break;
+	}
+
+	BRASERO_SCSI_SET_ERRCODE (error, BRASERO_SCSI_INVALID_COMMAND);
+	return BRASERO_SCSI_FAILURE;
+}
+
+BraseroScsiResult
+brasero_scsi_command_issue_sync (gpointer command,
+				 gpointer buffer,
+				 int size,
+				 BraseroScsiErrCode *error)
+{
+	g_return_val_if_fail (command != NULL, BRASERO_SCSI_FAILURE);
+	return brasero_fake_command_run (command, buffer, size, error);
+}
+
+gboolean
+brasero_scsi_command_can_queue (BraseroDeviceHandle *handle)
+{
+	return TRUE;
+}
+
+BraseroScsiResult
+brasero_scsi_command_submit (gpointer command,
+			     gpointer buffer,
+			     int size,
+			     uchar *sense,
+			     int id,
+			     BraseroScsiErrCode *error)
+{
+	BraseroFakeCompletion *completion;
+	BraseroScsiCmd *cmd;
+
+	g_return_val_if_fail (command != NULL, BRASERO_SCSI_FAILURE);
+
+	cmd = command;
+	memset (sense, 0, BRASERO_SENSE_DATA_SIZE);
+
+	completion = g_new0 (BraseroFakeCompletion, 1);
+	completion->id = id;
+	completion->result = brasero_fake_command_run (cmd,
+						       buffer,
+						       size,
+						       &completion->code);
+	g_queue_push_tail (&cmd->handle->done, completion);
+	return BRASERO_SCSI_OK;
+}
+
+BraseroScsiResult
+brasero_scsi_command_reap (BraseroDeviceHandle *handle,
+			   int *id,
+			   BraseroScsiErrCode *error)
+{
+	BraseroFakeCompletion *completion;
+	BraseroScsiResult result;
+
+	g_return_val_if_fail (handle != NULL, BRASERO_SCSI_FAILURE);
+
+	completion = g_queue_pop_head (&handle->done);
+	if (!completion) {
+		BRASERO_SCSI_SET_ERRCODE (error, BRASERO_SCSI_BAD_ARGUMENT);
+		return BRASERO_SCSI_FAILURE;
+	}
+
+	if (id)
+		*id = completion->id;
+
+	result = completion->result;
+	if (result != BRASERO_SCSI_OK && error)
+		*error = completion->code;
+
+	g_free (completion);
+	return result;
+}
+
+gpointer
+brasero_scsi_command_new (const BraseroScsiCmdInfo *info,
+			  BraseroDeviceHandle *handle) 
+{
+	BraseroScsiCmd *cmd;
+
+	g_return_val_if_fail (handle != NULL, NULL);
+
+	cmd = g_new0 (BraseroScsiCmd, 1);
+	cmd->info = info;
+	cmd->handle = handle;
+
+	BRASERO_SCSI_CMD_SET_OPCODE (cmd);
+	return cmd;
+}
+
+BraseroScsiResult
+brasero_scsi_command_free (gpointer cmd)
+{
+	g_free (cmd);
+	return BRASERO_SCSI_OK;
+}
+
+/**
+ * This is to open a device; here an image file
+ */
+
+BraseroDeviceHandle *
+brasero_device_handle_open (const gchar *path,
+			    gboolean exclusive,
+			    BraseroScsiErrCode *code)
+{
+	BraseroDeviceHandle *handle;
+	struct stat buf;
+	int fd;
+
+	BRASERO_MEDIA_LOG ("Getting fake handle for %s", path);
+	fd = open (path, O_RDONLY);
+	if (fd < 0) {
+		BRASERO_MEDIA_LOG ("No handle: %s", strerror (errno));
+		if (code)
+			*code = BRASERO_SCSI_ERRNO;
+
+		return NULL;
+	}
+
+	if (fstat (fd, &buf) || !S_ISREG (buf.st_mode)) {
+		close (fd);
+		if (code)
+			*code = BRASERO_SCSI_TYPE_MISMATCH;
+
+		return NULL;
+	}
+
+	handle = g_new0 (BraseroDeviceHandle, 1);
+	handle->fd = fd;
+	handle->size = buf.st_size;
+	g_queue_init (&handle->done);
+
+	return handle;
+}
+
+void
+brasero_device_handle_close (BraseroDeviceHandle *handle)
+{
+	g_queue_foreach (&handle->done, (GFunc) g_free, NULL);
+	g_queue_clear (&handle->done);
+
+	close (handle->fd);
+	g_free (handle);
+}
+
+char *
+brasero_device_get_bus_target_lun (const gchar *device)
+{
+	return strdup (device);
+}
@@ -38,6 +38,7 @@
 #include "scsi-read-toc-pma-atip.h"
 #include "scsi-read-track-information.h"
 #include "scsi-mech-status.h"
+#include "scsi-queue.h"
 
 #ifndef _BURN_MMC1_H
 #define _BURN_MMC1_H
@@ -86,6 +87,20 @@ brasero_mmc1_read_block (BraseroDeviceHandle *handle,
 			 unsigned char *buffer,
 			 int buffer_len,
 			 BraseroScsiErrCode *error);
+
+BraseroScsiResult
+brasero_mmc1_read_block_async (BraseroScsiQueue *queue,
+			       gboolean user_data,
+			       BraseroScsiBlockType type,
+			       BraseroScsiBlockHeader header,
+			       BraseroScsiBlockSubChannel channel,
+			       int start,
+			       int size,
+			       unsigned char *buffer,
+			       int buffer_len,
+			       gpointer cb_data,
+			       BraseroScsiErrCode *error);
+
 BraseroScsiResult
 brasero_mmc1_mech_status (BraseroDeviceHandle *handle,
 			  BraseroScsiMechStatusHdr *hdr,
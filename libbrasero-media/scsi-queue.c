@@ -0,0 +1,294 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 8; tab-width: 8 -*- */
+/*
+ * Libbrasero-media
+ * Copyright (C) Philippe Rouquier 2005-2009 <bonfire-app@wanadoo.fr>
+ *
+ * Libbrasero-media is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * The Libbrasero-media authors hereby grant permission for non-GPL compatible
+ * GStreamer plugins to be used and distributed together with GStreamer
+ * and Libbrasero-media. This permission is above and beyond the permissions granted
+ * by the GPL license by which Libbrasero-media is covered. If you modify this code
+ * you may extend this exception to your version of the code, but you are not
+ * obligated to do so. If you do not wish to do so, delete this exception
+ * statement from your version.
+ * 
+ * Libbrasero-media is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to:
+ * 	The Free Software Foundation, Inc.,
+ * 	51 Franklin Street, Fifth Floor
+ * 	Boston, MA  02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <glib.h>
+
+#include "brasero-media-private.h"
+
+#include "scsi-command.h"
+#include "scsi-queue.h"
+#include "scsi-utils.h"
+#include "scsi-error.h"
+#include "scsi-sense-data.h"
+
+/**
+ * Keeps several commands in flight on a device. Each command occupies a
+ * slot until it is reaped with brasero_scsi_queue_wait (). When the
+ * transport can't queue commands they are issued synchronously at
+ * submission time and their results are returned in order.
+ */
+
+#define BRASERO_SCSI_QUEUE_MAX_DEPTH		32
+
+struct _BraseroScsiQueueSlot {
+	gpointer command;
+	gpointer user_data;
+
+	uchar sense [BRASERO_SENSE_DATA_SIZE];
+
+	BraseroScsiResult result;
+	BraseroScsiErrCode code;
+
+	guint busy:1;
+};
+typedef struct _BraseroScsiQueueSlot BraseroScsiQueueSlot;
+
+struct _BraseroScsiQueue {
+	BraseroDeviceHandle *handle;
+
+	BraseroScsiQueueSlot *slots;
+	int depth;
+	int pending;
+
+	/* Slots whose commands were run synchronously */
+	GQueue done;
+
+	guint async:1;
+};
+
+BraseroScsiQueue *
+brasero_scsi_queue_new (BraseroDeviceHandle *handle,
+			int depth,
+			BraseroScsiErrCode *error)
+{
+	BraseroScsiQueue *queue;
+
+	if (!handle || depth <= 0) {
+		BRASERO_SCSI_SET_ERRCODE (error, BRASERO_SCSI_BAD_ARGUMENT);
+		return NULL;
+	}
+
+	queue = g_new0 (BraseroScsiQueue, 1);
+	queue->handle = handle;
+	queue->depth = MIN (depth, BRASERO_SCSI_QUEUE_MAX_DEPTH);
+	queue->slots = g_new0 (BraseroScsiQueueSlot, queue->depth);
+	queue->async = brasero_scsi_command_can_queue (handle);
+	g_queue_init (&queue->done);
+
+	BRASERO_MEDIA_LOG ("SCSI queue created (depth = %i, async = %i)",
+			   queue->depth,
+			   queue->async);
+	return queue;
+}
+
+BraseroDeviceHandle *
+brasero_scsi_queue_get_handle (BraseroScsiQueue *queue)
+{
+	return queue->handle;
+}
+
+int
+brasero_scsi_queue_get_pending (BraseroScsiQueue *queue)
+{
+	return queue->pending;
+}
+
+gboolean
+brasero_scsi_queue_is_full (BraseroScsiQueue *queue)
+{
+	return queue->pending >= queue->depth;
+}
+
+/**
+ * Buffers aligned on a page boundary so that the transport can map them
+ * directly (direct I/O) rather than bounce the data through the kernel.
+ */
+
+gpointer
+brasero_scsi_queue_buffer_new (int size)
+{
+	gpointer buffer = NULL;
+
+	if (posix_memalign (&buffer, getpagesize (), size))
+		return NULL;
+
+	return buffer;
+}
+
+void
+brasero_scsi_queue_buffer_free (gpointer buffer)
+{
+	free (buffer);
+}
+
+BraseroScsiResult
+brasero_scsi_command_issue_async (BraseroScsiQueue *queue,
+				  gpointer command,
+				  gpointer buffer,
+				  int size,
+				  gpointer user_data,
+				  BraseroScsiErrCode *error)
+{
+	BraseroScsiQueueSlot *slot = NULL;
+	BraseroScsiResult res;
+	int id;
+
+	g_return_val_if_fail (queue != NULL, BRASERO_SCSI_FAILURE);
+	g_return_val_if_fail (command != NULL, BRASERO_SCSI_FAILURE);
+
+	/* The queue owns the command from now on */
+	if (brasero_scsi_queue_is_full (queue)) {
+		brasero_scsi_command_free (command);
+		BRASERO_SCSI_SET_ERRCODE (error, BRASERO_SCSI_NOT_READY);
+		return BRASERO_SCSI_FAILURE;
+	}
+
+	for (id = 0; id < queue->depth; id ++) {
+		if (!queue->slots [id].busy) {
+			slot = queue->slots + id;
+			break;
+		}
+	}
+
+	memset (slot, 0, sizeof (BraseroScsiQueueSlot));
+	slot->command = command;
+	slot->user_data = user_data;
+
+	if (!queue->async) {
+		slot->result = brasero_scsi_command_issue_sync (command,
+								buffer,
+								size,
+								&slot->code);
+		slot->busy = 1;
+		queue->pending ++;
+		g_queue_push_tail (&queue->done, slot);
+		return BRASERO_SCSI_OK;
+	}
+
+	res = brasero_scsi_command_submit (command,
+					   buffer,
+					   size,
+					   slot->sense,
+					   id,
+					   error);
+	if (res != BRASERO_SCSI_OK) {
+		brasero_scsi_command_free (command);
+		slot->command = NULL;
+		return res;
+	}
+
+	slot->busy = 1;
+	queue->pending ++;
+	return BRASERO_SCSI_OK;
+}
+
+static BraseroScsiQueueSlot *
+brasero_scsi_queue_reap_slot (BraseroScsiQueue *queue,
+			      BraseroScsiResult *res,
+			      BraseroScsiErrCode *error)
+{
+	BraseroScsiQueueSlot *slot;
+	int id = -1;
+
+	slot = g_queue_pop_head (&queue->done);
+	if (slot) {
+		*res = slot->result;
+		if (slot->result != BRASERO_SCSI_OK && error)
+			*error = slot->code;
+	}
+	else {
+		*res = brasero_scsi_command_reap (queue->handle, &id, error);
+
+		/* id is not set when the transport itself failed */
+		if (id < 0 || id >= queue->depth || !queue->slots [id].busy)
+			return NULL;
+
+		slot = queue->slots + id;
+	}
+
+	brasero_scsi_command_free (slot->command);
+	slot->command = NULL;
+	slot->busy = 0;
+	queue->pending --;
+
+	return slot;
+}
+
+/**
+ * Waits for the completion of one of the commands in flight. Its user_data
+ * is returned along with its result. Commands may complete out of order.
+ */
+
+BraseroScsiResult
+brasero_scsi_queue_wait (BraseroScsiQueue *queue,
+			 gpointer *user_data,
+			 BraseroScsiErrCode *error)
+{
+	BraseroScsiQueueSlot *slot;
+	BraseroScsiResult res;
+
+	g_return_val_if_fail (queue != NULL, BRASERO_SCSI_FAILURE);
+
+	if (!queue->pending) {
+		BRASERO_SCSI_SET_ERRCODE (error, BRASERO_SCSI_BAD_ARGUMENT);
+		return BRASERO_SCSI_FAILURE;
+	}
+
+	slot = brasero_scsi_queue_reap_slot (queue, &res, error);
+	if (!slot)
+		return BRASERO_SCSI_FAILURE;
+
+	if (user_data)
+		*user_data = slot->user_data;
+
+	return res;
+}
+
+void
+brasero_scsi_queue_free (BraseroScsiQueue *queue)
+{
+	int i;
+
+	/* Buffers may be freed by the caller once we return so make sure
+	 * nothing is still being transferred into them */
+	while (queue->pending) {
+		BraseroScsiResult res;
+
+		if (!brasero_scsi_queue_reap_slot (queue, &res, NULL))
+			break;
+	}
+
+	/* Only happens if the device went away */
+	for (i = 0; i < queue->depth; i ++) {
+		if (queue->slots [i].command)
+			brasero_scsi_command_free (queue->slots [i].command);
+	}
+
+	g_free (queue->slots);
+	g_free (queue);
+}
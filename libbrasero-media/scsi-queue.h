@@ -0,0 +1,84 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 8; tab-width: 8 -*- */
+/*
+ * Libbrasero-media
+ * Copyright (C) Philippe Rouquier 2005-2009 <bonfire-app@wanadoo.fr>
+ *
+ * Libbrasero-media is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * The Libbrasero-media authors hereby grant permission for non-GPL compatible
+ * GStreamer plugins to be used and distributed together with GStreamer
+ * and Libbrasero-media. This permission is above and beyond the permissions granted
+ * by the GPL license by which Libbrasero-media is covered. If you modify this code
+ * you may extend this exception to your version of the code, but you are not
+ * obligated to do so. If you do not wish to do so, delete this exception
+ * statement from your version.
+ * 
+ * Libbrasero-media is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to:
+ * 	The Free Software Foundation, Inc.,
+ * 	51 Franklin Street, Fifth Floor
+ * 	Boston, MA  02110-1301, USA.
+ */
+
+#include <glib.h>
+
+#include "scsi-base.h"
+#include "scsi-error.h"
+#include "scsi-device.h"
+
+#ifndef _SCSI_QUEUE_H
+#define _SCSI_QUEUE_H
+
+G_BEGIN_DECLS
+
+typedef struct _BraseroScsiQueue BraseroScsiQueue;
+
+BraseroScsiQueue *
+brasero_scsi_queue_new (BraseroDeviceHandle *handle,
+			int depth,
+			BraseroScsiErrCode *error);
+
+void
+brasero_scsi_queue_free (BraseroScsiQueue *queue);
+
+BraseroDeviceHandle *
+brasero_scsi_queue_get_handle (BraseroScsiQueue *queue);
+
+int
+brasero_scsi_queue_get_pending (BraseroScsiQueue *queue);
+
+gboolean
+brasero_scsi_queue_is_full (BraseroScsiQueue *queue);
+
+BraseroScsiResult
+brasero_scsi_queue_wait (BraseroScsiQueue *queue,
+			 gpointer *user_data,
+			 BraseroScsiErrCode *error);
+
+gpointer
+brasero_scsi_queue_buffer_new (int size);
+
+void
+brasero_scsi_queue_buffer_free (gpointer buffer);
+
+BraseroScsiResult
+brasero_scsi_command_issue_async (BraseroScsiQueue *queue,
+				  gpointer command,
+				  gpointer buffer,
+				  int size,
+				  gpointer user_data,
+				  BraseroScsiErrCode *error);
+
+G_END_DECLS
+
+#endif /* _SCSI_QUEUE_H */
+
+ 
@@ -40,6 +40,7 @@
 #include "scsi-utils.h"
 #include "scsi-base.h"
 #include "scsi-command.h"
+#include "scsi-queue.h"
 #include "scsi-opcodes.h"
 #include "scsi-read-cd.h"
 
@@ -103,22 +104,16 @@ BRASERO_SCSI_COMMAND_DEFINE (BraseroReadCDCDB,
 			     READ_CD,
 			     BRASERO_SCSI_READ);
 
-BraseroScsiResult
-brasero_mmc1_read_block (BraseroDeviceHandle *handle,
-			 gboolean user_data,
-			 BraseroScsiBlockType type,
-			 BraseroScsiBlockHeader header,
-			 BraseroScsiBlockSubChannel channel,
-			 int start,
-			 int size,
-			 unsigned char *buffer,
-			 int buffer_len,
-			 BraseroScsiErrCode *error)
+static BraseroReadCDCDB *
+brasero_mmc1_read_block_command_new (BraseroDeviceHandle *handle,
+				     gboolean user_data,
+				     BraseroScsiBlockType type,
+				     BraseroScsiBlockHeader header,
+				     BraseroScsiBlockSubChannel channel,
+				     int start,
+				     int size)
 {
 	BraseroReadCDCDB *cdb;
-	BraseroScsiResult res;
-
-	g_return_val_if_fail (handle != NULL, BRASERO_SCSI_FAILURE);
 
 	cdb = brasero_scsi_command_new (&info, handle);
 	BRASERO_SET_32 (cdb->start_lba, start);
@@ -145,6 +140,34 @@ brasero_mmc1_read_block (BraseroDeviceHandle *handle,
 	/* subchannel */
 	cdb->subchannel = channel;
 
+	return cdb;
+}
+
+BraseroScsiResult
+brasero_mmc1_read_block (BraseroDeviceHandle *handle,
+			 gboolean user_data,
+			 BraseroScsiBlockType type,
+			 BraseroScsiBlockHeader header,
+			 BraseroScsiBlockSubChannel channel,
+			 int start,
+			 int size,
+			 unsigned char *buffer,
+			 int buffer_len,
+			 BraseroScsiErrCode *error)
+{
+	BraseroReadCDCDB *cdb;
+	BraseroScsiResult res;
+
+	g_return_val_if_fail (handle != NULL, BRASERO_SCSI_FAILURE);
+
+	cdb = brasero_mmc1_read_block_command_new (handle,
+						   user_data,
+						   type,
+						   header,
+						   channel,
+						   start,
+						   size);
+
 	if (buffer)
 		memset (buffer, 0, buffer_len);
 
@@ -155,3 +178,43 @@ brasero_mmc1_read_block (BraseroDeviceHandle *handle,
 	brasero_scsi_command_free (cdb);
 	return res;
 }
+
+/**
+ * Queued version; see brasero_sbc_read10_block_async ()
+ */
+
+BraseroScsiResult
+brasero_mmc1_read_block_async (BraseroScsiQueue *queue,
+			       gboolean user_data,
+			       BraseroScsiBlockType type,
+			       BraseroScsiBlockHeader header,
+			       BraseroScsiBlockSubChannel channel,
+			       int start,
+			       int size,
+			       unsigned char *buffer,
+			       int buffer_len,
+			       gpointer cb_data,
+			       BraseroScsiErrCode *error)
+{
+	BraseroReadCDCDB *cdb;
+
+	g_return_val_if_fail (queue != NULL, BRASERO_SCSI_FAILURE);
+
+	cdb = brasero_mmc1_read_block_command_new (brasero_scsi_queue_get_handle (queue),
+						   user_data,
+						   type,
+						   header,
+						   channel,
+						   start,
+						   size);
+
+	if (buffer)
+		memset (buffer, 0, buffer_len);
+
+	return brasero_scsi_command_issue_async (queue,
+						 cdb,
+						 buffer,
+						 buffer_len,
+						 cb_data,
+						 error);
+}
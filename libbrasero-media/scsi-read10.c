@@ -40,6 +40,7 @@
 #include "scsi-utils.h"
 #include "scsi-base.h"
 #include "scsi-command.h"
+#include "scsi-queue.h"
 #include "scsi-opcodes.h"
 
 #if G_BYTE_ORDER == G_LITTLE_ENDIAN
@@ -90,18 +91,12 @@ BRASERO_SCSI_COMMAND_DEFINE (BraseroRead10CDB,
 			     READ10,
 			     BRASERO_SCSI_READ);
 
-BraseroScsiResult
-brasero_sbc_read10_block (BraseroDeviceHandle *handle,
-			  int start,
-			  int num_blocks,
-			  unsigned char *buffer,
-			  int buffer_size,
-			  BraseroScsiErrCode *error)
+static BraseroRead10CDB *
+brasero_sbc_read10_command_new (BraseroDeviceHandle *handle,
+				int start,
+				int num_blocks)
 {
 	BraseroRead10CDB *cdb;
-	BraseroScsiResult res;
-
-	g_return_val_if_fail (handle != NULL, BRASERO_SCSI_FAILURE);
 
 	cdb = brasero_scsi_command_new (&info, handle);
 	BRASERO_SET_32 (cdb->start_address, start);
@@ -116,6 +111,24 @@ brasero_sbc_read10_block (BraseroDeviceHandle *handle,
 	/* On the other hand caching improves dramatically the performances. */
 	cdb->FUA = 0;
 
+	return cdb;
+}
+
+BraseroScsiResult
+brasero_sbc_read10_block (BraseroDeviceHandle *handle,
+			  int start,
+			  int num_blocks,
+			  unsigned char *buffer,
+			  int buffer_size,
+			  BraseroScsiErrCode *error)
+{
+	BraseroRead10CDB *cdb;
+	BraseroScsiResult res;
+
+	g_return_val_if_fail (handle != NULL, BRASERO_SCSI_FAILURE);
+
+	cdb = brasero_sbc_read10_command_new (handle, start, num_blocks);
+
 	memset (buffer, 0, buffer_size);
 	res = brasero_scsi_command_issue_sync (cdb,
 					       buffer,
@@ -124,3 +137,35 @@ brasero_sbc_read10_block (BraseroDeviceHandle *handle,
 	brasero_scsi_command_free (cdb);
 	return res;
 }
+
+/**
+ * Same as above except that the command is only queued. Its result is
+ * returned by brasero_scsi_queue_wait () along with user_data; buffer
+ * must stay valid until then.
+ */
+
+BraseroScsiResult
+brasero_sbc_read10_block_async (BraseroScsiQueue *queue,
+				int start,
+				int num_blocks,
+				unsigned char *buffer,
+				int buffer_size,
+				gpointer user_data,
+				BraseroScsiErrCode *error)
+{
+	BraseroRead10CDB *cdb;
+
+	g_return_val_if_fail (queue != NULL, BRASERO_SCSI_FAILURE);
+
+	cdb = brasero_sbc_read10_command_new (brasero_scsi_queue_get_handle (queue),
+					      start,
+					      num_blocks);
+
+	memset (buffer, 0, buffer_size);
+	return brasero_scsi_command_issue_async (queue,
+						 cdb,
+						 buffer,
+						 buffer_size,
+						 user_data,
+						 error);
+}
@@ -40,6 +40,8 @@
 #include <fcntl.h>
 #include <string.h>
 #include <sys/ioctl.h>
+#include <sys/sysmacros.h>
+#include <poll.h>
 
 #include <scsi/scsi.h>
 #include <scsi/sg.h>
@@ -53,6 +55,10 @@
 
 struct _BraseroDeviceHandle {
 	int fd;
+
+	/* sg node used to queue commands (see brasero_scsi_command_submit) */
+	int sg_fd;
+	guint sg_checked:1;
 };
 
 struct _BraseroScsiCmd {
@@ -68,6 +74,10 @@ typedef struct _BraseroScsiCmd BraseroScsiCmd;
 
 #define OPEN_FLAGS			O_RDWR /*|O_EXCL */|O_NONBLOCK
 
+#ifndef SCSI_GENERIC_MAJOR
+#define SCSI_GENERIC_MAJOR		21
+#endif
+
 /**
  * This is to send a command
  */
@@ -136,6 +146,182 @@ brasero_scsi_command_issue_sync (gpointer command,
 	return BRASERO_SCSI_FAILURE;
 }
 
+/**
+ * Asynchronous commands go through the sg v3 write ()/read () interface
+ * which is only available on sg nodes. Block devices (/dev/srX) only
+ * support the SG_IO ioctl so look up the sg node of the same device.
+ */
+
+static int
+brasero_sg_open_generic (int fd)
+{
+	const gchar *name;
+	struct stat buf;
+	gchar *path;
+	GDir *dir;
+	int sg_fd;
+	int version = 0;
+
+	if (fstat (fd, &buf))
+		return -1;
+
+	if (S_ISCHR (buf.st_mode) && major (buf.st_rdev) == SCSI_GENERIC_MAJOR)
+		sg_fd = dup (fd);
+	else if (S_ISBLK (buf.st_mode)) {
+		path = g_strdup_printf ("/sys/dev/block/%u:%u/device/scsi_generic",
+					major (buf.st_rdev),
+					minor (buf.st_rdev));
+		dir = g_dir_open (path, 0, NULL);
+		g_free (path);
+
+		if (!dir)
+			return -1;
+
+		name = g_dir_read_name (dir);
+		if (!name) {
+			g_dir_close (dir);
+			return -1;
+		}
+
+		path = g_build_filename ("/dev", name, NULL);
+		g_dir_close (dir);
+
+		sg_fd = open (path, OPEN_FLAGS);
+		BRASERO_MEDIA_LOG ("Opened %s for queued commands (%i)", path, sg_fd);
+		g_free (path);
+	}
+	else
+		return -1;
+
+	if (sg_fd < 0)
+		return -1;
+
+	/* write ()/read () with sg_io_hdr needs version 3 of the driver */
+	if (ioctl (sg_fd, SG_GET_VERSION_NUM, &version) < 0 || version < 30000) {
+		close (sg_fd);
+		return -1;
+	}
+
+	return sg_fd;
+}
+
+gboolean
+brasero_scsi_command_can_queue (BraseroDeviceHandle *handle)
+{
+	if (!handle->sg_checked) {
+		handle->sg_checked = 1;
+		handle->sg_fd = brasero_sg_open_generic (handle->fd);
+	}
+
+	return (handle->sg_fd >= 0);
+}
+
+BraseroScsiResult
+brasero_scsi_command_submit (gpointer command,
+			     gpointer buffer,
+			     int size,
+			     uchar *sense,
+			     int id,
+			     BraseroScsiErrCode *error)
+{
+	struct sg_io_hdr transport;
+	BraseroScsiCmd *cmd;
+	ssize_t res;
+
+	g_return_val_if_fail (command != NULL, BRASERO_SCSI_FAILURE);
+
+	cmd = command;
+	if (!brasero_scsi_command_can_queue (cmd->handle)) {
+		BRASERO_SCSI_SET_ERRCODE (error, BRASERO_SCSI_BAD_ARGUMENT);
+		return BRASERO_SCSI_FAILURE;
+	}
+
+	brasero_sg_command_setup (&transport,
+				  sense,
+				  cmd,
+				  buffer,
+				  size);
+
+	/* The kernel silently falls back to indirect I/O if the buffer is
+	 * not suitably aligned or if direct I/O is disabled (allow_dio) */
+	transport.flags |= SG_FLAG_DIRECT_IO;
+	transport.pack_id = id;
+
+	do {
+		res = write (cmd->handle->sg_fd, &transport, sizeof (transport));
+	} while (res < 0 && errno == EINTR);
+
+	if (res < 0) {
+		if (errno == EAGAIN || errno == EDOM) {
+			BRASERO_SCSI_SET_ERRCODE (error, BRASERO_SCSI_NOT_READY);
+		}
+		else {
+			BRASERO_SCSI_SET_ERRCODE (error, BRASERO_SCSI_ERRNO);
+		}
+
+		return BRASERO_SCSI_FAILURE;
+	}
+
+	return BRASERO_SCSI_OK;
+}
+
+BraseroScsiResult
+brasero_scsi_command_reap (BraseroDeviceHandle *handle,
+			   int *id,
+			   BraseroScsiErrCode *error)
+{
+	struct sg_io_hdr transport;
+	ssize_t res;
+
+	g_return_val_if_fail (handle != NULL, BRASERO_SCSI_FAILURE);
+
+	if (handle->sg_fd < 0) {
+		BRASERO_SCSI_SET_ERRCODE (error, BRASERO_SCSI_BAD_ARGUMENT);
+		return BRASERO_SCSI_FAILURE;
+	}
+
+	while (1) {
+		struct pollfd fds;
+
+		/* -1 means the first completed command whatever its id */
+		memset (&transport, 0, sizeof (transport));
+		transport.interface_id = 'S';
+		transport.pack_id = -1;
+
+		res = read (handle->sg_fd, &transport, sizeof (transport));
+		if (res >= 0)
+			break;
+
+		if (errno == EINTR)
+			continue;
+
+		if (errno != EAGAIN) {
+			BRASERO_SCSI_SET_ERRCODE (error, BRASERO_SCSI_ERRNO);
+			return BRASERO_SCSI_FAILURE;
+		}
+
+		/* The descriptor is non blocking; wait for a completion */
+		fds.fd = handle->sg_fd;
+		fds.events = POLLIN;
+		fds.revents = 0;
+		if (poll (&fds, 1, -1) < 0 && errno != EINTR) {
+			BRASERO_SCSI_SET_ERRCODE (error, BRASERO_SCSI_ERRNO);
+			return BRASERO_SCSI_FAILURE;
+		}
+	}
+
+	if (id)
+		*id = transport.pack_id;
+
+	if ((transport.info & SG_INFO_OK_MASK) == SG_INFO_OK)
+		return BRASERO_SCSI_OK;
+
+	if ((transport.masked_status & CHECK_CONDITION) && transport.sb_len_wr)
+		return brasero_sense_data_process (transport.sbp, error);
+
+	return BRASERO_SCSI_FAILURE;
+}
+
 gpointer
 brasero_scsi_command_new (const BraseroScsiCmdInfo *info,
 			  BraseroDeviceHandle *handle) 
@@ -194,8 +380,9 @@ brasero_device_handle_open (const gchar *path,
 		return NULL;
 	}
 
-	handle = g_new (BraseroDeviceHandle, 1);
+	handle = g_new0 (BraseroDeviceHandle, 1);
 	handle->fd = fd;
+	handle->sg_fd = -1;
 
 	BRASERO_MEDIA_LOG ("Handle ready");
 	return handle;
@@ -204,6 +391,9 @@ brasero_device_handle_open (const gchar *path,
 void
 brasero_device_handle_close (BraseroDeviceHandle *handle)
 {
+	if (handle->sg_fd >= 0)
+		close (handle->sg_fd);
+
 	close (handle->fd);
 	g_free (handle);
 }
@@ -167,6 +167,38 @@ brasero_scsi_command_issue_sync (gpointer command,
 	return BRASERO_SCSI_FAILURE;
 }
 
+/**
+ * Commands can't be queued with this transport; BraseroScsiQueue issues
+ * them synchronously instead.
+ */
+
+gboolean
+brasero_scsi_command_can_queue (BraseroDeviceHandle *handle)
+{
+	return FALSE;
+}
+
+BraseroScsiResult
+brasero_scsi_command_submit (gpointer command,
+			     gpointer buffer,
+			     int size,
+			     uchar *sense,
+			     int id,
+			     BraseroScsiErrCode *error)
+{
+	BRASERO_SCSI_SET_ERRCODE (error, BRASERO_SCSI_BAD_ARGUMENT);
+	return BRASERO_SCSI_FAILURE;
+}
+
+BraseroScsiResult
+brasero_scsi_command_reap (BraseroDeviceHandle *handle,
+			   int *id,
+			   BraseroScsiErrCode *error)
+{
+	BRASERO_SCSI_SET_ERRCODE (error, BRASERO_SCSI_BAD_ARGUMENT);
+	return BRASERO_SCSI_FAILURE;
+}
+
 gpointer
 brasero_scsi_command_new (const BraseroScsiCmdInfo *info,
 			  BraseroDeviceHandle *handle) 
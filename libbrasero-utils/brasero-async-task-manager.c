@@ -32,6 +32,8 @@
 #  include <config.h>
 #endif
 
+#include <unistd.h>
+
 #include <glib.h>
 #include <gio/gio.h>
 #include <glib-object.h>
@@ -42,15 +44,24 @@ static void brasero_async_task_manager_class_init (BraseroAsyncTaskManagerClass
 static void brasero_async_task_manager_init (BraseroAsyncTaskManager *sp);
 static void brasero_async_task_manager_finalize (GObject *object);
 
+enum {
+	BRASERO_ASYNC_QUEUE_URGENT,
+	BRASERO_ASYNC_QUEUE_NORMAL,
+	BRASERO_ASYNC_QUEUE_IDLE,
+	BRASERO_ASYNC_QUEUE_NUM
+};
+
 struct BraseroAsyncTaskManagerPrivate {
 	GCond *thread_finished;
 	GCond *task_finished;
 	GCond *new_task;
 	GMutex *lock;
 
-	GSList *waiting_tasks;
+	/* One queue per priority, the most urgent first */
+	GQueue waiting_tasks [BRASERO_ASYNC_QUEUE_NUM];
 	GSList *active_tasks;
 
+	gint max_threads;
 	gint num_threads;
 	gint unused_threads;
 
@@ -65,7 +76,10 @@ struct _BraseroAsyncTaskCtx {
 };
 typedef struct _BraseroAsyncTaskCtx BraseroAsyncTaskCtx;
 
-#define MANAGER_MAX_THREAD 2
+/* Most tasks are I/O bound so keep at least two threads even on single core
+ * machines but don't start too many of them either. */
+#define MANAGER_MIN_THREAD 2
+#define MANAGER_MAX_THREAD 16
 
 static GObjectClass *parent_class = NULL;
 
@@ -105,6 +119,15 @@ brasero_async_task_manager_class_init (BraseroAsyncTaskManagerClass *klass)
 	object_class->finalize = brasero_async_task_manager_finalize;
 }
 
+static gint
+brasero_async_task_manager_get_default_max_threads (void)
+{
+	glong num_cpus;
+
+	num_cpus = sysconf (_SC_NPROCESSORS_ONLN);
+	return CLAMP (num_cpus, MANAGER_MIN_THREAD, MANAGER_MAX_THREAD);
+}
+
 static void
 brasero_async_task_manager_init (BraseroAsyncTaskManager *obj)
 {
@@ -115,12 +138,15 @@ brasero_async_task_manager_init (BraseroAsyncTaskManager *obj)
 	obj->priv->new_task = g_cond_new ();
 
 	obj->priv->lock = g_mutex_new ();
+
+	obj->priv->max_threads = brasero_async_task_manager_get_default_max_threads ();
 }
 
 static void
 brasero_async_task_manager_finalize (GObject *object)
 {
 	BraseroAsyncTaskManager *cobj;
+	gint i;
 
 	cobj = BRASERO_ASYNC_TASK_MANAGER (object);
 
@@ -133,11 +159,12 @@ brasero_async_task_manager_finalize (GObject *object)
 	cobj->priv->cancelled = TRUE;
 
 	/* remove all the waiting tasks */
-	g_slist_foreach (cobj->priv->waiting_tasks,
-			 (GFunc) g_free,
-			 NULL);
-	g_slist_free (cobj->priv->waiting_tasks);
-	cobj->priv->waiting_tasks = NULL;
+	for (i = 0; i < BRASERO_ASYNC_QUEUE_NUM; i ++) {
+		g_queue_foreach (&cobj->priv->waiting_tasks [i],
+				 (GFunc) g_free,
+				 NULL);
+		g_queue_clear (&cobj->priv->waiting_tasks [i]);
+	}
 
 	/* terminate all sleeping threads */
 	g_cond_broadcast (cobj->priv->new_task);
@@ -172,41 +199,48 @@ brasero_async_task_manager_finalize (GObject *object)
 	G_OBJECT_CLASS (parent_class)->finalize (object);
 }
 
-static void
-brasero_async_task_manager_insert_task (BraseroAsyncTaskManager *self,
-					BraseroAsyncTaskCtx *ctx)
+static GQueue *
+brasero_async_task_manager_get_queue (BraseroAsyncTaskManager *self,
+				      BraseroAsyncPriority priority)
 {
-	GSList *iter;
-	GSList *node;
-	BraseroAsyncTaskCtx *tmp;
+	if (priority & BRASERO_ASYNC_URGENT)
+		return &self->priv->waiting_tasks [BRASERO_ASYNC_QUEUE_URGENT];
 
-	node = g_slist_alloc ();
-	node->data = ctx;
+	if (priority & BRASERO_ASYNC_NORMAL)
+		return &self->priv->waiting_tasks [BRASERO_ASYNC_QUEUE_NORMAL];
 
-	if (!self->priv->waiting_tasks) {
-		self->priv->waiting_tasks = node;
-		return;
-	}
+	return &self->priv->waiting_tasks [BRASERO_ASYNC_QUEUE_IDLE];
+}
 
-	tmp = self->priv->waiting_tasks->data;
+/**
+ * See if there is a task waiting in one of the queues up to last (included)
+ */
+
+static gboolean
+brasero_async_task_manager_has_waiting_task (BraseroAsyncTaskManager *self,
+					     GQueue *last)
+{
+	GQueue *iter;
 
-	if (tmp->priority < ctx->priority) {
-		node->next = self->priv->waiting_tasks;
-		self->priv->waiting_tasks = node;
-		return;
+	for (iter = self->priv->waiting_tasks; iter <= last; iter ++) {
+		if (!g_queue_is_empty (iter))
+			return TRUE;
 	}
 
-	for (iter = self->priv->waiting_tasks; iter->next; iter = iter->next) {
-		tmp = iter->next->data;
+	return FALSE;
+}
 
-		if (tmp->priority < ctx->priority) {
-			node->next = iter->next;
-			iter->next = node;
-			return;
-		}
+static BraseroAsyncTaskCtx *
+brasero_async_task_manager_next_task (BraseroAsyncTaskManager *self)
+{
+	gint i;
+
+	for (i = 0; i < BRASERO_ASYNC_QUEUE_NUM; i ++) {
+		if (!g_queue_is_empty (&self->priv->waiting_tasks [i]))
+			return g_queue_pop_head (&self->priv->waiting_tasks [i]);
 	}
 
-	iter->next = node;
+	return NULL;
 }
 
 static gpointer
@@ -227,7 +261,7 @@ brasero_async_task_manager_thread (BraseroAsyncTaskManager *self)
 		self->priv->unused_threads ++;
 	
 		/* see if a task is waiting to be executed */
-		while (!self->priv->waiting_tasks) {
+		while (!brasero_async_task_manager_has_waiting_task (self, &self->priv->waiting_tasks [BRASERO_ASYNC_QUEUE_IDLE])) {
 			if (self->priv->cancelled)
 				goto end;
 
@@ -253,12 +287,11 @@ brasero_async_task_manager_thread (BraseroAsyncTaskManager *self)
 		/* say that we are active again */
 		self->priv->unused_threads --;
 	
-		/* get the data from the list */
-		ctx = self->priv->waiting_tasks->data;
+		/* get the data from the queues */
+		ctx = brasero_async_task_manager_next_task (self);
 		ctx->cancel = cancel;
 		ctx->priority &= ~BRASERO_ASYNC_RESCHEDULE;
 
-		self->priv->waiting_tasks = g_slist_remove (self->priv->waiting_tasks, ctx);
 		self->priv->active_tasks = g_slist_prepend (self->priv->active_tasks, ctx);
 	
 		g_mutex_unlock (self->priv->lock);
@@ -274,17 +307,16 @@ brasero_async_task_manager_thread (BraseroAsyncTaskManager *self)
 		 * the active main loop */
 		if (!g_cancellable_is_cancelled (cancel)) {
 			if (res == BRASERO_ASYNC_TASK_RESCHEDULE) {
-				if (self->priv->waiting_tasks) {
-					BraseroAsyncTaskCtx *next;
-
-					next = self->priv->waiting_tasks->data;
-					if (next->priority > ctx->priority)
-						brasero_async_task_manager_insert_task (self, ctx);
-					else
-						self->priv->waiting_tasks = g_slist_prepend (self->priv->waiting_tasks, ctx);
-				}
+				GQueue *queue;
+
+				/* Let more urgent tasks go first, otherwise
+				 * carry on with this one as soon as possible */
+				queue = brasero_async_task_manager_get_queue (self, ctx->priority);
+				if (queue != self->priv->waiting_tasks
+				&&  brasero_async_task_manager_has_waiting_task (self, queue - 1))
+					g_queue_push_tail (queue, ctx);
 				else
-					self->priv->waiting_tasks = g_slist_prepend (self->priv->waiting_tasks, ctx);
+					g_queue_push_head (queue, ctx);
 			}
 			else {
 				if (ctx->type->destroy)
@@ -328,18 +360,18 @@ brasero_async_task_manager_queue (BraseroAsyncTaskManager *self,
 	ctx->data = data;
 
 	g_mutex_lock (self->priv->lock);
-	if (priority == BRASERO_ASYNC_IDLE)
-		self->priv->waiting_tasks = g_slist_append (self->priv->waiting_tasks, ctx);
-	else if (priority == BRASERO_ASYNC_NORMAL)
-		brasero_async_task_manager_insert_task (self, ctx);
-	else if (priority == BRASERO_ASYNC_URGENT)
-		self->priv->waiting_tasks = g_slist_prepend (self->priv->waiting_tasks, ctx);
+
+	/* The last urgent task queued is the most urgent one */
+	if (priority == BRASERO_ASYNC_URGENT)
+		g_queue_push_head (brasero_async_task_manager_get_queue (self, priority), ctx);
+	else
+		g_queue_push_tail (brasero_async_task_manager_get_queue (self, priority), ctx);
 
 	if (self->priv->unused_threads) {
 		/* wake up one thread in the list */
 		g_cond_signal (self->priv->new_task);
 	}
-	else if (self->priv->num_threads < MANAGER_MAX_THREAD) {
+	else if (self->priv->num_threads < self->priv->max_threads) {
 		GError *error = NULL;
 		GThread *thread;
 
@@ -352,7 +384,7 @@ brasero_async_task_manager_queue (BraseroAsyncTaskManager *self,
 			g_warning ("Can't start thread : %s\n", error->message);
 			g_error_free (error);
 
-			self->priv->waiting_tasks = g_slist_remove (self->priv->waiting_tasks, ctx);
+			g_queue_remove (brasero_async_task_manager_get_queue (self, priority), ctx);
 			g_mutex_unlock (self->priv->lock);
 
 			g_free (ctx);
@@ -445,25 +477,31 @@ brasero_async_task_manager_foreach_unprocessed_remove (BraseroAsyncTaskManager *
 						       gpointer user_data)
 {
 	BraseroAsyncTaskCtx *ctx;
-	GSList *iter, *next;
+	GList *iter, *next;
+	gint i;
 
 	g_return_val_if_fail (self != NULL, FALSE);
 	g_return_val_if_fail (func != NULL, FALSE);
 
 	g_mutex_lock (self->priv->lock);
 
-	for (iter = self->priv->waiting_tasks; iter; iter = next) {
-		ctx = iter->data;
-		next = iter->next;
+	for (i = 0; i < BRASERO_ASYNC_QUEUE_NUM; i ++) {
+		GQueue *queue;
 
-		if (func (self, ctx->data, user_data)) {
-			self->priv->waiting_tasks = g_slist_remove (self->priv->waiting_tasks, ctx);
+		queue = &self->priv->waiting_tasks [i];
+		for (iter = queue->head; iter; iter = next) {
+			ctx = iter->data;
+			next = iter->next;
 
-			/* call the destroy callback */
-			if (ctx->type->destroy)
-				ctx->type->destroy (self, TRUE, ctx->data);
+			if (func (self, ctx->data, user_data)) {
+				g_queue_delete_link (queue, iter);
 
-			g_free (ctx);
+				/* call the destroy callback */
+				if (ctx->type->destroy)
+					ctx->type->destroy (self, TRUE, ctx->data);
+
+				g_free (ctx);
+			}
 		}
 	}
 	g_mutex_unlock (self->priv->lock);
@@ -476,26 +514,51 @@ brasero_async_task_manager_find_urgent_task (BraseroAsyncTaskManager *self,
 					     BraseroAsyncFindTask func,
 					     gpointer user_data)
 {
-	GSList *iter;
 	BraseroAsyncTaskCtx *ctx;
+	GList *iter;
+	gint i;
 
 	g_return_val_if_fail (self != NULL, FALSE);
 	g_return_val_if_fail (func != NULL, FALSE);
 
 	g_mutex_lock (self->priv->lock);
-	for (iter = self->priv->waiting_tasks; iter; iter = iter->next) {
-		ctx = iter->data;
+	for (i = 0; i < BRASERO_ASYNC_QUEUE_NUM; i ++) {
+		GQueue *queue;
 
-		if (func (self, ctx->data, user_data)) {
-			ctx->priority = BRASERO_ASYNC_URGENT;
+		queue = &self->priv->waiting_tasks [i];
+		for (iter = queue->head; iter; iter = iter->next) {
+			ctx = iter->data;
 
-			self->priv->waiting_tasks = g_slist_remove (self->priv->waiting_tasks, ctx);
-			self->priv->waiting_tasks = g_slist_prepend (self->priv->waiting_tasks, ctx);
-			g_mutex_unlock (self->priv->lock);
-			return TRUE;
+			if (func (self, ctx->data, user_data)) {
+				ctx->priority = BRASERO_ASYNC_URGENT;
+
+				g_queue_delete_link (queue, iter);
+				g_queue_push_head (&self->priv->waiting_tasks [BRASERO_ASYNC_QUEUE_URGENT], ctx);
+				g_mutex_unlock (self->priv->lock);
+				return TRUE;
+			}
 		}
 	}
 	g_mutex_unlock (self->priv->lock);
 
 	return FALSE;
 }
+
+/**
+ * Sets the maximum number of threads running tasks at the same time.
+ * 0 restores the default which depends on the number of processors.
+ */
+
+void
+brasero_async_task_manager_set_max_threads (BraseroAsyncTaskManager *self,
+					    guint max_threads)
+{
+	g_return_if_fail (self != NULL);
+
+	g_mutex_lock (self->priv->lock);
+	if (max_threads)
+		self->priv->max_threads = max_threads;
+	else
+		self->priv->max_threads = brasero_async_task_manager_get_default_max_threads ();
+	g_mutex_unlock (self->priv->lock);
+}
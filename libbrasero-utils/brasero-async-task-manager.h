@@ -114,6 +114,10 @@ brasero_async_task_manager_find_urgent_task (BraseroAsyncTaskManager *manager,
 					     BraseroAsyncFindTask func,
 					     gpointer user_data);
 
+void
+brasero_async_task_manager_set_max_threads (BraseroAsyncTaskManager *manager,
+					    guint max_threads);
+
 G_END_DECLS
 
 #endif /* ASYNC_JOB_MANAGER_H */
@@ -32,8 +32,16 @@
 #  include <config.h>
 #endif
 
+/* Needed for statx () and AT_STATX_DONT_SYNC */
+#define _GNU_SOURCE
+
 #include <string.h>
 #include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <sys/types.h>
+#include <sys/stat.h>
 
 #include <glib.h>
 #include <glib-object.h>
@@ -53,6 +61,7 @@
 #include "brasero-misc.h"
 #include "brasero-io.h"
 #include "brasero-metadata.h"
+#include "brasero-metadata-cache.h"
 #include "brasero-async-task-manager.h"
 
 #define BRASERO_TYPE_IO             (brasero_io_get_type ())
@@ -90,28 +99,35 @@ struct _BraseroIOPrivate
 
 	/* used for metadata */
 	GMutex *lock_metadata;
+	GCond *metadata_available;
 
 	GSList *metadatas;
 	GSList *metadata_running;
 
-	/* used to "buffer" some results returned by metadata.
-	 * It takes time to return metadata and it's not unusual
-	 * to fetch metadata three times in a row, once for size
-	 * preview, once for preview, once adding to selection */
-	GQueue *meta_buffer;
+	guint max_metadata;
+	guint urgent_waiting;
 
 	guint progress_id;
 	GSList *progress;
 
 	BraseroIOGetParentWinCb win_callback;
 	gpointer win_user_data;
+
+	GSettings *settings;
 };
 
 #define BRASERO_IO_PRIVATE(o)  (G_TYPE_INSTANCE_GET_PRIVATE ((o), BRASERO_TYPE_IO, BraseroIOPrivate))
 
-/* so far 2 metadata at a time has shown to be the best for performance */
-#define MAX_CONCURENT_META 	2
-#define MAX_BUFFERED_META	20
+/* Each metadata retrieval runs its own GStreamer pipeline which is mostly
+ * CPU bound so the number of them running at the same time depends on the
+ * number of processors */
+#define MIN_CONCURENT_META 	2
+#define MAX_CONCURENT_META 	8
+
+/* Settings overriding these defaults; 0 means the default */
+#define BRASERO_SCHEMA_CONFIG		"org.gnome.brasero.config"
+#define BRASERO_PROPS_IO_MAX_THREADS	"io-max-threads"
+#define BRASERO_PROPS_IO_MAX_METADATA	"io-max-metadata"
 
 struct _BraseroIOJobResult {
 	const BraseroIOJobBase *base;
@@ -798,40 +814,255 @@ brasero_io_check_symlink_target (GFile *parent,
 	return TRUE;
 }
 
+#ifdef HAVE_FDOPENDIR
+
 /**
- * Used to retrieve metadata for audio files
+ * Native enumeration of local directories. GIO creates a GFile for every
+ * child, stats it several times and builds its URI from its path; here the
+ * directory is read once and each entry only costs one or two stat calls
+ * relative to the directory. It only provides what doesn't need GIO: name,
+ * size, type, symlink target and access.
  */
 
-struct _BraserIOMetadataTask {
-	gchar *uri;
-	GSList *results;
+struct _BraseroIONativeStat {
+	guint32 mode;
+	guint64 size;
 };
-typedef struct _BraseroIOMetadataTask BraseroIOMetadataTask;
+typedef struct _BraseroIONativeStat BraseroIONativeStat;
 
-struct _BraseroIOMetadataCached {
-	guint64 last_modified;
-	BraseroMetadataInfo *info;
+static gboolean
+brasero_io_native_stat (int dir_fd,
+			const gchar *name,
+			gboolean follow,
+			BraseroIONativeStat *stat_buf)
+{
+	struct stat st;
 
-	guint missing_codec_used:1;
-};
-typedef struct _BraseroIOMetadataCached BraseroIOMetadataCached;
+#ifdef HAVE_STATX
+
+	struct statx stx;
+
+	/* Don't force network file systems to synchronise attributes */
+	if (!statx (dir_fd,
+		    name,
+		    AT_STATX_DONT_SYNC|(follow? 0:AT_SYMLINK_NOFOLLOW),
+		    STATX_TYPE|STATX_SIZE,
+		    &stx)) {
+		stat_buf->mode = stx.stx_mode;
+		stat_buf->size = stx.stx_size;
+		return TRUE;
+	}
+
+	/* The kernel may be too old for statx () */
+	if (errno != ENOSYS)
+		return FALSE;
+
+#endif
+
+	if (fstatat (dir_fd, name, &st, follow? 0:AT_SYMLINK_NOFOLLOW))
+		return FALSE;
+
+	stat_buf->mode = st.st_mode;
+	stat_buf->size = st.st_size;
+	return TRUE;
+}
+
+static GFileType
+brasero_io_native_file_type (guint32 mode)
+{
+	if (S_ISREG (mode))
+		return G_FILE_TYPE_REGULAR;
 
-static gint
-brasero_io_metadata_lookup_buffer (gconstpointer a, gconstpointer b)
+	if (S_ISDIR (mode))
+		return G_FILE_TYPE_DIRECTORY;
+
+	if (S_ISLNK (mode))
+		return G_FILE_TYPE_SYMBOLIC_LINK;
+
+	return G_FILE_TYPE_SPECIAL;
+}
+
+static gchar *
+brasero_io_native_read_link (int dir_fd,
+			     const gchar *name)
 {
-	const BraseroIOMetadataCached *cached = a;
-	const gchar *uri = b;
+	gsize size = 256;
+	gchar *target;
+
+	target = g_malloc (size);
+	while (1) {
+		ssize_t len;
+
+		len = readlinkat (dir_fd, name, target, size);
+		if (len < 0) {
+			g_free (target);
+			return NULL;
+		}
+
+		if ((gsize) len < size) {
+			target [len] = '\0';
+			return target;
+		}
 
-	return strcmp (uri, cached->info->uri);
+		size *= 2;
+		target = g_realloc (target, size);
+	}
 }
 
-static void
-brasero_io_metadata_cached_free (BraseroIOMetadataCached *cached)
+/**
+ * Returns the same URI as g_file_get_uri () would for the child name of
+ * the directory whose URI is directory_uri.
+ */
+
+static gchar *
+brasero_io_native_child_uri (const gchar *directory_uri,
+			     const gchar *name)
+{
+	gchar *escaped;
+	gchar *path;
+	gchar *uri;
+	gint len;
+	gint i;
+
+	len = strlen (directory_uri);
+	if (len && directory_uri [len - 1] == '/')
+		len --;
+
+	/* Most names don't need escaping */
+	for (i = 0; name [i]; i ++) {
+		if (!g_ascii_isalnum (name [i])
+		&&  name [i] != '-'
+		&&  name [i] != '.'
+		&&  name [i] != '_'
+		&&  name [i] != '~')
+			break;
+	}
+
+	if (!name [i])
+		return g_strdup_printf ("%.*s/%s", len, directory_uri, name);
+
+	/* Escape it the way g_filename_to_uri () does */
+	path = g_strconcat (G_DIR_SEPARATOR_S, name, NULL);
+	escaped = g_filename_to_uri (path, NULL, NULL);
+	g_free (path);
+
+	if (!escaped)
+		return NULL;
+
+	/* skip "file://" */
+	uri = g_strdup_printf ("%.*s%s", len, directory_uri, escaped + 7);
+	g_free (escaped);
+	return uri;
+}
+
+static GFileInfo *
+brasero_io_native_info_new (int dir_fd,
+			    const gchar *name,
+			    BraseroIOFlags options)
+{
+	BraseroIONativeStat stat_buf;
+	GFileInfo *info;
+
+	if (!brasero_io_native_stat (dir_fd, name, FALSE, &stat_buf))
+		return NULL;
+
+	info = g_file_info_new ();
+	g_file_info_set_name (info, name);
+
+	if (S_ISLNK (stat_buf.mode)) {
+		gchar *target;
+
+		g_file_info_set_is_symlink (info, TRUE);
+
+		target = brasero_io_native_read_link (dir_fd, name);
+		if (target) {
+			g_file_info_set_symlink_target (info, target);
+			g_free (target);
+		}
+
+		/* Like GIO, keep the link itself if the target is missing */
+		if (options & BRASERO_IO_INFO_FOLLOW_SYMLINK)
+			brasero_io_native_stat (dir_fd, name, TRUE, &stat_buf);
+	}
+	else
+		g_file_info_set_is_symlink (info, FALSE);
+
+	g_file_info_set_file_type (info, brasero_io_native_file_type (stat_buf.mode));
+	g_file_info_set_size (info, stat_buf.size);
+
+	if (options & BRASERO_IO_INFO_PERM)
+		g_file_info_set_attribute_boolean (info,
+						   G_FILE_ATTRIBUTE_ACCESS_CAN_READ,
+						   faccessat (dir_fd, name, R_OK, 0) == 0);
+
+	return info;
+}
+
+static DIR *
+brasero_io_native_open_directory (GFile *file,
+				  GError **error)
+{
+	gchar *path;
+	int dir_fd;
+	DIR *dir;
+
+	path = g_file_get_path (file);
+	if (!path) {
+		g_set_error_literal (error,
+				     G_IO_ERROR,
+				     G_IO_ERROR_NOT_SUPPORTED,
+				     g_strerror (ENOTSUP));
+		return NULL;
+	}
+
+	dir_fd = open (path, O_RDONLY|O_DIRECTORY|O_CLOEXEC);
+	g_free (path);
+
+	if (dir_fd < 0) {
+		int errsv = errno;
+
+		g_set_error_literal (error,
+				     G_IO_ERROR,
+				     g_io_error_from_errno (errsv),
+				     g_strerror (errsv));
+		return NULL;
+	}
+
+	dir = fdopendir (dir_fd);
+	if (!dir) {
+		int errsv = errno;
+
+		close (dir_fd);
+		g_set_error_literal (error,
+				     G_IO_ERROR,
+				     g_io_error_from_errno (errsv),
+				     g_strerror (errsv));
+		return NULL;
+	}
+
+	return dir;
+}
+
+static gboolean
+brasero_io_native_skip_entry (const gchar *name)
 {
-	brasero_metadata_info_free (cached->info);
-	g_free (cached);
+	return (name [0] == '.'
+	    && (name [1] == '\0'
+	    || (name [1] == '.' && name [2] == '\0')));
 }
 
+#endif /* HAVE_FDOPENDIR */
+
+/**
+ * Used to retrieve metadata for audio files
+ */
+
+struct _BraserIOMetadataTask {
+	gchar *uri;
+	GSList *results;
+};
+typedef struct _BraseroIOMetadataTask BraseroIOMetadataTask;
+
 static void
 brasero_io_set_metadata_attributes (GFileInfo *info,
 				    BraseroMetadataInfo *metadata)
@@ -879,11 +1110,33 @@ brasero_io_set_metadata_attributes (GFileInfo *info,
 	/* FIXME: what about silences */
 }
 
+static gboolean
+brasero_io_metadata_available (BraseroIO *self,
+			       gboolean urgent)
+{
+	BraseroIOPrivate *priv;
+
+	priv = BRASERO_IO_PRIVATE (self);
+
+	if (!priv->metadatas)
+		return FALSE;
+
+	if (g_slist_length (priv->metadata_running) >= priv->max_metadata)
+		return FALSE;
+
+	/* Let the visible rows be served first */
+	if (!urgent && priv->urgent_waiting)
+		return FALSE;
+
+	return TRUE;
+}
+
 static BraseroMetadata *
 brasero_io_find_metadata (BraseroIO *self,
 			  GCancellable *cancel,
 			  const gchar *uri,
 			  BraseroMetadataFlag flags,
+			  gboolean urgent,
 			  GError **error)
 {
 	GSList *iter;
@@ -926,23 +1179,41 @@ brasero_io_find_metadata (BraseroIO *self,
 		}
 	}
 
-	/* Grab an available metadata (NOTE: there should always be at least one
-	 * since we run 2 threads at max and have two metadatas available) */
-	while (!priv->metadatas) {
-		if (g_cancellable_is_cancelled (cancel))
+	/* Grab an available metadata. There may be more threads than metadatas
+	 * so wait for one to be put back. Wake up from time to time to check
+	 * for cancellation. */
+	if (urgent)
+		priv->urgent_waiting ++;
+
+	while (!brasero_io_metadata_available (self, urgent)) {
+		GTimeVal timeout;
+
+		if (g_cancellable_is_cancelled (cancel)) {
+			if (urgent)
+				priv->urgent_waiting --;
+
+			g_cond_broadcast (priv->metadata_available);
 			return NULL;
+		}
 
-		g_mutex_unlock (priv->lock_metadata);
-		g_usleep (250);
-		g_mutex_lock (priv->lock_metadata);
+		g_get_current_time (&timeout);
+		g_time_val_add (&timeout, 250000);
+		g_cond_timed_wait (priv->metadata_available,
+				   priv->lock_metadata,
+				   &timeout);
 	}
 
+	if (urgent)
+		priv->urgent_waiting --;
+
 	/* One metadata is finally available */
 	metadata = priv->metadatas->data;
 
 	/* Try to set it up for running */
-	if (!brasero_metadata_set_uri (metadata, flags, uri, error))
+	if (!brasero_metadata_set_uri (metadata, flags, uri, error)) {
+		g_cond_broadcast (priv->metadata_available);
 		return NULL;
+	}
 
 	/* The metadata is ready for running put it in right queue */
 	brasero_metadata_increase_listener_number (metadata);
@@ -955,6 +1226,7 @@ brasero_io_find_metadata (BraseroIO *self,
 static gboolean
 brasero_io_wait_for_metadata (BraseroIO *self,
 			      GCancellable *cancel,
+			      const gchar *uri,
 			      GFileInfo *info,
 			      BraseroMetadata *metadata,
 			      BraseroMetadataFlag flags,
@@ -983,26 +1255,9 @@ brasero_io_wait_for_metadata (BraseroIO *self,
 		return result;
 	}
 
-	if (result) {
-		/* see if we should add it to the buffer */
-		if (meta_info->has_audio || meta_info->has_video) {
-			BraseroIOMetadataCached *cached;
-
-			cached = g_new0 (BraseroIOMetadataCached, 1);
-			cached->last_modified = g_file_info_get_attribute_uint64 (info, G_FILE_ATTRIBUTE_STANDARD_SIZE);
-
-			cached->info = g_new0 (BraseroMetadataInfo, 1);
-			brasero_metadata_get_result (metadata, cached->info, NULL);
-
-			cached->missing_codec_used = (flags & BRASERO_METADATA_FLAG_MISSING) != 0;
-
-			g_queue_push_head (priv->meta_buffer, cached);
-			if (g_queue_get_length (priv->meta_buffer) > MAX_BUFFERED_META) {
-				cached = g_queue_pop_tail (priv->meta_buffer);
-				brasero_io_metadata_cached_free (cached);
-			}
-		}
-	}
+	/* see if we should add it to the cache */
+	if (result)
+		brasero_metadata_cache_add (uri, info, flags, meta_info);
 
 	/* Make sure it is stopped */
 	BRASERO_UTILS_LOG ("Stopping metadata information retrieval (%p)", metadata);
@@ -1010,6 +1265,7 @@ brasero_io_wait_for_metadata (BraseroIO *self,
 
 	priv->metadata_running = g_slist_remove (priv->metadata_running, metadata);
 	priv->metadatas = g_slist_append (priv->metadatas, metadata);
+	g_cond_broadcast (priv->metadata_available);
 
 	g_mutex_unlock (priv->lock_metadata);
 
@@ -1022,12 +1278,12 @@ brasero_io_get_metadata_info (BraseroIO *self,
 			      const gchar *uri,
 			      GFileInfo *info,
 			      BraseroMetadataFlag flags,
+			      gboolean urgent,
 			      BraseroMetadataInfo *meta_info)
 {
 	BraseroMetadata *metadata = NULL;
 	BraseroIOPrivate *priv;
 	const gchar *mime;
-	GList *node;
 
 	if (g_cancellable_is_cancelled (cancel))
 		return FALSE;
@@ -1044,56 +1300,20 @@ brasero_io_get_metadata_info (BraseroIO *self,
 	||  !strcmp (mime, "application/x-cd-image")))
 		return FALSE;
 
+	/* See if we have already explored these metadata (possibly during
+	 * a previous session). The cache checks the size and the last modified
+	 * time of the file in case a result should be updated. It takes time
+	 * to return metadata and it's not unusual to fetch metadata three times
+	 * in a row, once for size preview, once for preview, once adding to
+	 * selection. */
+	if (brasero_metadata_cache_lookup (uri, info, flags, meta_info))
+		return TRUE;
+
 	BRASERO_UTILS_LOG ("Retrieving metadata info");
 	g_mutex_lock (priv->lock_metadata);
 
-	/* Seek in the buffer if we have already explored these metadata. Check 
-	 * the info last modified time in case a result should be updated. */
-	node = g_queue_find_custom (priv->meta_buffer,
-				    uri,
-				    brasero_io_metadata_lookup_buffer);
-	if (node) {
-		guint64 last_modified;
-		BraseroIOMetadataCached *cached;
-
-		cached = node->data;
-		last_modified = g_file_info_get_attribute_uint64 (info, G_FILE_ATTRIBUTE_STANDARD_SIZE);
-		if (last_modified == cached->last_modified) {
-			gboolean refresh_cache = FALSE;
-
-			if (flags & BRASERO_METADATA_FLAG_MISSING) {
-				/* This cached result may indicate an error and
-				 * this error could be related to the fact that
-				 * it was not first looked for with missing
-				 * codec detection. */
-				if (!cached->missing_codec_used)
-					refresh_cache = TRUE;
-			}
-
-			if (flags & BRASERO_METADATA_FLAG_THUMBNAIL) {
-				/* If there isn't any snapshot retry */
-				if (!cached->info->snapshot)
-					refresh_cache = TRUE;
-			}
-
-			if (!refresh_cache) {
-				brasero_metadata_info_copy (meta_info, cached->info);
-				g_mutex_unlock (priv->lock_metadata);
-				return TRUE;
-			}
-		}
-
-		/* Found the same URI but it didn't have all required flags so
-		 * we'll get another metadata information; Remove it from the
-		 * queue => no same URI twice */
-		g_queue_remove (priv->meta_buffer, cached);
-		brasero_io_metadata_cached_free (cached);
-
-		BRASERO_UTILS_LOG ("Updating cache information for %s", uri);
-	}
-
 	/* Find a metadata */
-	metadata = brasero_io_find_metadata (self, cancel, uri, flags, NULL);
+	metadata = brasero_io_find_metadata (self, cancel, uri, flags, urgent, NULL);
 	g_mutex_unlock (priv->lock_metadata);
 
 	if (!metadata)
@@ -1101,6 +1321,7 @@ brasero_io_get_metadata_info (BraseroIO *self,
 
 	return brasero_io_wait_for_metadata (self,
 					     cancel,
+					     uri,
 					     info,
 					     metadata,
 					     flags,
@@ -1139,10 +1360,10 @@ brasero_io_get_file_info_thread_real (BraseroAsyncTaskManager *manager,
 	if (options & BRASERO_IO_INFO_METADATA_THUMBNAIL)
 		strcat (attributes, "," G_FILE_ATTRIBUTE_THUMBNAIL_PATH);
 
-	/* if retrieving metadata we need this one to check if a possible result
+	/* if retrieving metadata we need these to check if a possible result
 	 * in cache should be updated or used */
 	if (options & BRASERO_IO_INFO_METADATA)
-		strcat (attributes, "," G_FILE_ATTRIBUTE_STANDARD_SIZE);
+		strcat (attributes, "," G_FILE_ATTRIBUTE_TIME_MODIFIED);
 
 	info = g_file_query_info (file,
 				  attributes,
@@ -1238,6 +1459,7 @@ brasero_io_get_file_info_thread_real (BraseroAsyncTaskManager *manager,
 						       uri,
 						       info,
 						       flags,
+						       (options & BRASERO_IO_INFO_URGENT) != 0,
 						       &metadata);
 		g_free (uri);
 
@@ -1341,6 +1563,71 @@ brasero_io_get_file_info (const gchar *uri,
 	g_object_unref (self);
 }
 
+/**
+ * Returns the information for a local regular file when the metadata cache
+ * holds a valid result for it, NULL otherwise. It only needs to stat the file
+ * so it can be used from the main loop to avoid a trip through the threads.
+ */
+
+GFileInfo *
+brasero_io_get_file_info_cached (const gchar *uri,
+				 BraseroIOFlags options)
+{
+	BraseroMetadataInfo metadata = { NULL };
+	BraseroMetadataFlag flags;
+	GFileInfo *info;
+	GFile *file;
+
+	if (!(options & BRASERO_IO_INFO_METADATA))
+		return NULL;
+
+	file = g_file_new_for_uri (uri);
+	if (!g_file_is_native (file)) {
+		g_object_unref (file);
+		return NULL;
+	}
+
+	info = g_file_query_info (file,
+				  G_FILE_ATTRIBUTE_STANDARD_NAME ","
+				  G_FILE_ATTRIBUTE_STANDARD_SIZE ","
+				  G_FILE_ATTRIBUTE_STANDARD_IS_SYMLINK ","
+				  G_FILE_ATTRIBUTE_STANDARD_TYPE ","
+				  G_FILE_ATTRIBUTE_ACCESS_CAN_READ ","
+				  G_FILE_ATTRIBUTE_TIME_MODIFIED,
+				  G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS,
+				  NULL,
+				  NULL);
+	g_object_unref (file);
+
+	if (!info)
+		return NULL;
+
+	/* Symlinks need to be checked by the thread */
+	if (g_file_info_get_file_type (info) != G_FILE_TYPE_REGULAR) {
+		g_object_unref (info);
+		return NULL;
+	}
+
+	flags = ((options & BRASERO_IO_INFO_METADATA_MISSING_CODEC) ? BRASERO_METADATA_FLAG_MISSING : 0)|
+		((options & BRASERO_IO_INFO_METADATA_THUMBNAIL) ? BRASERO_METADATA_FLAG_THUMBNAIL : 0);
+
+	if (!brasero_metadata_cache_lookup (uri, info, flags, &metadata)) {
+		g_object_unref (info);
+		return NULL;
+	}
+
+	/* The content type comes from the result */
+	if (!metadata.type) {
+		brasero_metadata_info_clear (&metadata);
+		g_object_unref (info);
+		return NULL;
+	}
+
+	brasero_io_set_metadata_attributes (info, &metadata);
+	brasero_metadata_info_clear (&metadata);
+	return info;
+}
+
 /**
  * Used to parse playlists
  */
@@ -1600,6 +1887,7 @@ brasero_io_get_file_count_process_playlist (BraseroIO *self,
 						       info,
 						       ((data->job.options & BRASERO_IO_INFO_METADATA_MISSING_CODEC) ? BRASERO_METADATA_FLAG_MISSING : 0) |
 						       ((data->job.options & BRASERO_IO_INFO_METADATA_THUMBNAIL) ? BRASERO_METADATA_FLAG_THUMBNAIL : 0),
+						       (data->job.options & BRASERO_IO_INFO_URGENT) != 0,
 						       &metadata);
 
 		if (result)
@@ -1636,6 +1924,7 @@ brasero_io_get_file_count_process_file (BraseroIO *self,
 						       info,
 						       ((data->job.options & BRASERO_IO_INFO_METADATA_MISSING_CODEC) ? BRASERO_METADATA_FLAG_MISSING : 0) |
 						       ((data->job.options & BRASERO_IO_INFO_METADATA_THUMBNAIL) ? BRASERO_METADATA_FLAG_THUMBNAIL : 0),
+						       (data->job.options & BRASERO_IO_INFO_URGENT) != 0,
 						       &metadata);
 		if (result)
 			data->total_b += metadata.len;
@@ -1672,6 +1961,53 @@ brasero_io_get_file_count_process_file (BraseroIO *self,
 	data->total_b += g_file_info_get_size (info);
 }
 
+#ifdef HAVE_FDOPENDIR
+
+static void
+brasero_io_get_file_count_process_directory_native (BraseroIO *self,
+						    GCancellable *cancel,
+						    BraseroIOCountData *data,
+						    GFile *file)
+{
+	struct dirent *entry;
+	int dir_fd;
+	DIR *dir;
+
+	dir = brasero_io_native_open_directory (file, NULL);
+	if (!dir)
+		return;
+
+	dir_fd = dirfd (dir);
+	while ((entry = readdir (dir))) {
+		BraseroIONativeStat stat_buf;
+
+		if (brasero_io_native_skip_entry (entry->d_name))
+			continue;
+
+		if (g_cancellable_is_cancelled (cancel))
+			break;
+
+		data->files_num ++;
+
+		if (!brasero_io_native_stat (dir_fd,
+					     entry->d_name,
+					     (data->job.options & BRASERO_IO_INFO_FOLLOW_SYMLINK) != 0,
+					     &stat_buf)) {
+			data->files_invalid ++;
+			continue;
+		}
+
+		if (S_ISREG (stat_buf.mode) || S_ISLNK (stat_buf.mode))
+			data->total_b += stat_buf.size;
+		else if (S_ISDIR (stat_buf.mode))
+			data->children = g_slist_prepend (data->children, g_file_get_child (file, entry->d_name));
+	}
+
+	closedir (dir);
+}
+
+#endif
+
 static void
 brasero_io_get_file_count_process_directory (BraseroIO *self,
 					     GCancellable *cancel,
@@ -1687,11 +2023,24 @@ brasero_io_get_file_count_process_directory (BraseroIO *self,
 
 	if ((data->job.options & BRASERO_IO_INFO_METADATA)
 	&&  (data->job.options & BRASERO_IO_INFO_RECURSIVE))
-		strcat (attributes, "," G_FILE_ATTRIBUTE_STANDARD_CONTENT_TYPE);
+		strcat (attributes, "," G_FILE_ATTRIBUTE_STANDARD_CONTENT_TYPE ","
+				    G_FILE_ATTRIBUTE_TIME_MODIFIED);
 
 	file = data->children->data;
 	data->children = g_slist_remove (data->children, file);
 
+#ifdef HAVE_FDOPENDIR
+
+	/* Without metadata only sizes and types are needed */
+	if (!(data->job.options & BRASERO_IO_INFO_METADATA)
+	&&  g_file_has_uri_scheme (file, "file")) {
+		brasero_io_get_file_count_process_directory_native (self, cancel, data, file);
+		g_object_unref (file);
+		return;
+	}
+
+#endif
+
 	enumerator = g_file_enumerate_children (file,
 						attributes,
 						(data->job.options & BRASERO_IO_INFO_FOLLOW_SYMLINK)?G_FILE_QUERY_INFO_NONE:G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS,	/* follow symlinks by default*/
@@ -1754,7 +2103,8 @@ brasero_io_get_file_count_start (BraseroIO *self,
 
 	if ((data->job.options & BRASERO_IO_INFO_METADATA)
 	&&  (data->job.options & BRASERO_IO_INFO_RECURSIVE))
-		strcat (attributes, "," G_FILE_ATTRIBUTE_STANDARD_CONTENT_TYPE);
+		strcat (attributes, "," G_FILE_ATTRIBUTE_STANDARD_CONTENT_TYPE ","
+				    G_FILE_ATTRIBUTE_TIME_MODIFIED);
 
 	file = g_file_new_for_uri (uri);
 	info = g_file_query_info (file,
@@ -1946,6 +2296,7 @@ brasero_io_load_directory_playlist (BraseroIO *self,
 						       info,
 						       ((data->job.options & BRASERO_IO_INFO_METADATA_MISSING_CODEC) ? BRASERO_METADATA_FLAG_MISSING : 0) |
 						       ((data->job.options & BRASERO_IO_INFO_METADATA_THUMBNAIL) ? BRASERO_METADATA_FLAG_THUMBNAIL : 0),
+						       (data->job.options & BRASERO_IO_INFO_URGENT) != 0,
 						       &metadata);
 
 		if (result) {
@@ -1970,6 +2321,167 @@ brasero_io_load_directory_playlist (BraseroIO *self,
 
 #endif
 
+/**
+ * Returns the result for one entry of a directory. info is consumed.
+ * Returns TRUE if it is a directory whose contents must be explored too.
+ */
+
+static gboolean
+brasero_io_load_directory_entry (BraseroIO *self,
+				 GCancellable *cancel,
+				 BraseroIOContentsData *data,
+				 GFile *parent,
+				 const gchar *child_uri,
+				 GFileInfo *info,
+				 const gchar *attributes)
+{
+	/* special case for symlinks */
+	if (g_file_info_get_is_symlink (info)) {
+		if (!brasero_io_check_symlink_target (parent, info)) {
+			GError *error;
+
+			error = g_error_new (BRASERO_UTILS_ERROR,
+					     BRASERO_UTILS_ERROR_SYMLINK_LOOP,
+					     _("Recursive symbolic link"));
+
+			/* since we checked for the existence of the file
+			 * an error means a looping symbolic link */
+			brasero_io_return_result (data->job.base,
+						  child_uri,
+						  NULL,
+						  error,
+						  data->job.callback_data);
+
+			g_object_unref (info);
+			return FALSE;
+		}
+	}
+
+	if (g_file_info_get_file_type (info) == G_FILE_TYPE_DIRECTORY) {
+		brasero_io_return_result (data->job.base,
+					  child_uri,
+					  info,
+					  NULL,
+					  data->job.callback_data);
+
+		return (data->job.options & BRASERO_IO_INFO_RECURSIVE) != 0;
+	}
+
+	if (data->job.options & BRASERO_IO_INFO_METADATA) {
+		BraseroMetadataInfo metadata = {NULL, };
+		gboolean result;
+
+		/* add metadata information to this file */
+		result = brasero_io_get_metadata_info (self,
+						       cancel,
+						       child_uri,
+						       info,
+						       ((data->job.options & BRASERO_IO_INFO_METADATA_MISSING_CODEC) ? BRASERO_METADATA_FLAG_MISSING : 0) |
+						       ((data->job.options & BRASERO_IO_INFO_METADATA_THUMBNAIL) ? BRASERO_METADATA_FLAG_THUMBNAIL : 0),
+						       (data->job.options & BRASERO_IO_INFO_URGENT) != 0,
+						       &metadata);
+
+		if (result)
+			brasero_io_set_metadata_attributes (info, &metadata);
+
+#ifdef BUILD_PLAYLIST
+
+		else if (data->job.options & BRASERO_IO_INFO_RECURSIVE) {
+			const gchar *mime;
+
+			mime = g_file_info_get_content_type (info);
+			if (mime
+			&& (!strcmp (mime, "audio/x-scpls")
+			||  !strcmp (mime, "audio/x-ms-asx")
+			||  !strcmp (mime, "audio/x-mp3-playlist")
+			||  !strcmp (mime, "audio/x-mpegurl")))
+				brasero_io_load_directory_playlist (self,
+								    cancel,
+								    data,
+								    child_uri,
+								    attributes);
+		}
+
+#endif
+
+		brasero_metadata_info_clear (&metadata);
+	}
+
+	brasero_io_return_result (data->job.base,
+				  child_uri,
+				  info,
+				  NULL,
+				  data->job.callback_data);
+	return FALSE;
+}
+
+#ifdef HAVE_FDOPENDIR
+
+static void
+brasero_io_load_directory_native (BraseroIO *self,
+				  GCancellable *cancel,
+				  BraseroIOContentsData *data,
+				  GFile *file,
+				  const gchar *attributes)
+{
+	struct dirent *entry;
+	gchar *directory_uri;
+	GError *error = NULL;
+	int dir_fd;
+	DIR *dir;
+
+	directory_uri = g_file_get_uri (file);
+
+	dir = brasero_io_native_open_directory (file, &error);
+	if (!dir) {
+		brasero_io_return_result (data->job.base,
+					  directory_uri,
+					  NULL,
+					  error,
+					  data->job.callback_data);
+		g_free (directory_uri);
+		return;
+	}
+
+	dir_fd = dirfd (dir);
+	while ((entry = readdir (dir))) {
+		gchar *child_uri;
+		GFileInfo *info;
+
+		if (g_cancellable_is_cancelled (cancel))
+			break;
+
+		if (brasero_io_native_skip_entry (entry->d_name))
+			continue;
+
+		info = brasero_io_native_info_new (dir_fd, entry->d_name, data->job.options);
+		if (!info)
+			continue;
+
+		child_uri = brasero_io_native_child_uri (directory_uri, entry->d_name);
+		if (!child_uri) {
+			g_object_unref (info);
+			continue;
+		}
+
+		if (brasero_io_load_directory_entry (self,
+						     cancel,
+						     data,
+						     file,
+						     child_uri,
+						     info,
+						     attributes))
+			data->children = g_slist_prepend (data->children, g_file_get_child (file, entry->d_name));
+
+		g_free (child_uri);
+	}
+
+	closedir (dir);
+	g_free (directory_uri);
+}
+
+#endif
+
 static BraseroAsyncTaskResult
 brasero_io_load_directory_thread (BraseroAsyncTaskManager *manager,
 				  GCancellable *cancel,
@@ -1998,6 +2510,9 @@ brasero_io_load_directory_thread (BraseroAsyncTaskManager *manager,
 	if (data->job.options & BRASERO_IO_INFO_ICON)
 		strcat (attributes, "," G_FILE_ATTRIBUTE_STANDARD_ICON);
 
+	if (data->job.options & BRASERO_IO_INFO_METADATA)
+		strcat (attributes, "," G_FILE_ATTRIBUTE_TIME_MODIFIED);
+
 	if (data->children) {
 		file = data->children->data;
 		data->children = g_slist_remove (data->children, file);
@@ -2005,6 +2520,27 @@ brasero_io_load_directory_thread (BraseroAsyncTaskManager *manager,
 	else
 		file = g_file_new_for_uri (data->job.uri);
 
+#ifdef HAVE_FDOPENDIR
+
+	/* Local directories don't need GIO unless we want the MIME type, the
+	 * icon or metadata which are much slower to get anyway. */
+	if (!(data->job.options & (BRASERO_IO_INFO_MIME|BRASERO_IO_INFO_ICON|BRASERO_IO_INFO_METADATA))
+	&&  g_file_has_uri_scheme (file, "file")) {
+		brasero_io_load_directory_native (BRASERO_IO (manager),
+						  cancel,
+						  data,
+						  file,
+						  attributes);
+		g_object_unref (file);
+
+		if (data->children)
+			return BRASERO_ASYNC_TASK_RESCHEDULE;
+
+		return BRASERO_ASYNC_TASK_FINISHED;
+	}
+
+#endif
+
 	enumerator = g_file_enumerate_children (file,
 						attributes,
 						(data->job.options & BRASERO_IO_INFO_FOLLOW_SYMLINK)?G_FILE_QUERY_INFO_NONE:G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS,	/* follow symlinks by default*/
@@ -2052,91 +2588,18 @@ brasero_io_load_directory_thread (BraseroAsyncTaskManager *manager,
 			continue;
 
 		child_uri = g_file_get_uri (child);
+		if (brasero_io_load_directory_entry (BRASERO_IO (manager),
+						     cancel,
+						     data,
+						     file,
+						     child_uri,
+						     info,
+						     attributes))
+			data->children = g_slist_prepend (data->children, child);
+		else
+			g_object_unref (child);
 
-		/* special case for symlinks */
-		if (g_file_info_get_is_symlink (info)) {
-			if (!brasero_io_check_symlink_target (file, info)) {
-				error = g_error_new (BRASERO_UTILS_ERROR,
-						     BRASERO_UTILS_ERROR_SYMLINK_LOOP,
-						     _("Recursive symbolic link"));
-
-				/* since we checked for the existence of the file
-				 * an error means a looping symbolic link */
-				brasero_io_return_result (data->job.base,
-							  child_uri,
-							  NULL,
-							  error,
-							  data->job.callback_data);
-
-				g_free (child_uri);
-				g_object_unref (info);
-				g_object_unref (child);
-				continue;
-			}
-		}
-
-		if (g_file_info_get_file_type (info) == G_FILE_TYPE_DIRECTORY) {
-			brasero_io_return_result (data->job.base,
-						  child_uri,
-						  info,
-						  NULL,
-						  data->job.callback_data);
-
-			if (data->job.options & BRASERO_IO_INFO_RECURSIVE)
-				data->children = g_slist_prepend (data->children, child);
-			else
-				g_object_unref (child);
-
-			g_free (child_uri);
-			continue;
-		}
-
-		if (data->job.options & BRASERO_IO_INFO_METADATA) {
-			BraseroMetadataInfo metadata = {NULL, };
-			gboolean result;
-
-			/* add metadata information to this file */
-			result = brasero_io_get_metadata_info (BRASERO_IO (manager),
-							       cancel,
-							       child_uri,
-							       info,
-							       ((data->job.options & BRASERO_IO_INFO_METADATA_MISSING_CODEC) ? BRASERO_METADATA_FLAG_MISSING : 0) |
-							       ((data->job.options & BRASERO_IO_INFO_METADATA_THUMBNAIL) ? BRASERO_METADATA_FLAG_THUMBNAIL : 0),
-							       &metadata);
-
-			if (result)
-				brasero_io_set_metadata_attributes (info, &metadata);
-
-#ifdef BUILD_PLAYLIST
-
-			else if (data->job.options & BRASERO_IO_INFO_RECURSIVE) {
-				const gchar *mime;
-
-				mime = g_file_info_get_content_type (info);
-				if (mime
-				&& (!strcmp (mime, "audio/x-scpls")
-				||  !strcmp (mime, "audio/x-ms-asx")
-				||  !strcmp (mime, "audio/x-mp3-playlist")
-				||  !strcmp (mime, "audio/x-mpegurl")))
-					brasero_io_load_directory_playlist (BRASERO_IO (manager),
-									    cancel,
-									    data,
-									    child_uri,
-									    attributes);
-			}
-
-#endif
-
-			brasero_metadata_info_clear (&metadata);
-		}
-
-		brasero_io_return_result (data->job.base,
-					  child_uri,
-					  info,
-					  NULL,
-					  data->job.callback_data);
 		g_free (child_uri);
-		g_object_unref (child);
 	}
 
 	g_file_enumerator_close (enumerator, NULL, NULL);
@@ -2364,26 +2827,91 @@ static int
 	return 0;
 }
 
+static guint
+brasero_io_get_default_max_metadata (void)
+{
+	glong num_cpus;
+
+	num_cpus = sysconf (_SC_NPROCESSORS_ONLN);
+	return CLAMP (num_cpus, MIN_CONCURENT_META, MAX_CONCURENT_META);
+}
+
+/* NOTE: must be called from the main thread with lock_metadata held */
+static void
+brasero_io_add_metadatas (BraseroIO *self)
+{
+	BraseroIOPrivate *priv;
+	guint num;
+
+	priv = BRASERO_IO_PRIVATE (self);
+
+	num = g_slist_length (priv->metadatas) + g_slist_length (priv->metadata_running);
+	for (; num < priv->max_metadata; num ++) {
+		BraseroMetadata *metadata;
+
+		metadata = brasero_metadata_new ();
+		brasero_metadata_set_get_xid_callback (metadata, brasero_io_xid_for_metadata, self);
+		priv->metadatas = g_slist_prepend (priv->metadatas, metadata);
+	}
+}
+
+static void
+brasero_io_set_max_metadata_real (BraseroIO *self,
+				  guint max_metadata)
+{
+	BraseroIOPrivate *priv;
+
+	priv = BRASERO_IO_PRIVATE (self);
+
+	g_mutex_lock (priv->lock_metadata);
+
+	if (max_metadata)
+		priv->max_metadata = max_metadata;
+	else
+		priv->max_metadata = brasero_io_get_default_max_metadata ();
+
+	/* Extra metadatas are simply not used when lowering */
+	brasero_io_add_metadatas (self);
+	g_cond_broadcast (priv->metadata_available);
+
+	g_mutex_unlock (priv->lock_metadata);
+}
+
+static void
+brasero_io_settings_changed (GSettings *settings,
+			     const gchar *key,
+			     BraseroIO *self)
+{
+	if (!g_strcmp0 (key, BRASERO_PROPS_IO_MAX_THREADS))
+		brasero_async_task_manager_set_max_threads (BRASERO_ASYNC_TASK_MANAGER (self),
+							    MAX (g_settings_get_int (settings, key), 0));
+	else if (!g_strcmp0 (key, BRASERO_PROPS_IO_MAX_METADATA))
+		brasero_io_set_max_metadata_real (self, MAX (g_settings_get_int (settings, key), 0));
+}
+
 static void
 brasero_io_init (BraseroIO *object)
 {
 	BraseroIOPrivate *priv;
-	BraseroMetadata *metadata;
 	priv = BRASERO_IO_PRIVATE (object);
 
 	priv->lock = g_mutex_new ();
 	priv->lock_metadata = g_mutex_new ();
+	priv->metadata_available = g_cond_new ();
+
+	priv->settings = g_settings_new (BRASERO_SCHEMA_CONFIG);
+	g_signal_connect (priv->settings,
+			  "changed",
+			  G_CALLBACK (brasero_io_settings_changed),
+			  object);
 
-	priv->meta_buffer = g_queue_new ();
+	brasero_async_task_manager_set_max_threads (BRASERO_ASYNC_TASK_MANAGER (object),
+						    MAX (g_settings_get_int (priv->settings, BRASERO_PROPS_IO_MAX_THREADS), 0));
 
 	/* create metadatas now since it doesn't work well when it's created in 
-	 * a thread. */
-	metadata = brasero_metadata_new ();
-	priv->metadatas = g_slist_prepend (priv->metadatas, metadata);
-	brasero_metadata_set_get_xid_callback (metadata, brasero_io_xid_for_metadata, object);
-	metadata = brasero_metadata_new ();
-	priv->metadatas = g_slist_prepend (priv->metadatas, metadata);
-	brasero_metadata_set_get_xid_callback (metadata, brasero_io_xid_for_metadata, object);
+	 * a thread. Their pipelines are re-used from one URI to the next. */
+	brasero_io_set_max_metadata_real (object,
+					  MAX (g_settings_get_int (priv->settings, BRASERO_PROPS_IO_MAX_METADATA), 0));
 }
 
 static gboolean
@@ -2413,20 +2941,15 @@ brasero_io_finalize (GObject *object)
 							  brasero_io_free_async_queue,
 							  NULL);
 
+	if (priv->settings) {
+		g_object_unref (priv->settings);
+		priv->settings = NULL;
+	}
+
 	g_slist_foreach (priv->metadatas, (GFunc) g_object_unref, NULL);
 	g_slist_free (priv->metadatas);
 	priv->metadatas = NULL;
 
-	if (priv->meta_buffer) {
-		BraseroIOMetadataCached *cached;
-
-		while ((cached = g_queue_pop_head (priv->meta_buffer)) != NULL)
-			brasero_io_metadata_cached_free (cached);
-
-		g_queue_free (priv->meta_buffer);
-		priv->meta_buffer = NULL;
-	}
-
 	if (priv->results_id) {
 		g_source_remove (priv->results_id);
 		priv->results_id = 0;
@@ -2462,6 +2985,11 @@ brasero_io_finalize (GObject *object)
 		priv->lock_metadata = NULL;
 	}
 
+	if (priv->metadata_available) {
+		g_cond_free (priv->metadata_available);
+		priv->metadata_available = NULL;
+	}
+
 	if (priv->mounted) {
 		GSList *iter;
 
@@ -2519,6 +3047,8 @@ brasero_io_shutdown (void)
 							  brasero_io_cancel,
 							  NULL);
 
+	brasero_metadata_cache_save ();
+
 	/* do it afterwards in case some results slipped through */
 	for (iter = priv->results; iter; iter = next) {
 		BraseroIOJobResult *result;
@@ -2534,6 +3064,22 @@ brasero_io_shutdown (void)
 	}
 }
 
+/**
+ * Sets the maximum number of metadata retrievals (GStreamer pipelines) that
+ * can run at the same time. 0 restores the default which depends on the number
+ * of processors. It must be called from the main thread.
+ */
+
+void
+brasero_io_set_max_metadata (guint max_metadata)
+{
+	BraseroIO *self;
+
+	self = brasero_io_get_default ();
+	brasero_io_set_max_metadata_real (self, max_metadata);
+	g_object_unref (self);
+}
+
 void
 brasero_io_set_parent_window_callback (BraseroIOGetParentWinCb callback,
                                        gpointer user_data)
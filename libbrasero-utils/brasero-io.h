@@ -176,6 +176,9 @@ void
 brasero_io_set_parent_window_callback (BraseroIOGetParentWinCb callback,
                                        gpointer user_data);
 
+void
+brasero_io_set_max_metadata (guint max_metadata);
+
 void
 brasero_io_shutdown (void);
 
@@ -221,6 +224,9 @@ brasero_io_get_file_info (const gchar *uri,
 			  const BraseroIOJobBase *base,
 			  BraseroIOFlags options,
 			  gpointer callback_data);
+GFileInfo *
+brasero_io_get_file_info_cached (const gchar *uri,
+				 BraseroIOFlags options);
 void
 brasero_io_get_file_count (GSList *uris,
 			   const BraseroIOJobBase *base,
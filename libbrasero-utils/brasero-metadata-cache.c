@@ -0,0 +1,662 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 8; tab-width: 8 -*- */
+/*
+ * Libbrasero-misc
+ * Copyright (C) Philippe Rouquier 2005-2009 <bonfire-app@wanadoo.fr>
+ *
+ * Libbrasero-misc is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * The Libbrasero-misc authors hereby grant permission for non-GPL compatible
+ * GStreamer plugins to be used and distributed together with GStreamer
+ * and Libbrasero-misc. This permission is above and beyond the permissions granted
+ * by the GPL license by which Libbrasero-burn is covered. If you modify this code
+ * you may extend this exception to your version of the code, but you are not
+ * obligated to do so. If you do not wish to do so, delete this exception
+ * statement from your version.
+ * 
+ * Libbrasero-misc is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to:
+ * 	The Free Software Foundation, Inc.,
+ * 	51 Franklin Street, Fifth Floor
+ * 	Boston, MA  02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <string.h>
+
+#include <glib.h>
+#include <glib/gstdio.h>
+#include <gio/gio.h>
+
+#include <gdk-pixbuf/gdk-pixbuf.h>
+
+#include "brasero-misc.h"
+#include "brasero-metadata.h"
+#include "brasero-metadata-cache.h"
+
+/**
+ * Keeps the results of metadata retrieval (which means running a GStreamer
+ * pipeline) in memory and on disk between sessions. A result is valid as long
+ * as the size and the modification time of the file did not change.
+ *
+ * The on disk format is a flat sequence of records in host byte order that
+ * is read in one pass from a mapped file.
+ */
+
+#define BRASERO_METADATA_CACHE_MAGIC		"BRMC"
+#define BRASERO_METADATA_CACHE_VERSION		1
+
+/* The least recently used results are dropped above that number */
+#define BRASERO_METADATA_CACHE_MAX_ENTRIES	10000
+
+/* Flags that change the contents of a result */
+#define BRASERO_METADATA_CACHE_FLAGS		(BRASERO_METADATA_FLAG_SILENCES|	\
+						 BRASERO_METADATA_FLAG_MISSING|		\
+						 BRASERO_METADATA_FLAG_THUMBNAIL)
+
+struct _BraseroMetadataCacheEntry {
+	guint64 mtime;
+	guint64 size;
+	BraseroMetadataFlag flags;
+
+	BraseroMetadataInfo *info;
+
+	/* Snapshots loaded from disk are kept as PNG until needed */
+	gchar *snapshot_data;
+	gsize snapshot_len;
+
+	GList *link;
+};
+typedef struct _BraseroMetadataCacheEntry BraseroMetadataCacheEntry;
+
+struct _BraseroMetadataCacheReader {
+	const gchar *ptr;
+	const gchar *end;
+};
+typedef struct _BraseroMetadataCacheReader BraseroMetadataCacheReader;
+
+G_LOCK_DEFINE_STATIC (cache_lock);
+
+/* uri (owned by entry->info) -> entry */
+static GHashTable *cache = NULL;
+
+/* most recently used first */
+static GQueue cache_lru = G_QUEUE_INIT;
+
+static gboolean cache_dirty = FALSE;
+static guint cache_hits = 0;
+static guint cache_misses = 0;
+
+static void
+brasero_metadata_cache_entry_free (BraseroMetadataCacheEntry *entry)
+{
+	brasero_metadata_info_free (entry->info);
+	g_free (entry->snapshot_data);
+	g_free (entry);
+}
+
+static void
+brasero_metadata_cache_remove (BraseroMetadataCacheEntry *entry)
+{
+	g_hash_table_remove (cache, entry->info->uri);
+	g_queue_delete_link (&cache_lru, entry->link);
+	brasero_metadata_cache_entry_free (entry);
+}
+
+static void
+brasero_metadata_cache_insert (BraseroMetadataCacheEntry *entry)
+{
+	BraseroMetadataCacheEntry *old;
+
+	old = g_hash_table_lookup (cache, entry->info->uri);
+	if (old)
+		brasero_metadata_cache_remove (old);
+
+	g_hash_table_insert (cache, entry->info->uri, entry);
+	g_queue_push_head (&cache_lru, entry);
+	entry->link = cache_lru.head;
+
+	while (cache_lru.length > BRASERO_METADATA_CACHE_MAX_ENTRIES)
+		brasero_metadata_cache_remove (g_queue_peek_tail (&cache_lru));
+}
+
+static gchar *
+brasero_metadata_cache_get_path (void)
+{
+	return g_build_filename (g_get_user_cache_dir (),
+				 "brasero",
+				 "metadata.cache",
+				 NULL);
+}
+
+static gboolean
+brasero_metadata_cache_read (BraseroMetadataCacheReader *reader,
+			     gpointer buffer,
+			     gsize len)
+{
+	if (reader->end - reader->ptr < len)
+		return FALSE;
+
+	memcpy (buffer, reader->ptr, len);
+	reader->ptr += len;
+	return TRUE;
+}
+
+static gboolean
+brasero_metadata_cache_read_data (BraseroMetadataCacheReader *reader,
+				  gchar **data,
+				  gsize *data_len)
+{
+	guint32 len;
+
+	if (!brasero_metadata_cache_read (reader, &len, sizeof (len)))
+		return FALSE;
+
+	/* 0 means NULL, otherwise that's the length + 1 */
+	if (!len) {
+		*data = NULL;
+		if (data_len)
+			*data_len = 0;
+		return TRUE;
+	}
+
+	len --;
+	if (reader->end - reader->ptr < len)
+		return FALSE;
+
+	/* Data may be binary (snapshots) so copy all of it. It is still NUL
+	 * terminated for the strings. */
+	*data = g_malloc (len + 1);
+	memcpy (*data, reader->ptr, len);
+	(*data) [len] = '\0';
+
+	if (data_len)
+		*data_len = len;
+
+	reader->ptr += len;
+	return TRUE;
+}
+
+static BraseroMetadataCacheEntry *
+brasero_metadata_cache_read_entry (BraseroMetadataCacheReader *reader)
+{
+	BraseroMetadataCacheEntry *entry;
+	BraseroMetadataInfo *info;
+	guint32 num_silences;
+	guint32 flags;
+	guint32 bits;
+	gint32 channels;
+	gint32 rate;
+	guint i;
+
+	entry = g_new0 (BraseroMetadataCacheEntry, 1);
+	entry->info = g_new0 (BraseroMetadataInfo, 1);
+	info = entry->info;
+
+	if (!brasero_metadata_cache_read (reader, &entry->mtime, sizeof (entry->mtime))
+	||  !brasero_metadata_cache_read (reader, &entry->size, sizeof (entry->size))
+	||  !brasero_metadata_cache_read (reader, &flags, sizeof (flags))
+	||  !brasero_metadata_cache_read (reader, &bits, sizeof (bits))
+	||  !brasero_metadata_cache_read (reader, &info->len, sizeof (info->len))
+	||  !brasero_metadata_cache_read (reader, &channels, sizeof (channels))
+	||  !brasero_metadata_cache_read (reader, &rate, sizeof (rate))
+	||  !brasero_metadata_cache_read_data (reader, &info->uri, NULL)
+	||  !brasero_metadata_cache_read_data (reader, &info->type, NULL)
+	||  !brasero_metadata_cache_read_data (reader, &info->title, NULL)
+	||  !brasero_metadata_cache_read_data (reader, &info->artist, NULL)
+	||  !brasero_metadata_cache_read_data (reader, &info->album, NULL)
+	||  !brasero_metadata_cache_read_data (reader, &info->genre, NULL)
+	||  !brasero_metadata_cache_read_data (reader, &info->composer, NULL)
+	||  !brasero_metadata_cache_read_data (reader, &info->musicbrainz_id, NULL)
+	||  !brasero_metadata_cache_read_data (reader, &info->isrc, NULL)
+	||  !brasero_metadata_cache_read (reader, &num_silences, sizeof (num_silences)))
+		goto error;
+
+	entry->flags = flags;
+	info->channels = channels;
+	info->rate = rate;
+	info->is_seekable = (bits & 1) != 0;
+	info->has_audio = (bits & 2) != 0;
+	info->has_video = (bits & 4) != 0;
+	info->has_dts = (bits & 8) != 0;
+
+	for (i = 0; i < num_silences; i ++) {
+		BraseroMetadataSilence *silence;
+
+		silence = g_new0 (BraseroMetadataSilence, 1);
+		info->silences = g_slist_prepend (info->silences, silence);
+
+		if (!brasero_metadata_cache_read (reader, &silence->start, sizeof (silence->start))
+		||  !brasero_metadata_cache_read (reader, &silence->end, sizeof (silence->end)))
+			goto error;
+	}
+	info->silences = g_slist_reverse (info->silences);
+
+	if (!brasero_metadata_cache_read_data (reader, &entry->snapshot_data, &entry->snapshot_len))
+		goto error;
+
+	if (!info->uri)
+		goto error;
+
+	return entry;
+
+error:
+
+	brasero_metadata_cache_entry_free (entry);
+	return NULL;
+}
+
+static void
+brasero_metadata_cache_load (void)
+{
+	BraseroMetadataCacheReader reader;
+	GMappedFile *file;
+	guint32 version;
+	gchar *path;
+	guint num = 0;
+
+	cache = g_hash_table_new (g_str_hash, g_str_equal);
+
+	path = brasero_metadata_cache_get_path ();
+	file = g_mapped_file_new (path, FALSE, NULL);
+	g_free (path);
+
+	if (!file)
+		return;
+
+	reader.ptr = g_mapped_file_get_contents (file);
+	reader.end = reader.ptr + g_mapped_file_get_length (file);
+
+	if (reader.end - reader.ptr < 4
+	||  memcmp (reader.ptr, BRASERO_METADATA_CACHE_MAGIC, 4)) {
+		g_mapped_file_unref (file);
+		return;
+	}
+	reader.ptr += 4;
+
+	if (!brasero_metadata_cache_read (&reader, &version, sizeof (version))
+	||  version != BRASERO_METADATA_CACHE_VERSION) {
+		g_mapped_file_unref (file);
+		return;
+	}
+
+	/* Entries were saved most recently used first */
+	while (reader.ptr < reader.end) {
+		BraseroMetadataCacheEntry *entry;
+
+		entry = brasero_metadata_cache_read_entry (&reader);
+		if (!entry) {
+			BRASERO_UTILS_LOG ("Corrupted metadata cache");
+			break;
+		}
+
+		g_hash_table_insert (cache, entry->info->uri, entry);
+		g_queue_push_tail (&cache_lru, entry);
+		entry->link = cache_lru.tail;
+		num ++;
+	}
+
+	g_mapped_file_unref (file);
+	BRASERO_UTILS_LOG ("%i entries loaded from metadata cache", num);
+}
+
+static void
+brasero_metadata_cache_write (GByteArray *array,
+			      gconstpointer data,
+			      gsize len)
+{
+	g_byte_array_append (array, data, len);
+}
+
+static void
+brasero_metadata_cache_write_data (GByteArray *array,
+				   const gchar *data,
+				   gssize len)
+{
+	guint32 size;
+
+	if (!data) {
+		size = 0;
+		brasero_metadata_cache_write (array, &size, sizeof (size));
+		return;
+	}
+
+	if (len < 0)
+		len = strlen (data);
+
+	size = len + 1;
+	brasero_metadata_cache_write (array, &size, sizeof (size));
+	brasero_metadata_cache_write (array, data, len);
+}
+
+static void
+brasero_metadata_cache_write_entry (GByteArray *array,
+				    BraseroMetadataCacheEntry *entry)
+{
+	BraseroMetadataInfo *info;
+	guint32 num_silences;
+	guint32 flags;
+	guint32 bits;
+	gint32 channels;
+	gint32 rate;
+	GSList *iter;
+
+	info = entry->info;
+
+	flags = entry->flags;
+	bits = (info->is_seekable? 1:0)|
+	       (info->has_audio? 2:0)|
+	       (info->has_video? 4:0)|
+	       (info->has_dts? 8:0);
+	channels = info->channels;
+	rate = info->rate;
+
+	brasero_metadata_cache_write (array, &entry->mtime, sizeof (entry->mtime));
+	brasero_metadata_cache_write (array, &entry->size, sizeof (entry->size));
+	brasero_metadata_cache_write (array, &flags, sizeof (flags));
+	brasero_metadata_cache_write (array, &bits, sizeof (bits));
+	brasero_metadata_cache_write (array, &info->len, sizeof (info->len));
+	brasero_metadata_cache_write (array, &channels, sizeof (channels));
+	brasero_metadata_cache_write (array, &rate, sizeof (rate));
+	brasero_metadata_cache_write_data (array, info->uri, -1);
+	brasero_metadata_cache_write_data (array, info->type, -1);
+	brasero_metadata_cache_write_data (array, info->title, -1);
+	brasero_metadata_cache_write_data (array, info->artist, -1);
+	brasero_metadata_cache_write_data (array, info->album, -1);
+	brasero_metadata_cache_write_data (array, info->genre, -1);
+	brasero_metadata_cache_write_data (array, info->composer, -1);
+	brasero_metadata_cache_write_data (array, info->musicbrainz_id, -1);
+	brasero_metadata_cache_write_data (array, info->isrc, -1);
+
+	num_silences = g_slist_length (info->silences);
+	brasero_metadata_cache_write (array, &num_silences, sizeof (num_silences));
+	for (iter = info->silences; iter; iter = iter->next) {
+		BraseroMetadataSilence *silence;
+
+		silence = iter->data;
+		brasero_metadata_cache_write (array, &silence->start, sizeof (silence->start));
+		brasero_metadata_cache_write (array, &silence->end, sizeof (silence->end));
+	}
+
+	if (!entry->snapshot_data && info->snapshot) {
+		if (!gdk_pixbuf_save_to_buffer (info->snapshot,
+						&entry->snapshot_data,
+						&entry->snapshot_len,
+						"png",
+						NULL,
+						NULL)) {
+			entry->snapshot_data = NULL;
+			entry->snapshot_len = 0;
+		}
+	}
+
+	brasero_metadata_cache_write_data (array, entry->snapshot_data, entry->snapshot_len);
+}
+
+static GdkPixbuf *
+brasero_metadata_cache_load_snapshot (BraseroMetadataCacheEntry *entry)
+{
+	GdkPixbufLoader *loader;
+	GdkPixbuf *pixbuf = NULL;
+
+	loader = gdk_pixbuf_loader_new ();
+	if (gdk_pixbuf_loader_write (loader, (guchar *) entry->snapshot_data, entry->snapshot_len, NULL)
+	&&  gdk_pixbuf_loader_close (loader, NULL)) {
+		pixbuf = gdk_pixbuf_loader_get_pixbuf (loader);
+		if (pixbuf)
+			g_object_ref (pixbuf);
+	}
+	else
+		gdk_pixbuf_loader_close (loader, NULL);
+
+	g_object_unref (loader);
+	return pixbuf;
+}
+
+static gboolean
+brasero_metadata_cache_get_file_info (GFileInfo *file_info,
+				      guint64 *mtime,
+				      guint64 *size)
+{
+	/* Without these there is no way to tell whether a result is outdated */
+	if (!g_file_info_has_attribute (file_info, G_FILE_ATTRIBUTE_TIME_MODIFIED)
+	||  !g_file_info_has_attribute (file_info, G_FILE_ATTRIBUTE_STANDARD_SIZE))
+		return FALSE;
+
+	*mtime = g_file_info_get_attribute_uint64 (file_info, G_FILE_ATTRIBUTE_TIME_MODIFIED);
+	*size = g_file_info_get_attribute_uint64 (file_info, G_FILE_ATTRIBUTE_STANDARD_SIZE);
+	return TRUE;
+}
+
+/**
+ * Returns TRUE if a valid result with (at least) flags was found for uri. In
+ * this case info is filled.
+ */
+
+gboolean
+brasero_metadata_cache_lookup (const gchar *uri,
+			       GFileInfo *file_info,
+			       BraseroMetadataFlag flags,
+			       BraseroMetadataInfo *info)
+{
+	BraseroMetadataCacheEntry *entry;
+	guint64 mtime, size;
+
+	g_return_val_if_fail (uri != NULL, FALSE);
+	g_return_val_if_fail (file_info != NULL, FALSE);
+
+	if (!brasero_metadata_cache_get_file_info (file_info, &mtime, &size))
+		return FALSE;
+
+	G_LOCK (cache_lock);
+
+	if (!cache)
+		brasero_metadata_cache_load ();
+
+	entry = g_hash_table_lookup (cache, uri);
+	if (!entry)
+		goto miss;
+
+	if (entry->mtime != mtime || entry->size != size) {
+		BRASERO_UTILS_LOG ("Outdated cache information for %s", uri);
+		brasero_metadata_cache_remove (entry);
+		cache_dirty = TRUE;
+		goto miss;
+	}
+
+	/* This cached result may indicate an error and this error could be
+	 * related to the fact that it was not first looked for with missing
+	 * codec detection. The same for silences and snapshots. */
+	if ((flags & BRASERO_METADATA_CACHE_FLAGS) & ~entry->flags)
+		goto miss;
+
+	if (entry->snapshot_data && !entry->info->snapshot)
+		entry->info->snapshot = brasero_metadata_cache_load_snapshot (entry);
+
+	/* If there isn't any snapshot retry */
+	if ((flags & BRASERO_METADATA_FLAG_THUMBNAIL)
+	&&   entry->info->has_video
+	&&  !entry->info->snapshot)
+		goto miss;
+
+	/* move it first */
+	g_queue_unlink (&cache_lru, entry->link);
+	g_queue_push_head_link (&cache_lru, entry->link);
+
+	brasero_metadata_info_copy (info, entry->info);
+	cache_hits ++;
+
+	G_UNLOCK (cache_lock);
+	return TRUE;
+
+miss:
+
+	cache_misses ++;
+	G_UNLOCK (cache_lock);
+	return FALSE;
+}
+
+static void
+brasero_metadata_cache_steal_string (gchar **dest,
+				     gchar **src)
+{
+	if (*dest)
+		return;
+
+	*dest = *src;
+	*src = NULL;
+}
+
+/**
+ * A result for the same version of a file that was retrieved with other flags
+ * (for example only silences in the split dialog) must not make the cache lose
+ * what it already knows (the snapshot, ...). So entry gets what it misses from
+ * old.
+ */
+
+static void
+brasero_metadata_cache_merge (BraseroMetadataCacheEntry *entry,
+			      BraseroMetadataCacheEntry *old)
+{
+	BraseroMetadataInfo *info;
+
+	info = entry->info;
+
+	if (!(entry->flags & BRASERO_METADATA_FLAG_SILENCES)
+	&&   (old->flags & BRASERO_METADATA_FLAG_SILENCES)) {
+		g_slist_foreach (info->silences, (GFunc) g_free, NULL);
+		g_slist_free (info->silences);
+		info->silences = old->info->silences;
+		old->info->silences = NULL;
+	}
+
+	if (!info->snapshot && !entry->snapshot_data) {
+		info->snapshot = old->info->snapshot;
+		old->info->snapshot = NULL;
+
+		entry->snapshot_data = old->snapshot_data;
+		entry->snapshot_len = old->snapshot_len;
+		old->snapshot_data = NULL;
+		old->snapshot_len = 0;
+	}
+
+	brasero_metadata_cache_steal_string (&info->type, &old->info->type);
+	brasero_metadata_cache_steal_string (&info->title, &old->info->title);
+	brasero_metadata_cache_steal_string (&info->artist, &old->info->artist);
+	brasero_metadata_cache_steal_string (&info->album, &old->info->album);
+	brasero_metadata_cache_steal_string (&info->genre, &old->info->genre);
+	brasero_metadata_cache_steal_string (&info->composer, &old->info->composer);
+	brasero_metadata_cache_steal_string (&info->musicbrainz_id, &old->info->musicbrainz_id);
+	brasero_metadata_cache_steal_string (&info->isrc, &old->info->isrc);
+
+	entry->flags |= old->flags;
+}
+
+void
+brasero_metadata_cache_add (const gchar *uri,
+			    GFileInfo *file_info,
+			    BraseroMetadataFlag flags,
+			    BraseroMetadataInfo *info)
+{
+	BraseroMetadataCacheEntry *entry;
+	BraseroMetadataCacheEntry *old;
+
+	g_return_if_fail (uri != NULL);
+	g_return_if_fail (file_info != NULL);
+
+	/* Only results for audio/video files are interesting */
+	if (!info->has_audio && !info->has_video)
+		return;
+
+	entry = g_new0 (BraseroMetadataCacheEntry, 1);
+	if (!brasero_metadata_cache_get_file_info (file_info, &entry->mtime, &entry->size)) {
+		g_free (entry);
+		return;
+	}
+
+	entry->flags = flags & BRASERO_METADATA_CACHE_FLAGS;
+
+	entry->info = g_new0 (BraseroMetadataInfo, 1);
+	brasero_metadata_info_copy (entry->info, info);
+
+	/* The key must be the URI used for lookups */
+	g_free (entry->info->uri);
+	entry->info->uri = g_strdup (uri);
+
+	G_LOCK (cache_lock);
+
+	if (!cache)
+		brasero_metadata_cache_load ();
+
+	old = g_hash_table_lookup (cache, uri);
+	if (old && old->mtime == entry->mtime && old->size == entry->size)
+		brasero_metadata_cache_merge (entry, old);
+
+	brasero_metadata_cache_insert (entry);
+	cache_dirty = TRUE;
+
+	G_UNLOCK (cache_lock);
+}
+
+/**
+ * Writes the cache to disk if it changed since it was loaded.
+ */
+
+void
+brasero_metadata_cache_save (void)
+{
+	GError *error = NULL;
+	GByteArray *array;
+	guint32 version;
+	gchar *path;
+	gchar *dir;
+	GList *iter;
+
+	G_LOCK (cache_lock);
+
+	BRASERO_UTILS_LOG ("Metadata cache: %u hits, %u misses",
+			   cache_hits,
+			   cache_misses);
+
+	if (!cache || !cache_dirty) {
+		G_UNLOCK (cache_lock);
+		return;
+	}
+
+	BRASERO_UTILS_LOG ("Saving metadata cache (%i entries)", cache_lru.length);
+
+	array = g_byte_array_new ();
+	brasero_metadata_cache_write (array, BRASERO_METADATA_CACHE_MAGIC, 4);
+
+	version = BRASERO_METADATA_CACHE_VERSION;
+	brasero_metadata_cache_write (array, &version, sizeof (version));
+
+	for (iter = cache_lru.head; iter; iter = iter->next)
+		brasero_metadata_cache_write_entry (array, iter->data);
+
+	cache_dirty = FALSE;
+	G_UNLOCK (cache_lock);
+
+	path = brasero_metadata_cache_get_path ();
+	dir = g_path_get_dirname (path);
+	g_mkdir_with_parents (dir, 0700);
+	g_free (dir);
+
+	if (!g_file_set_contents (path, (gchar *) array->data, array->len, &error)) {
+		BRASERO_UTILS_LOG ("Metadata cache could not be saved: %s", error->message);
+		g_error_free (error);
+	}
+
+	g_free (path);
+	g_byte_array_free (array, TRUE);
+}
@@ -183,6 +183,9 @@ brasero_metadata_info_clear (BraseroMetadataInfo *info)
 	if (info->genre)
 		g_free (info->genre);
 
+	if (info->composer)
+		g_free (info->composer);
+
 	if (info->musicbrainz_id)
 		g_free (info->musicbrainz_id);
 
@@ -242,6 +245,9 @@ brasero_metadata_info_copy (BraseroMetadataInfo *dest,
 	if (src->genre)
 		dest->genre = g_strdup (src->genre);
 
+	if (src->composer)
+		dest->composer = g_strdup (src->composer);
+
 	if (src->musicbrainz_id)
 		dest->musicbrainz_id = g_strdup (src->musicbrainz_id);
 
@@ -266,7 +272,7 @@ brasero_metadata_info_copy (BraseroMetadataInfo *dest,
 	}
 }
 
-static void
+static gboolean
 brasero_metadata_stop_pipeline (GstElement *pipeline)
 {
 	GstState state;
@@ -292,15 +298,26 @@ brasero_metadata_stop_pipeline (GstElement *pipeline)
 				   state, pending, change);
 	}
 
-	if (change == GST_STATE_CHANGE_FAILURE)
+	if (change == GST_STATE_CHANGE_FAILURE) {
 		g_warning ("State change failure");
+		return FALSE;
+	}
 
+	return TRUE;
 }
 
-static void
-brasero_metadata_destroy_pipeline (BraseroMetadata *self)
+/**
+ * Brings the pipeline back to NULL state and removes the elements that are
+ * specific to a URI so that it can be used again for another one (the
+ * decodebin, converter and sink are kept). Returns FALSE if the pipeline
+ * could not be stopped.
+ */
+
+static gboolean
+brasero_metadata_reset_pipeline (BraseroMetadata *self)
 {
 	BraseroMetadataPrivate *priv;
+	gboolean result;
 
 	priv = BRASERO_METADATA_PRIVATE (self);
 
@@ -318,9 +335,14 @@ brasero_metadata_destroy_pipeline (BraseroMetadata *self)
 	}
 
 	if (!priv->pipeline)
-		return;
+		return TRUE;
 
-	brasero_metadata_stop_pipeline (priv->pipeline);
+	result = brasero_metadata_stop_pipeline (priv->pipeline);
+
+	if (priv->source) {
+		gst_bin_remove (GST_BIN (priv->pipeline), priv->source);
+		priv->source = NULL;
+	}
 
 	if (priv->audio) {
 		gst_bin_remove (GST_BIN (priv->pipeline), priv->audio);
@@ -333,6 +355,21 @@ brasero_metadata_destroy_pipeline (BraseroMetadata *self)
 		priv->video = NULL;
 	}
 
+	return result;
+}
+
+static void
+brasero_metadata_destroy_pipeline (BraseroMetadata *self)
+{
+	BraseroMetadataPrivate *priv;
+
+	priv = BRASERO_METADATA_PRIVATE (self);
+
+	brasero_metadata_reset_pipeline (self);
+
+	if (!priv->pipeline)
+		return;
+
 	gst_object_unref (GST_OBJECT (priv->pipeline));
 	priv->pipeline = NULL;
 
@@ -366,14 +403,18 @@ brasero_metadata_stop (BraseroMetadata *self)
 
 	g_mutex_lock (priv->mutex);
 
-	/* Destroy the pipeline as it has become un-re-usable */
 	if (priv->watch) {
 		g_source_remove (priv->watch);
 		priv->watch = 0;
 	}
 
-	if (priv->pipeline)
-		brasero_metadata_destroy_pipeline (self);
+	/* Keep the pipeline around to save the cost of building it again for
+	 * the next URI unless something went wrong in which case it may have
+	 * become un-re-usable. */
+	if (priv->pipeline) {
+		if (priv->error || !brasero_metadata_reset_pipeline (self))
+			brasero_metadata_destroy_pipeline (self);
+	}
 
 	/* That's automatic missing plugin installation */
 	if (priv->missing_plugins) {
@@ -1356,8 +1397,7 @@ brasero_metadata_create_audio_pipeline (BraseroMetadata *self)
 
 		/* Add a reference to these objects as we want to keep them
 		 * around after the bin they've been added to is destroyed
-		 * NOTE: now we destroy the pipeline every time which means
-		 * that it doesn't really matter. */
+		 * since the pipeline is re-used for the next URI. */
 		if (!priv->level) {
 			priv->level = gst_element_factory_make ("level", NULL);
 			if (!priv->level) {
@@ -1794,24 +1834,8 @@ brasero_metadata_set_new_uri (BraseroMetadata *self,
 	priv->info = g_new0 (BraseroMetadataInfo, 1);
 	priv->info->uri = g_strdup (uri);
 
-	if (priv->pipeline){
-		gst_element_set_state (priv->pipeline, GST_STATE_NULL);
-		if (priv->source) {
-			gst_bin_remove (GST_BIN (priv->pipeline), priv->source);
-			priv->source = NULL;
-		}
-
-		if (priv->audio) {
-			gst_bin_remove (GST_BIN (priv->pipeline), priv->audio);
-			priv->audio = NULL;
-		}
-
-		if (priv->video) {
-			gst_bin_remove (GST_BIN (priv->pipeline), priv->video);
-			priv->snapshot = NULL;
-			priv->video = NULL;
-		}
-	}
+	if (priv->pipeline)
+		brasero_metadata_reset_pipeline (self);
 	else if (!brasero_metadata_create_pipeline (self))
 		return FALSE;
 
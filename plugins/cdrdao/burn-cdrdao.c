@@ -47,6 +47,7 @@
 #include "brasero-plugin-registration.h"
 #include "burn-job.h"
 #include "burn-process.h"
+#include "burn-line-matcher.h"
 #include "brasero-track-disc.h"
 #include "brasero-track-image.h"
 #include "brasero-drive.h"
@@ -65,6 +66,7 @@ BRASERO_PLUGIN_BOILERPLATE (BraseroCdrdao, brasero_cdrdao, BRASERO_TYPE_PROCESS,
 
 struct _BraseroCdrdaoPrivate {
  	gchar *tmp_toc_path;
+	BraseroLineMatcher *stderr_matcher;
 	guint use_raw:1;
 };
 typedef struct _BraseroCdrdaoPrivate BraseroCdrdaoPrivate;
@@ -75,8 +77,35 @@ static GObjectClass *parent_class = NULL;
 #define BRASERO_SCHEMA_CONFIG		"org.gnome.brasero.config"
 #define BRASERO_KEY_RAW_FLAG		"raw-flag"
 
+/* Lines we react to; the first pattern found in a line wins. Progress
+ * lines are only made of numbers so they are still parsed with sscanf. */
+enum {
+	BRASERO_CDRDAO_LINE_COPYING_AUDIO,
+	BRASERO_CDRDAO_LINE_COPYING_DATA,
+	BRASERO_CDRDAO_LINE_WRITING_TRACK,
+	BRASERO_CDRDAO_LINE_FINISHED,
+	BRASERO_CDRDAO_LINE_BLANKING,
+	BRASERO_CDRDAO_LINE_NO_INPUT,
+	BRASERO_CDRDAO_LINE_BUSY,
+	BRASERO_CDRDAO_LINE_PERMISSION
+};
+
+static const BraseroLinePattern stderr_patterns [] = {
+	{ "Copying audio tracks",				BRASERO_LINE_MATCH_CONTAINS,	BRASERO_CDRDAO_LINE_COPYING_AUDIO },
+	{ "Copying data track",					BRASERO_LINE_MATCH_CONTAINS,	BRASERO_CDRDAO_LINE_COPYING_DATA },
+	{ "Writing track",					BRASERO_LINE_MATCH_CONTAINS,	BRASERO_CDRDAO_LINE_WRITING_TRACK },
+	{ "Writing finished successfully",			BRASERO_LINE_MATCH_CONTAINS,	BRASERO_CDRDAO_LINE_FINISHED },
+	{ "On-the-fly CD copying finished successfully",	BRASERO_LINE_MATCH_CONTAINS,	BRASERO_CDRDAO_LINE_FINISHED },
+	{ "Blanking disk...",					BRASERO_LINE_MATCH_CONTAINS,	BRASERO_CDRDAO_LINE_BLANKING },
+	{ "ERROR: Could not find input file",			BRASERO_LINE_MATCH_CONTAINS,	BRASERO_CDRDAO_LINE_NO_INPUT },
+	{ "Cannot setup device",				BRASERO_LINE_MATCH_CONTAINS,	BRASERO_CDRDAO_LINE_BUSY },
+	{ "Operation not permitted. Cannot send SCSI",		BRASERO_LINE_MATCH_CONTAINS,	BRASERO_CDRDAO_LINE_PERMISSION },
+};
+
 static gboolean
-brasero_cdrdao_read_stderr_image (BraseroCdrdao *cdrdao, const gchar *line)
+brasero_cdrdao_read_stderr_image (BraseroCdrdao *cdrdao,
+				  const gchar *line,
+				  gint match)
 {
 	int min, sec, sub, s1;
 
@@ -97,13 +126,13 @@ brasero_cdrdao_read_stderr_image (BraseroCdrdao *cdrdao, const gchar *line)
 			brasero_job_finished_session (BRASERO_JOB (cdrdao));
 		}
 	}
-	else if (strstr (line, "Copying audio tracks")) {
+	else if (match == BRASERO_CDRDAO_LINE_COPYING_AUDIO) {
 		brasero_job_set_current_action (BRASERO_JOB (cdrdao),
 						BRASERO_BURN_ACTION_DRIVE_COPY,
 						_("Copying audio track"),
 						FALSE);
 	}
-	else if (strstr (line, "Copying data track")) {
+	else if (match == BRASERO_CDRDAO_LINE_COPYING_DATA) {
 		brasero_job_set_current_action (BRASERO_JOB (cdrdao),
 						BRASERO_BURN_ACTION_DRIVE_COPY,
 						_("Copying data track"),
@@ -116,7 +145,9 @@ brasero_cdrdao_read_stderr_image (BraseroCdrdao *cdrdao, const gchar *line)
 }
 
 static gboolean
-brasero_cdrdao_read_stderr_record (BraseroCdrdao *cdrdao, const gchar *line)
+brasero_cdrdao_read_stderr_record (BraseroCdrdao *cdrdao,
+				   const gchar *line,
+				   gint match)
 {
 	int fifo, track, min, sec;
 	guint written, total;
@@ -159,14 +190,13 @@ brasero_cdrdao_read_stderr_record (BraseroCdrdao *cdrdao, const gchar *line)
 		written = secs * 75 * 2352;
 		brasero_job_set_written_session (BRASERO_JOB (cdrdao), written);
 	}
-	else if (strstr (line, "Writing track")) {
+	else if (match == BRASERO_CDRDAO_LINE_WRITING_TRACK) {
 		brasero_job_set_dangerous (BRASERO_JOB (cdrdao), TRUE);
 	}
-	else if (strstr (line, "Writing finished successfully")
-	     ||  strstr (line, "On-the-fly CD copying finished successfully")) {
+	else if (match == BRASERO_CDRDAO_LINE_FINISHED) {
 		brasero_job_set_dangerous (BRASERO_JOB (cdrdao), FALSE);
 	}
-	else if (strstr (line, "Blanking disk...")) {
+	else if (match == BRASERO_CDRDAO_LINE_BLANKING) {
 		brasero_job_set_current_action (BRASERO_JOB (cdrdao),
 						BRASERO_BURN_ACTION_BLANKING,
 						NULL,
@@ -196,7 +226,7 @@ brasero_cdrdao_read_stderr_record (BraseroCdrdao *cdrdao, const gchar *line)
 		if (!cuepath)
 			return FALSE;
 
-		if (!strstr (line, "ERROR: Could not find input file")) {
+		if (match != BRASERO_CDRDAO_LINE_NO_INPUT) {
 			g_free (cuepath);
 			return FALSE;
 		}
@@ -219,30 +249,35 @@ brasero_cdrdao_read_stderr_record (BraseroCdrdao *cdrdao, const gchar *line)
 static BraseroBurnResult
 brasero_cdrdao_read_stderr (BraseroProcess *process, const gchar *line)
 {
+	BraseroCdrdaoPrivate *priv;
 	BraseroCdrdao *cdrdao;
 	gboolean result = FALSE;
 	BraseroJobAction action;
+	gint match;
 
 	cdrdao = BRASERO_CDRDAO (process);
+	priv = BRASERO_CDRDAO_PRIVATE (cdrdao);
+
+	match = brasero_line_matcher_match (priv->stderr_matcher, line);
 
 	brasero_job_get_action (BRASERO_JOB (cdrdao), &action);
 	if (action == BRASERO_JOB_ACTION_RECORD
 	||  action == BRASERO_JOB_ACTION_ERASE)
-		result = brasero_cdrdao_read_stderr_record (cdrdao, line);
+		result = brasero_cdrdao_read_stderr_record (cdrdao, line, match);
 	else if (action == BRASERO_JOB_ACTION_IMAGE
 	     ||  action == BRASERO_JOB_ACTION_SIZE)
-		result = brasero_cdrdao_read_stderr_image (cdrdao, line);
+		result = brasero_cdrdao_read_stderr_image (cdrdao, line, match);
 
 	if (result)
 		return BRASERO_BURN_OK;
 
-	if (strstr (line, "Cannot setup device")) {
+	if (match == BRASERO_CDRDAO_LINE_BUSY) {
 		brasero_job_error (BRASERO_JOB (cdrdao),
 				   g_error_new (BRASERO_BURN_ERROR,
 						BRASERO_BURN_ERROR_DRIVE_BUSY,
 						_("The drive is busy")));
 	}
-	else if (strstr (line, "Operation not permitted. Cannot send SCSI")) {
+	else if (match == BRASERO_CDRDAO_LINE_PERMISSION) {
 		brasero_job_error (BRASERO_JOB (cdrdao),
 				   g_error_new (BRASERO_BURN_ERROR,
 						BRASERO_BURN_ERROR_PERMISSION,
@@ -657,6 +692,9 @@ brasero_cdrdao_init (BraseroCdrdao *obj)
 	settings = g_settings_new (BRASERO_SCHEMA_CONFIG);
 	priv->use_raw = g_settings_get_boolean (settings, BRASERO_KEY_RAW_FLAG);
 	g_object_unref (settings);
+
+	priv->stderr_matcher = brasero_line_matcher_new (stderr_patterns,
+							 G_N_ELEMENTS (stderr_patterns));
 }
 
 static void
@@ -670,6 +708,9 @@ brasero_cdrdao_finalize (GObject *object)
 		priv->tmp_toc_path = NULL;
 	}
 
+	brasero_line_matcher_free (priv->stderr_matcher);
+	priv->stderr_matcher = NULL;
+
 	G_OBJECT_CLASS (parent_class)->finalize (object);
 }
 
@@ -51,6 +51,7 @@
 
 #include "burn-job.h"
 #include "burn-process.h"
+#include "burn-line-matcher.h"
 #include "brasero-plugin-registration.h"
 #include "burn-cdrkit.h"
 
@@ -79,6 +80,9 @@ struct _BraseroWodimPrivate {
 
 	GSList *infs;
 
+	BraseroLineMatcher *stderr_matcher;
+	BraseroLineMatcher *stdout_matcher;
+
 	guint immediate:1;
 };
 typedef struct _BraseroWodimPrivate BraseroWodimPrivate;
@@ -90,66 +94,124 @@ static GObjectClass *parent_class = NULL;
 #define BRASERO_KEY_IMMEDIATE_FLAG      "immed-flag"
 #define BRASERO_KEY_MINBUF_VALUE	"minbuf-value"
 
+/* Lines we react to; in each table the first pattern found in a line wins */
+enum {
+	BRASERO_WODIM_LINE_PERMISSION,
+	BRASERO_WODIM_LINE_NO_SPACE,
+	BRASERO_WODIM_LINE_WRITE_ERROR,
+	BRASERO_WODIM_LINE_SLOW_DMA,
+	BRASERO_WODIM_LINE_BUSY,
+	BRASERO_WODIM_LINE_ILLEGAL_MODE,
+	BRASERO_WODIM_LINE_UHS_WRITER,
+
+	BRASERO_WODIM_LINE_TRACK,
+	BRASERO_WODIM_LINE_FORMATTING,
+	BRASERO_WODIM_LINE_CUE_SHEET,
+	BRASERO_WODIM_LINE_RELOAD,
+	BRASERO_WODIM_LINE_FIXATING,
+	BRASERO_WODIM_LINE_LAST_CHANCE,
+	BRASERO_WODIM_LINE_UHS_DISC
+};
+
+static const BraseroLinePattern stderr_patterns [] = {
+	{ "Cannot open SCSI driver.",				BRASERO_LINE_MATCH_CONTAINS,	BRASERO_WODIM_LINE_PERMISSION },
+	{ "Operation not permitted. Cannot send SCSI cmd via ioctl",	BRASERO_LINE_MATCH_CONTAINS,	BRASERO_WODIM_LINE_PERMISSION },
+	{ "Cannot open or use SCSI driver",			BRASERO_LINE_MATCH_CONTAINS,	BRASERO_WODIM_LINE_PERMISSION },
+	{ "Data may not fit on current disk",			BRASERO_LINE_MATCH_CONTAINS,	BRASERO_WODIM_LINE_NO_SPACE },
+	{ "cdrecord: A write error occurred",			BRASERO_LINE_MATCH_CONTAINS,	BRASERO_WODIM_LINE_WRITE_ERROR },
+	{ "Could not write Lead-in",				BRASERO_LINE_MATCH_CONTAINS,	BRASERO_WODIM_LINE_WRITE_ERROR },
+	{ "Cannot fixate disk",					BRASERO_LINE_MATCH_CONTAINS,	BRASERO_WODIM_LINE_WRITE_ERROR },
+	{ "DMA speed too slow",					BRASERO_LINE_MATCH_CONTAINS,	BRASERO_WODIM_LINE_SLOW_DMA },
+	{ "Device or resource busy",				BRASERO_LINE_MATCH_CONTAINS,	BRASERO_WODIM_LINE_BUSY },
+	{ "Illegal write mode for this drive",			BRASERO_LINE_MATCH_CONTAINS,	BRASERO_WODIM_LINE_ILLEGAL_MODE },
+	{ "Probably trying to use ultra high speed+ medium on improper writer",	BRASERO_LINE_MATCH_CONTAINS,	BRASERO_WODIM_LINE_UHS_WRITER },
+};
+
+static const BraseroLinePattern stdout_patterns [] = {
+	{ "Track ",						BRASERO_LINE_MATCH_PREFIX,	BRASERO_WODIM_LINE_TRACK },
+	{ "Formating in progress: ",				BRASERO_LINE_MATCH_PREFIX,	BRASERO_WODIM_LINE_FORMATTING },
+	{ "Sending CUE sheet",					BRASERO_LINE_MATCH_CONTAINS,	BRASERO_WODIM_LINE_CUE_SHEET },
+	{ "Re-load disk and hit <CR>",				BRASERO_LINE_MATCH_PREFIX,	BRASERO_WODIM_LINE_RELOAD },
+	{ "send SIGUSR1 to continue",				BRASERO_LINE_MATCH_PREFIX,	BRASERO_WODIM_LINE_RELOAD },
+	{ "Fixating...",					BRASERO_LINE_MATCH_PREFIX,	BRASERO_WODIM_LINE_FIXATING },
+	{ "Writing Leadout...",					BRASERO_LINE_MATCH_PREFIX,	BRASERO_WODIM_LINE_FIXATING },
+	{ "Last chance to quit, ",				BRASERO_LINE_MATCH_PREFIX,	BRASERO_WODIM_LINE_LAST_CHANCE },
+	{ "Disk sub type: Ultra High speed+",			BRASERO_LINE_MATCH_CONTAINS,	BRASERO_WODIM_LINE_UHS_DISC },
+};
+
 static BraseroBurnResult
 brasero_wodim_stderr_read (BraseroProcess *process, const gchar *line)
 {
 	BraseroBurnFlag flags;
+	BraseroWodimPrivate *priv;
 
+	priv = BRASERO_WODIM_PRIVATE (process);
 	brasero_job_get_flags (BRASERO_JOB (process), &flags);
 
-	if (strstr (line, "Cannot open SCSI driver.")
-	||  strstr (line, "Operation not permitted. Cannot send SCSI cmd via ioctl")
-	||  strstr (line, "Cannot open or use SCSI driver")) {
+	switch (brasero_line_matcher_match (priv->stderr_matcher, line)) {
+	case BRASERO_WODIM_LINE_PERMISSION:
 		brasero_job_error (BRASERO_JOB (process),
 				   g_error_new (BRASERO_BURN_ERROR,
 						BRASERO_BURN_ERROR_PERMISSION,
 						_("You do not have the required permissions to use this drive")));
-	}
-	else if (!(flags & BRASERO_BURN_FLAG_OVERBURN)
-	     &&  strstr (line, "Data may not fit on current disk")) {
+		break;
+
+	case BRASERO_WODIM_LINE_NO_SPACE:
 		/* we don't error out if overburn was chosen */
+		if (flags & BRASERO_BURN_FLAG_OVERBURN)
+			break;
+
 		brasero_job_error (BRASERO_JOB (process),
 				   g_error_new (BRASERO_BURN_ERROR,
 						BRASERO_BURN_ERROR_MEDIUM_SPACE,
 						_("Not enough space available on the disc")));
-	}
-	else if (strstr (line ,"cdrecord: A write error occurred")
-	     ||  strstr (line, "Could not write Lead-in")
-	     ||  strstr (line, "Cannot fixate disk")) {
+		break;
+
+	case BRASERO_WODIM_LINE_WRITE_ERROR:
 		brasero_job_error (BRASERO_JOB (process),
 				   g_error_new (BRASERO_BURN_ERROR,
 						BRASERO_BURN_ERROR_WRITE_MEDIUM,
 						_("An error occurred while writing to disc")));
-	}
-	else if (strstr (line, "DMA speed too slow") != NULL) {
+		break;
+
+	case BRASERO_WODIM_LINE_SLOW_DMA:
 		brasero_job_error (BRASERO_JOB (process),
 				   g_error_new (BRASERO_BURN_ERROR,
 						BRASERO_BURN_ERROR_SLOW_DMA,
 						_("The system is too slow to write the disc at this speed. Try a lower speed")));
-	}
-	else if (strstr (line, "Device or resource busy")) {
-		if (!strstr (line, "retrying in")) {
-			brasero_job_error (BRASERO_JOB (process),
-					   g_error_new (BRASERO_BURN_ERROR,
-							BRASERO_BURN_ERROR_DRIVE_BUSY,
-							_("The drive is busy")));
-		}
-	}
-	else if (strstr (line, "Illegal write mode for this drive")) {
+		break;
+
+	case BRASERO_WODIM_LINE_BUSY:
+		if (strstr (line, "retrying in"))
+			break;
+
+		brasero_job_error (BRASERO_JOB (process),
+				   g_error_new (BRASERO_BURN_ERROR,
+						BRASERO_BURN_ERROR_DRIVE_BUSY,
+						_("The drive is busy")));
+		break;
+
+	case BRASERO_WODIM_LINE_ILLEGAL_MODE:
 		/* NOTE : when it happened I had to unlock the
 		 * drive with cdrdao and eject it. Should we ? */
 		brasero_job_error (BRASERO_JOB (process),
 				   g_error_new (BRASERO_BURN_ERROR,
 						BRASERO_BURN_ERROR_DRIVE_BUSY,
 						_("The drive is busy")));
-	}
-	else if (strstr (line, "Probably trying to use ultra high speed+ medium on improper writer")) {
+		break;
+
+	case BRASERO_WODIM_LINE_UHS_WRITER:
 		/* Set a deferred error as this message tends to indicate a failure */
 		brasero_process_deferred_error (process,
 						g_error_new (BRASERO_BURN_ERROR,
 							     BRASERO_BURN_ERROR_MEDIUM_INVALID,
 							     _("The disc is not supported")));
+		break;
+
+	default:
+		break;
 	}
+
 	/* REMINDER: these should not be necessary as we checked that already */
 	/**
 	else if (strstr (line, "cannot write medium - incompatible format") != NULL) {
@@ -297,8 +359,8 @@ brasero_wodim_set_rate (BraseroProcess *process,
 	brasero_job_set_rate (BRASERO_JOB (process), current_rate);
 }
 
-static BraseroBurnResult
-brasero_wodim_stdout_read (BraseroProcess *process, const gchar *line)
+static void
+brasero_wodim_stdout_read_track (BraseroProcess *process, const gchar *line)
 {
 	guint track;
 	guint speed_1, speed_2;
@@ -346,7 +408,30 @@ brasero_wodim_stdout_read (BraseroProcess *process, const gchar *line)
 
 		brasero_job_start_progress (BRASERO_JOB (wodim), FALSE);
 	}
-	else if (sscanf (line, "Formating in progress: %d.%d %% done", &mb_written, &mb_total) == 2) {
+
+	/* else if (sscanf (line, "Track %*d: %*s %d MB ", &mb_total) == 1)
+	 * gives the size of each track; it is not used */
+}
+
+static BraseroBurnResult
+brasero_wodim_stdout_read (BraseroProcess *process, const gchar *line)
+{
+	BraseroWodimPrivate *priv;
+	int mb_written = 0, mb_total = 0;
+	BraseroWodim *wodim;
+
+	wodim = BRASERO_WODIM (process);
+	priv = BRASERO_WODIM_PRIVATE (wodim);
+
+	switch (brasero_line_matcher_match (priv->stdout_matcher, line)) {
+	case BRASERO_WODIM_LINE_TRACK:
+		brasero_wodim_stdout_read_track (process, line);
+		break;
+
+	case BRASERO_WODIM_LINE_FORMATTING:
+		if (sscanf (line, "Formating in progress: %d.%d %% done", &mb_written, &mb_total) != 2)
+			break;
+
 		brasero_job_set_current_action (BRASERO_JOB (process),
 						BRASERO_BURN_ACTION_BLANKING,
 						_("Formatting disc"),
@@ -355,12 +440,9 @@ brasero_wodim_stdout_read (BraseroProcess *process, const gchar *line)
 		brasero_job_start_progress (BRASERO_JOB (wodim), FALSE);
 		brasero_job_set_progress (BRASERO_JOB (wodim),
 					  (gdouble) ((gdouble) mb_written + ((gdouble) mb_total) / 10.0) / 100.0);
-	}
-	else if (sscanf (line, "Track %*d: %*s %d MB ", &mb_total) == 1) {
-/*		if (mb_total > 0)
-			priv->tracks_total_bytes += mb_total * 1048576;
-*/	}
-	else if (strstr (line, "Sending CUE sheet")) {
+		break;
+
+	case BRASERO_WODIM_LINE_CUE_SHEET: {
 		BraseroTrackType *type = NULL;
 
 		/* See if we are in an audio case which would mean we're writing
@@ -372,9 +454,10 @@ brasero_wodim_stdout_read (BraseroProcess *process, const gchar *line)
 						brasero_track_type_get_has_stream (type) ? NULL:_("Writing cue sheet"),
 						FALSE);
 		brasero_track_type_free (type);
+		break;
 	}
-	else if (g_str_has_prefix (line, "Re-load disk and hit <CR>")
-	     ||  g_str_has_prefix (line, "send SIGUSR1 to continue")) {
+
+	case BRASERO_WODIM_LINE_RELOAD: {
 		BraseroBurnAction action = BRASERO_BURN_ACTION_NONE;
 
 		brasero_job_get_current_action (BRASERO_JOB (process), &action);
@@ -392,9 +475,10 @@ brasero_wodim_stdout_read (BraseroProcess *process, const gchar *line)
 				   g_error_new (BRASERO_BURN_ERROR,
 						BRASERO_BURN_ERROR_MEDIUM_NEED_RELOADING,
 						_("The disc needs to be reloaded before being recorded")));
+		break;
 	}
-	else if (g_str_has_prefix (line, "Fixating...")
-	     ||  g_str_has_prefix (line, "Writing Leadout...")) {
+
+	case BRASERO_WODIM_LINE_FIXATING: {
 		BraseroJobAction action;
 
 		/* Do this to avoid strange things to appear when erasing */
@@ -404,24 +488,29 @@ brasero_wodim_stdout_read (BraseroProcess *process, const gchar *line)
 							BRASERO_BURN_ACTION_FIXATING,
 							NULL,
 							FALSE);
+		break;
 	}
-	else if (g_str_has_prefix (line, "Last chance to quit, ")) {
+
+	case BRASERO_WODIM_LINE_LAST_CHANCE:
 		brasero_job_set_dangerous (BRASERO_JOB (process), TRUE);
-	}
-/*	else if (g_str_has_prefix (line, "Blanking PMA, TOC, pregap")
-	     ||  strstr (line, "Blanking entire disk")) {
+		break;
 
-	}
- */
-	else if (strstr (line, "Disk sub type: Ultra High speed+")) {
+	/* case: "Blanking PMA, TOC, pregap" or "Blanking entire disk" */
+
+	case BRASERO_WODIM_LINE_UHS_DISC:
 		/* Set a deferred error as this message tends to indicate a failure */
 		brasero_process_deferred_error (process,
 						g_error_new (BRASERO_BURN_ERROR,
 							     BRASERO_BURN_ERROR_MEDIUM_INVALID,
 							     _("The disc is not supported")));
-	}
+		break;
+
 	/* This should not happen */
-	/* else if (strstr (line, "Use tsize= option in SAO mode to specify track size")) */
+	/* case: "Use tsize= option in SAO mode to specify track size" */
+
+	default:
+		break;
+	}
 
 	return BRASERO_BURN_OK;
 }
@@ -1207,6 +1296,11 @@ brasero_wodim_init (BraseroWodim *obj)
 		priv->minbuf = 30;
 
 	g_object_unref (settings);
+
+	priv->stderr_matcher = brasero_line_matcher_new (stderr_patterns,
+							 G_N_ELEMENTS (stderr_patterns));
+	priv->stdout_matcher = brasero_line_matcher_new (stdout_patterns,
+							 G_N_ELEMENTS (stdout_patterns));
 }
 
 static void
@@ -1228,6 +1322,12 @@ brasero_wodim_finalize (GObject *object)
 	g_slist_free (priv->infs);
 	priv->infs = NULL;
 
+	brasero_line_matcher_free (priv->stderr_matcher);
+	priv->stderr_matcher = NULL;
+
+	brasero_line_matcher_free (priv->stdout_matcher);
+	priv->stdout_matcher = NULL;
+
 	G_OBJECT_CLASS (parent_class)->finalize (object);
 }
 
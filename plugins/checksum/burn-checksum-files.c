@@ -32,11 +32,19 @@
 #  include <config.h>
 #endif
 
+/* This is for O_DIRECT */
+#define _GNU_SOURCE
+
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <errno.h>
 #include <ctype.h>
+#include <fcntl.h>
+#include <unistd.h>
 #include <sys/param.h>
+#include <sys/types.h>
+#include <sys/stat.h>
 
 #include <glib.h>
 #include <glib-object.h>
@@ -75,6 +83,27 @@ struct _BraseroChecksumFilesPrivate {
 	BraseroChecksumType checksum_type;
 
 	gint64 file_num;
+	gint64 file_nb;
+
+	/* Files are hashed by a pool of threads while the graft
+	 * points are explored. Entries are queued in the order
+	 * they were found in so that lines are written in the
+	 * same order whatever the order they are hashed in. */
+	GThreadPool *pool;
+	GMutex *pool_mutex;
+	GCond *pool_cond;
+	GQueue entries;
+	GChecksumType gchecksum_type;
+
+	/* used to read the files to hash; they are aligned so
+	 * that they can be used with O_DIRECT */
+	GSList *buffers;
+	guint use_direct_io:1;
+
+	/* used to report throughput (protected by pool_mutex) */
+	gint64 start_time;
+	gint64 last_rate_time;
+	goffset bytes_read;
 
 	/* the FILE to write to when we generate */
 	FILE *file;
@@ -91,30 +120,148 @@ typedef struct _BraseroChecksumFilesPrivate BraseroChecksumFilesPrivate;
 
 #define BRASERO_CHECKSUM_FILES_PRIVATE(o)  (G_TYPE_INSTANCE_GET_PRIVATE ((o), BRASERO_TYPE_CHECKSUM_FILES, BraseroChecksumFilesPrivate))
 
-#define BLOCK_SIZE			64
+/* Files are read in big chunks to limit the number of system calls.
+ * The alignment is the one required by O_DIRECT on most systems. */
+#define BRASERO_CHECKSUM_BUFFER_SIZE	(1 << 20)
+#define BRASERO_CHECKSUM_BUFFER_ALIGN	4096
+
+/* How often (in microseconds) the rate is updated */
+#define BRASERO_CHECKSUM_RATE_INTERVAL	500000
 
-#define BRASERO_SCHEMA_CONFIG		"org.gnome.brasero.config"
-#define BRASERO_PROPS_CHECKSUM_FILES	"checksum-files"
+/* Maximum number of hashing threads and of files waiting to be written */
+#define BRASERO_CHECKSUM_MAX_THREADS	8
+#define BRASERO_CHECKSUM_MAX_PENDING	64
+
+#define BRASERO_SCHEMA_CONFIG			"org.gnome.brasero.config"
+#define BRASERO_PROPS_CHECKSUM_FILES		"checksum-files"
+#define BRASERO_PROPS_CHECKSUM_FILES_DIRECT	"checksum-files-direct-io"
 
 static BraseroJobClass *parent_class = NULL;
 
+static void
+brasero_checksum_files_update_rate (BraseroChecksumFiles *self,
+				    gssize read_bytes)
+{
+	BraseroChecksumFilesPrivate *priv;
+	gint64 now;
+
+	priv = BRASERO_CHECKSUM_FILES_PRIVATE (self);
+
+	g_mutex_lock (priv->pool_mutex);
+
+	priv->bytes_read += read_bytes;
+
+	now = g_get_monotonic_time ();
+	if (now - priv->last_rate_time >= BRASERO_CHECKSUM_RATE_INTERVAL) {
+		priv->last_rate_time = now;
+		if (now > priv->start_time)
+			brasero_job_set_rate (BRASERO_JOB (self),
+					      priv->bytes_read * G_USEC_PER_SEC / (now - priv->start_time));
+	}
+
+	g_mutex_unlock (priv->pool_mutex);
+}
+
+static guchar *
+brasero_checksum_files_get_buffer (BraseroChecksumFiles *self)
+{
+	BraseroChecksumFilesPrivate *priv;
+	guchar *buffer = NULL;
+
+	priv = BRASERO_CHECKSUM_FILES_PRIVATE (self);
+
+	g_mutex_lock (priv->pool_mutex);
+	if (priv->buffers) {
+		buffer = priv->buffers->data;
+		priv->buffers = g_slist_delete_link (priv->buffers, priv->buffers);
+	}
+	g_mutex_unlock (priv->pool_mutex);
+
+	if (!buffer
+	&&   posix_memalign ((void **) &buffer,
+			     BRASERO_CHECKSUM_BUFFER_ALIGN,
+			     BRASERO_CHECKSUM_BUFFER_SIZE))
+		return NULL;
+
+	return buffer;
+}
+
+static void
+brasero_checksum_files_release_buffer (BraseroChecksumFiles *self,
+				       guchar *buffer)
+{
+	BraseroChecksumFilesPrivate *priv;
+
+	priv = BRASERO_CHECKSUM_FILES_PRIVATE (self);
+
+	g_mutex_lock (priv->pool_mutex);
+	priv->buffers = g_slist_prepend (priv->buffers, buffer);
+	g_mutex_unlock (priv->pool_mutex);
+}
+
+static void
+brasero_checksum_files_free_buffers (BraseroChecksumFiles *self)
+{
+	BraseroChecksumFilesPrivate *priv;
+
+	priv = BRASERO_CHECKSUM_FILES_PRIVATE (self);
+
+	g_slist_foreach (priv->buffers, (GFunc) free, NULL);
+	g_slist_free (priv->buffers);
+	priv->buffers = NULL;
+}
+
+static int
+brasero_checksum_files_open (BraseroChecksumFiles *self,
+			     const gchar *path)
+{
+	BraseroChecksumFilesPrivate *priv;
+	int fd;
+
+	priv = BRASERO_CHECKSUM_FILES_PRIVATE (self);
+
+#ifdef O_DIRECT
+
+	/* Bypassing the page cache avoids evicting everything else when
+	 * hashing a whole disc worth of files. Not all filesystems support it
+	 * so fall back to normal reads if it fails. */
+	if (priv->use_direct_io) {
+		fd = open (path, O_RDONLY|O_DIRECT);
+		if (fd >= 0 || errno != EINVAL)
+			return fd;
+	}
+
+#endif
+
+	fd = open (path, O_RDONLY);
+
+#ifdef POSIX_FADV_SEQUENTIAL
+
+	if (fd >= 0)
+		posix_fadvise (fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+#endif
+
+	return fd;
+}
+
 static BraseroBurnResult
 brasero_checksum_files_get_file_checksum (BraseroChecksumFiles *self,
 					  GChecksumType type,
 					  const gchar *path,
+					  guchar *buffer,
 					  gchar **checksum_string,
 					  GError **error)
 {
 	BraseroChecksumFilesPrivate *priv;
-	guchar buffer [BLOCK_SIZE];
 	GChecksum *checksum;
-	gint read_bytes;
-	FILE *file;
+	gssize read_bytes;
+	int fd;
 
 	priv = BRASERO_CHECKSUM_FILES_PRIVATE (self);
 
-	file = fopen (path, "r");
-	if (!file) {
+	fd = brasero_checksum_files_open (self, path);
+	if (fd < 0) {
                 int errsv;
 		gchar *name = NULL;
 
@@ -138,55 +285,136 @@ brasero_checksum_files_get_file_checksum (BraseroChecksumFiles *self,
 
 	checksum = g_checksum_new (type);
 
-	read_bytes = fread (buffer, 1, BLOCK_SIZE, file);
-	g_checksum_update (checksum, buffer, read_bytes);
-
-	while (read_bytes == BLOCK_SIZE) {
+	while (1) {
 		if (priv->cancel) {
-			fclose (file);
+			close (fd);
 			g_checksum_free (checksum);
 			return BRASERO_BURN_CANCEL;
 		}
 
-		read_bytes = fread (buffer, 1, BLOCK_SIZE, file);
+		read_bytes = read (fd, buffer, BRASERO_CHECKSUM_BUFFER_SIZE);
+		if (read_bytes < 0) {
+			int errsv = errno;
+
+			if (errsv == EINTR || errsv == EAGAIN)
+				continue;
+
+			close (fd);
+			g_checksum_free (checksum);
+
+			g_set_error (error,
+				     BRASERO_BURN_ERROR,
+				     BRASERO_BURN_ERROR_GENERAL,
+				     _("Data could not be read (%s)"),
+				     g_strerror (errsv));
+			return BRASERO_BURN_ERR;
+		}
+
+		if (!read_bytes)
+			break;
+
 		g_checksum_update (checksum, buffer, read_bytes);
+		brasero_checksum_files_update_rate (self, read_bytes);
 	}
 
 	*checksum_string = g_strdup (g_checksum_get_string (checksum));
 	g_checksum_free (checksum);
-	fclose (file);
+	close (fd);
 
 	return BRASERO_BURN_OK;
 }
 
+struct _BraseroChecksumFilesEntry {
+	gchar *path;
+	gchar *graft_path;
+
+	gchar *checksum;
+	GError *error;
+	BraseroBurnResult result;
+
+	guint done:1;
+};
+typedef struct _BraseroChecksumFilesEntry BraseroChecksumFilesEntry;
+
+static void
+brasero_checksum_files_entry_free (BraseroChecksumFilesEntry *entry)
+{
+	if (entry->error)
+		g_error_free (entry->error);
+
+	g_free (entry->checksum);
+	g_free (entry->graft_path);
+	g_free (entry->path);
+	g_free (entry);
+}
+
+/**
+ * Run by the threads of the pool
+ */
+
+static void
+brasero_checksum_files_hash_entry (gpointer data,
+				   gpointer user_data)
+{
+	BraseroChecksumFilesEntry *entry = data;
+	BraseroChecksumFiles *self = user_data;
+	BraseroChecksumFilesPrivate *priv;
+	guchar *buffer;
+
+	priv = BRASERO_CHECKSUM_FILES_PRIVATE (self);
+
+	buffer = brasero_checksum_files_get_buffer (self);
+	if (buffer) {
+		entry->result = brasero_checksum_files_get_file_checksum (self,
+									  priv->gchecksum_type,
+									  entry->path,
+									  buffer,
+									  &entry->checksum,
+									  &entry->error);
+		brasero_checksum_files_release_buffer (self, buffer);
+	}
+	else {
+		g_set_error (&entry->error,
+			     BRASERO_BURN_ERROR,
+			     BRASERO_BURN_ERROR_GENERAL,
+			     "%s",
+			     g_strerror (ENOMEM));
+		entry->result = BRASERO_BURN_ERR;
+	}
+
+	g_mutex_lock (priv->pool_mutex);
+	entry->done = TRUE;
+	g_cond_broadcast (priv->pool_cond);
+	g_mutex_unlock (priv->pool_mutex);
+}
+
 static BraseroBurnResult
-brasero_checksum_files_add_file_checksum (BraseroChecksumFiles *self,
-					  const gchar *path,
-					  GChecksumType checksum_type,
-					  const gchar *graft_path,
-					  GError **error)
+brasero_checksum_files_write_entry (BraseroChecksumFiles *self,
+				    BraseroChecksumFilesEntry *entry,
+				    GError **error)
 {
-	BraseroBurnResult result = BRASERO_BURN_OK;
 	BraseroChecksumFilesPrivate *priv;
-	gchar *checksum_string = NULL;
 	gint written;
 
 	priv = BRASERO_CHECKSUM_FILES_PRIVATE (self);
 
-	/* write to the file */
-	result = brasero_checksum_files_get_file_checksum (self,
-							   checksum_type,
-							   path,
-							   &checksum_string,
-							   error);
-	if (result != BRASERO_BURN_OK)
+	if (entry->result != BRASERO_BURN_OK) {
+		if (entry->error) {
+			g_propagate_error (error, entry->error);
+			entry->error = NULL;
+		}
+
+		if (entry->result == BRASERO_BURN_CANCEL)
+			return BRASERO_BURN_CANCEL;
+
 		return BRASERO_BURN_ERR;
+	}
 
-	written = fwrite (checksum_string,
-			  strlen (checksum_string),
+	/* write to the file */
+	written = fwrite (entry->checksum,
+			  strlen (entry->checksum),
 			  1,
 			  priv->file);
-	g_free (checksum_string);
 
 	if (written != 1) {
                 int errsv = errno;
@@ -206,8 +434,8 @@ brasero_checksum_files_add_file_checksum (BraseroChecksumFiles *self,
 
 	/* NOTE: we remove the first "/" from path so the file can be
 	 * used with md5sum at the root of the disc once mounted */
-	written = fwrite (graft_path + 1,
-			  strlen (graft_path + 1),
+	written = fwrite (entry->graft_path + 1,
+			  strlen (entry->graft_path + 1),
 			  1,
 			  priv->file);
 
@@ -227,13 +455,136 @@ brasero_checksum_files_add_file_checksum (BraseroChecksumFiles *self,
 			  1,
 			  priv->file);
 
-	return result;
+	priv->file_num ++;
+	brasero_job_set_progress (BRASERO_JOB (self),
+				  (gdouble) priv->file_num /
+				  (gdouble) priv->file_nb);
+
+	return BRASERO_BURN_OK;
+}
+
+/**
+ * Writes the lines of the files already hashed in the order they were queued.
+ * If wait_all is FALSE, it only waits for the first file to be hashed when
+ * there are too many of them pending.
+ */
+
+static BraseroBurnResult
+brasero_checksum_files_flush_entries (BraseroChecksumFiles *self,
+				      gboolean wait_all,
+				      GError **error)
+{
+	BraseroChecksumFilesPrivate *priv;
+	BraseroChecksumFilesEntry *entry;
+
+	priv = BRASERO_CHECKSUM_FILES_PRIVATE (self);
+
+	g_mutex_lock (priv->pool_mutex);
+	while ((entry = g_queue_peek_head (&priv->entries))) {
+		BraseroBurnResult result;
+
+		if (!entry->done) {
+			if (!wait_all
+			&&  g_queue_get_length (&priv->entries) < BRASERO_CHECKSUM_MAX_PENDING)
+				break;
+
+			g_cond_wait (priv->pool_cond, priv->pool_mutex);
+			continue;
+		}
+
+		g_queue_pop_head (&priv->entries);
+		g_mutex_unlock (priv->pool_mutex);
+
+		result = brasero_checksum_files_write_entry (self, entry, error);
+		brasero_checksum_files_entry_free (entry);
+
+		if (result != BRASERO_BURN_OK)
+			return result;
+
+		g_mutex_lock (priv->pool_mutex);
+	}
+	g_mutex_unlock (priv->pool_mutex);
+
+	return BRASERO_BURN_OK;
+}
+
+static BraseroBurnResult
+brasero_checksum_files_add_file_checksum (BraseroChecksumFiles *self,
+					  const gchar *path,
+					  const gchar *graft_path,
+					  GError **error)
+{
+	BraseroChecksumFilesPrivate *priv;
+	BraseroChecksumFilesEntry *entry;
+
+	priv = BRASERO_CHECKSUM_FILES_PRIVATE (self);
+
+	entry = g_new0 (BraseroChecksumFilesEntry, 1);
+	entry->path = g_strdup (path);
+	entry->graft_path = g_strdup (graft_path);
+
+	g_mutex_lock (priv->pool_mutex);
+	g_queue_push_tail (&priv->entries, entry);
+	g_mutex_unlock (priv->pool_mutex);
+
+	g_thread_pool_push (priv->pool, entry, NULL);
+
+	/* write what is ready */
+	return brasero_checksum_files_flush_entries (self, FALSE, error);
+}
+
+static BraseroBurnResult
+brasero_checksum_files_start_pool (BraseroChecksumFiles *self,
+				   GChecksumType gchecksum_type,
+				   GError **error)
+{
+	BraseroChecksumFilesPrivate *priv;
+	glong num_threads;
+
+	priv = BRASERO_CHECKSUM_FILES_PRIVATE (self);
+
+	priv->gchecksum_type = gchecksum_type;
+
+	priv->bytes_read = 0;
+	priv->start_time = g_get_monotonic_time ();
+	priv->last_rate_time = priv->start_time;
+
+	num_threads = sysconf (_SC_NPROCESSORS_ONLN);
+	num_threads = CLAMP (num_threads, 1, BRASERO_CHECKSUM_MAX_THREADS);
+
+	priv->pool = g_thread_pool_new (brasero_checksum_files_hash_entry,
+					self,
+					num_threads,
+					FALSE,
+					error);
+	if (!priv->pool)
+		return BRASERO_BURN_ERR;
+
+	return BRASERO_BURN_OK;
+}
+
+static void
+brasero_checksum_files_stop_pool (BraseroChecksumFiles *self,
+				  gboolean immediate)
+{
+	BraseroChecksumFilesPrivate *priv;
+	BraseroChecksumFilesEntry *entry;
+
+	priv = BRASERO_CHECKSUM_FILES_PRIVATE (self);
+
+	if (priv->pool) {
+		/* when immediate is TRUE the files not being hashed
+		 * yet are dropped */
+		g_thread_pool_free (priv->pool, immediate, TRUE);
+		priv->pool = NULL;
+	}
+
+	while ((entry = g_queue_pop_head (&priv->entries)))
+		brasero_checksum_files_entry_free (entry);
 }
 
 static BraseroBurnResult
 brasero_checksum_files_explore_directory (BraseroChecksumFiles *self,
-					  GChecksumType checksum_type,
-					  gint64 file_nb,
 					  const gchar *directory,
 					  const gchar *disc_path,
 					  GHashTable *excludedH,
@@ -268,8 +619,6 @@ brasero_checksum_files_explore_directory (BraseroChecksumFiles *self,
 		graft_path = g_build_path (G_DIR_SEPARATOR_S, disc_path, name, NULL);
 		if (g_file_test (path, G_FILE_TEST_IS_DIR)) {
 			result = brasero_checksum_files_explore_directory (self,
-									   checksum_type,
-									   file_nb,
 									   path,
 									   graft_path,
 									   excludedH,
@@ -292,7 +641,6 @@ brasero_checksum_files_explore_directory (BraseroChecksumFiles *self,
 
 		result = brasero_checksum_files_add_file_checksum (self,
 								   path,
-								   checksum_type,
 								   graft_path,
 								   error);
 		g_free (graft_path);
@@ -300,11 +648,6 @@ brasero_checksum_files_explore_directory (BraseroChecksumFiles *self,
 
 		if (result != BRASERO_BURN_OK)
 			break;
-
-		priv->file_num ++;
-		brasero_job_set_progress (BRASERO_JOB (self),
-					  (gdouble) priv->file_num /
-					  (gdouble) file_nb);
 	}
 	g_dir_close (dir);
 
@@ -535,6 +878,7 @@ brasero_checksum_files_create_checksum (BraseroChecksumFiles *self,
 	/* get the checksum type */
 	settings = g_settings_new (BRASERO_SCHEMA_CONFIG);
 	checksum_type = g_settings_get_int (settings, BRASERO_PROPS_CHECKSUM_FILES);
+	priv->use_direct_io = g_settings_get_boolean (settings, BRASERO_PROPS_CHECKSUM_FILES_DIRECT);
 	g_object_unref (settings);
 
 	if (checksum_type & BRASERO_CHECKSUM_MD5_FILE)
@@ -625,6 +969,16 @@ brasero_checksum_files_create_checksum (BraseroChecksumFiles *self,
 	else
 		file_nb = -1;
 
+	priv->file_nb = file_nb;
+
+	result = brasero_checksum_files_start_pool (self, gchecksum_type, error);
+	if (result != BRASERO_BURN_OK) {
+		g_hash_table_destroy (excludedH);
+		fclose (priv->file);
+		priv->file = NULL;
+		return result;
+	}
+
 	iter = brasero_track_data_get_grafts (BRASERO_TRACK_DATA (track));
 	for (; iter; iter = iter->next) {
 		BraseroGraftPt *graft;
@@ -656,23 +1010,15 @@ brasero_checksum_files_create_checksum (BraseroChecksumFiles *self,
 
 		if (g_file_test (path, G_FILE_TEST_IS_DIR))
 			result = brasero_checksum_files_explore_directory (self,
-									   gchecksum_type,
-									   file_nb,
 									   path,
 									   graft_path,
 									   excludedH,
 									   error);
-		else {
+		else
 			result = brasero_checksum_files_add_file_checksum (self,
 									   path,
-									   gchecksum_type,
 									   graft_path,
 									   error);
-			priv->file_num ++;
-			brasero_job_set_progress (BRASERO_JOB (self),
-						  (gdouble) priv->file_num /
-						  (gdouble) file_nb);
-		}
 
 		g_free (path);
 		if (result != BRASERO_BURN_OK)
@@ -681,6 +1027,12 @@ brasero_checksum_files_create_checksum (BraseroChecksumFiles *self,
 
 	g_hash_table_destroy (excludedH);
 
+	/* write the remaining lines */
+	if (result == BRASERO_BURN_OK)
+		result = brasero_checksum_files_flush_entries (self, TRUE, error);
+
+	brasero_checksum_files_stop_pool (self, result != BRASERO_BURN_OK);
+
 	if (result == BRASERO_BURN_OK)
 		result = brasero_checksum_files_merge_with_former_session (self, error);
 
@@ -713,13 +1065,9 @@ brasero_checksum_files_sum_on_disc_file (BraseroChecksumFiles *self,
 
 	checksum = g_checksum_new (type);
 
-	read_bytes = brasero_volume_file_read_direct (handle,
-						      buffer,
-						      64);
-	g_checksum_update (checksum, buffer, read_bytes);
-
-	while (read_bytes == sizeof (buffer)) {
+	do {
 		if (priv->cancel) {
+			g_checksum_free (checksum);
 			brasero_volume_file_close (handle);
 			return BRASERO_BURN_CANCEL;
 		}
@@ -727,8 +1075,14 @@ brasero_checksum_files_sum_on_disc_file (BraseroChecksumFiles *self,
 		read_bytes = brasero_volume_file_read_direct (handle,
 							      buffer,
 							      64);
+		if (read_bytes < 0) {
+			g_checksum_free (checksum);
+			brasero_volume_file_close (handle);
+			return BRASERO_BURN_ERR;
+		}
+
 		g_checksum_update (checksum, buffer, read_bytes);
-	}
+	} while (read_bytes == sizeof (buffer));
 
 	*checksum_string = g_strdup (g_checksum_get_string (checksum));
 	g_checksum_free (checksum);
@@ -791,30 +1145,77 @@ brasero_checksum_files_get_on_disc_checksum_type (BraseroChecksumFiles *self,
 	return file;
 }
 
-static gint
-brasero_checksum_files_get_line_num (BraseroChecksumFiles *self,
-				     BraseroVolFileHandle *handle)
+/**
+ * Reads the whole checksum file at once line by line (it's small compared to
+ * the files it describes) which avoids reading it twice to count the files and
+ * reading it one character at a time.
+ */
+
+static GPtrArray *
+brasero_checksum_files_read_lines (BraseroChecksumFiles *self,
+				   BraseroVolFileHandle *handle)
 {
+	gchar line [MAXPATHLEN + 512 + 2];
 	BraseroBurnResult result;
-	int num = 0;
+	GPtrArray *lines;
+
+	lines = g_ptr_array_new_with_free_func (g_free);
+	do {
+		/* NOTE: the last line is not always NULL terminated */
+		memset (line, 0, sizeof (line));
+		result = brasero_volume_file_read_line (handle, line, sizeof (line));
+		if (result == BRASERO_BURN_ERR) {
+			g_ptr_array_free (lines, TRUE);
+			return NULL;
+		}
 
-	while ((result = brasero_volume_file_read_line (handle, NULL, 0)) == BRASERO_BURN_RETRY)
-		num ++;
+		if (line [0] != '\0')
+			g_ptr_array_add (lines, g_strdup (line));
 
-	if (result == BRASERO_BURN_ERR)
-		return -1;
+	} while (result == BRASERO_BURN_RETRY);
 
-	brasero_volume_file_rewind (handle);
-	return num;
+	return lines;
+}
+
+/**
+ * Splits a line in the format of md5sum and the like into a checksum and a
+ * path (absolute on the disc). NOTE: line is modified.
+ */
+
+static gboolean
+brasero_checksum_files_parse_line (gchar *line,
+				   gint checksum_len,
+				   gchar **checksum,
+				   gchar *file_path,
+				   gsize file_path_len)
+{
+	gchar *name;
+
+	if (strlen (line) <= checksum_len || !isspace (line [checksum_len]))
+		return FALSE;
+
+	line [checksum_len] = '\0';
+	*checksum = line;
+
+	/* skip spaces in between */
+	name = line + checksum_len + 1;
+	while (isspace (*name))
+		name ++;
+
+	if (*name == '\0')
+		return FALSE;
+
+	g_snprintf (file_path, file_path_len, "/%s", name);
+	return TRUE;
 }
 
 static BraseroBurnResult
 brasero_checksum_files_check_files (BraseroChecksumFiles *self,
 				    GError **error)
 {
+	guint i;
 	GValue *value;
-	guint file_nb;
-	guint file_num;
+	GPtrArray *lines = NULL;
 	gint checksum_len;
 	BraseroVolSrc *vol;
 	goffset start_block;
@@ -871,23 +1272,22 @@ brasero_checksum_files_check_files (BraseroChecksumFiles *self,
 		goto end;
 	}
 
-	/* get the number of files at this time and rewind */
-	file_nb = brasero_checksum_files_get_line_num (self, handle);
-	if (file_nb == 0) {
-		BRASERO_JOB_LOG (self, "Empty checksum file");
-		result = BRASERO_BURN_OK;
+	/* get all the lines and therefore the number of files */
+	lines = brasero_checksum_files_read_lines (self, handle);
+	if (!lines) {
+		/* An error here */
+		BRASERO_JOB_LOG (self, "Failed to read the checksum file");
+		result = BRASERO_BURN_ERR;
 		goto end;
 	}
 
-	if (file_nb < 0) {
-		/* An error here */
-		BRASERO_JOB_LOG (self, "Failed to retrieve the number of lines");
-		result = BRASERO_BURN_ERR;
+	if (!lines->len) {
+		BRASERO_JOB_LOG (self, "Empty checksum file");
+		result = BRASERO_BURN_OK;
 		goto end;
 	}
 
 	/* signal we're ready to start */
-	file_num = 0;
 	brasero_job_set_current_action (BRASERO_JOB (self),
 				        BRASERO_BURN_ACTION_CHECKSUM,
 					_("Checking file integrity"),
@@ -911,66 +1311,25 @@ brasero_checksum_files_check_files (BraseroChecksumFiles *self,
 	}
 
 	checksum_len = g_checksum_type_get_length (gchecksum_type) * 2;
-	while (1) {
+	for (i = 0; i < lines->len; i ++) {
 		gchar file_path [MAXPATHLEN + 1];
-		gchar checksum_file [512 + 1];
 		BraseroVolFile *disc_file;
+		gchar *checksum_file;
 		gchar *checksum_real;
-		gint read_bytes;
 
 		if (priv->cancel)
 			break;
 
-		/* first read the checksum */
-		read_bytes = brasero_volume_file_read (handle,
-						       checksum_file,
-						       checksum_len);
-		if (read_bytes == 0)
-			break;
-
-		if (read_bytes != checksum_len) {
+		if (!brasero_checksum_files_parse_line (g_ptr_array_index (lines, i),
+							checksum_len,
+							&checksum_file,
+							file_path,
+							sizeof (file_path))) {
 			/* FIXME: an error here */
 			BRASERO_JOB_LOG (self, "Impossible to read the checksum from file");
 			result = BRASERO_BURN_ERR;
 			break;
 		}
-		checksum_file [checksum_len] = '\0';
-
-		if (priv->cancel)
-			break;
-
-		/* skip spaces in between */
-		while (1) {
-			gchar c [2];
-
-			read_bytes = brasero_volume_file_read (handle, c, 1);
-			if (read_bytes == 0) {
-				result = BRASERO_BURN_OK;
-				goto end;
-			}
-
-			if (read_bytes < 0) {
-				/* FIXME: an error here */
-				BRASERO_JOB_LOG (self, "Impossible to read checksum file");
-				result = BRASERO_BURN_ERR;
-				goto end;
-			}
-
-			if (!isspace (c [0])) {
-				file_path [0] = '/';
-				file_path [1] = c [0];
-				break;
-			}
-		}
-
-		/* get the filename */
-		result = brasero_volume_file_read_line (handle, file_path + 2, sizeof (file_path) - 2);
-
-		/* FIXME: an error here */
-		if (result == BRASERO_BURN_ERR) {
-			BRASERO_JOB_LOG (self, "Impossible to read checksum file");
-			break;
-		}
 
 		checksum_real = NULL;
 
@@ -1017,10 +1376,9 @@ brasero_checksum_files_check_files (BraseroChecksumFiles *self,
 		if (result != BRASERO_BURN_OK)
 			break;
 
-		file_num++;
 		brasero_job_set_progress (BRASERO_JOB (self),
-					  (gdouble) file_num /
-					  (gdouble) file_nb);
+					  (gdouble) (i + 1) /
+					  (gdouble) lines->len);
 		BRASERO_JOB_LOG (self,
 				 "comparing checksums for file %s : %s (from md5 file) / %s (current)",
 				 file_path, checksum_file, checksum_real);
@@ -1045,6 +1403,9 @@ brasero_checksum_files_check_files (BraseroChecksumFiles *self,
 
 end:
 
+	if (lines)
+		g_ptr_array_free (lines, TRUE);
+
 	if (handle)
 		brasero_volume_file_close (handle);
 
@@ -1382,6 +1743,8 @@ brasero_checksum_files_stop (BraseroJob *job,
 		priv->sums_path = NULL;
 	}
 
+	brasero_checksum_files_free_buffers (BRASERO_CHECKSUM_FILES (job));
+
 	return BRASERO_BURN_OK;
 }
 
@@ -1394,6 +1757,9 @@ brasero_checksum_files_init (BraseroChecksumFiles *obj)
 
 	priv->mutex = g_mutex_new ();
 	priv->cond = g_cond_new ();
+
+	priv->pool_mutex = g_mutex_new ();
+	priv->pool_cond = g_cond_new ();
 }
 
 static void
@@ -1422,6 +1788,8 @@ brasero_checksum_files_finalize (GObject *object)
 		priv->file = NULL;
 	}
 
+	brasero_checksum_files_free_buffers (BRASERO_CHECKSUM_FILES (object));
+
 	if (priv->mutex) {
 		g_mutex_free (priv->mutex);
 		priv->mutex = NULL;
@@ -1432,6 +1800,16 @@ brasero_checksum_files_finalize (GObject *object)
 		priv->cond = NULL;
 	}
 
+	if (priv->pool_mutex) {
+		g_mutex_free (priv->pool_mutex);
+		priv->pool_mutex = NULL;
+	}
+
+	if (priv->pool_cond) {
+		g_cond_free (priv->pool_cond);
+		priv->pool_cond = NULL;
+	}
+
 	G_OBJECT_CLASS (parent_class)->finalize (object);
 }
 
@@ -1455,6 +1833,7 @@ static void
 brasero_checksum_files_export_caps (BraseroPlugin *plugin)
 {
 	GSList *input;
+	BraseroPluginConfOption *direct_io;
 	BraseroPluginConfOption *checksum_type;
 
 	brasero_plugin_define (plugin,
@@ -1512,5 +1891,10 @@ brasero_checksum_files_export_caps (BraseroPlugin *plugin)
 
 	brasero_plugin_add_conf_option (plugin, checksum_type);
 
+	direct_io = brasero_plugin_conf_option_new (BRASERO_PROPS_CHECKSUM_FILES_DIRECT,
+						    _("Bypass the system cache when reading files"),
+						    BRASERO_PLUGIN_OPTION_BOOL);
+	brasero_plugin_add_conf_option (plugin, direct_io);
+
 	brasero_plugin_set_compulsory (plugin, FALSE);
 }
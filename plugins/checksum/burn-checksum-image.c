@@ -32,6 +32,9 @@
 #  include <config.h>
 #endif
 
+/* Needed for tee () */
+#define _GNU_SOURCE
+
 #include <stdio.h>
 #include <string.h>
 #include <errno.h>
@@ -39,6 +42,8 @@
 #include <sys/param.h>
 #include <unistd.h>
 #include <fcntl.h>
+#include <sys/types.h>
+#include <sys/stat.h>
 
 #include <glib.h>
 #include <glib-object.h>
@@ -65,8 +70,25 @@
 
 BRASERO_PLUGIN_BOILERPLATE (BraseroChecksumImage, brasero_checksum_image, BRASERO_TYPE_JOB, BraseroJob);
 
+/* All the sums that can be computed in a single pass over the data */
+static const struct {
+	BraseroChecksumType type;
+	GChecksumType gtype;
+	const gchar *tag;
+} checksum_types [] = {
+	{ BRASERO_CHECKSUM_MD5,		G_CHECKSUM_MD5,		BRASERO_TRACK_CHECKSUM_MD5_TAG },
+	{ BRASERO_CHECKSUM_SHA1,	G_CHECKSUM_SHA1,	BRASERO_TRACK_CHECKSUM_SHA1_TAG },
+	{ BRASERO_CHECKSUM_SHA256,	G_CHECKSUM_SHA256,	BRASERO_TRACK_CHECKSUM_SHA256_TAG },
+};
+
+#define BRASERO_CHECKSUM_IMAGE_TYPES_NUM	G_N_ELEMENTS (checksum_types)
+
 struct _BraseroChecksumImagePrivate {
-	GChecksum *checksum;
+	/* One GChecksum per type in checksum_types; only those in
+	 * checksum_mask are computed. checksum_type is the one which
+	 * is set on the track. */
+	GChecksum *checksums [BRASERO_CHECKSUM_IMAGE_TYPES_NUM];
+	BraseroChecksumType checksum_mask;
 	BraseroChecksumType checksum_type;
 
 	/* That's for progress reporting */
@@ -87,6 +109,11 @@ typedef struct _BraseroChecksumImagePrivate BraseroChecksumImagePrivate;
 
 #define BRASERO_SCHEMA_CONFIG		"org.gnome.brasero.config"
 #define BRASERO_PROPS_CHECKSUM_IMAGE	"checksum-image"
+#define BRASERO_PROPS_CHECKSUM_IMAGE_ALL	"checksum-image-all"
+
+/* Data is copied in large chunks; when both ends are pipes it is first
+ * duplicated with tee () so that it is never written back from user space */
+#define BRASERO_CHECKSUM_IMAGE_BUFFER_SIZE	(1 << 20)
 
 static BraseroJobClass *parent_class = NULL;
 
@@ -188,33 +215,269 @@ brasero_checksum_image_write (BraseroChecksumImage *self,
 	return BRASERO_BURN_OK;
 }
 
+static void
+brasero_checksum_image_free_checksums (BraseroChecksumImage *self)
+{
+	BraseroChecksumImagePrivate *priv;
+	guint i;
+
+	priv = BRASERO_CHECKSUM_IMAGE_PRIVATE (self);
+	for (i = 0; i < BRASERO_CHECKSUM_IMAGE_TYPES_NUM; i ++) {
+		if (priv->checksums [i]) {
+			g_checksum_free (priv->checksums [i]);
+			priv->checksums [i] = NULL;
+		}
+	}
+
+	priv->checksum_mask = BRASERO_CHECKSUM_NONE;
+}
+
+static void
+brasero_checksum_image_update (BraseroChecksumImage *self,
+			       const guchar *buffer,
+			       gssize bytes)
+{
+	BraseroChecksumImagePrivate *priv;
+	guint i;
+
+	priv = BRASERO_CHECKSUM_IMAGE_PRIVATE (self);
+	for (i = 0; i < BRASERO_CHECKSUM_IMAGE_TYPES_NUM; i ++) {
+		if (priv->checksums [i])
+			g_checksum_update (priv->checksums [i], buffer, bytes);
+	}
+
+	priv->bytes += bytes;
+}
+
+static gboolean
+brasero_checksum_image_is_pipe (int fd)
+{
+	struct stat buf;
+
+	if (fd < 0 || fstat (fd, &buf))
+		return FALSE;
+
+	return S_ISFIFO (buf.st_mode);
+}
+
+/**
+ * Duplicates the content of fd_in into fd_out inside the kernel and then
+ * consumes the same data from fd_in to hash it. That saves copying it back
+ * from user space to the next process. Returns BRASERO_BURN_NOT_SUPPORTED
+ * if tee () can't be used before any data was transferred.
+ */
+
+static BraseroBurnResult
+brasero_checksum_image_checksum_tee (BraseroChecksumImage *self,
+				     int fd_in,
+				     int fd_out,
+				     guchar *buffer,
+				     GError **error)
+{
+	BraseroChecksumImagePrivate *priv;
+	gboolean started = FALSE;
+
+	priv = BRASERO_CHECKSUM_IMAGE_PRIVATE (self);
+
+	while (1) {
+		gssize teed;
+		gint read_bytes;
+
+		teed = tee (fd_in,
+			    fd_out,
+			    BRASERO_CHECKSUM_IMAGE_BUFFER_SIZE,
+			    SPLICE_F_NONBLOCK);
+
+		if (priv->cancel)
+			return BRASERO_BURN_CANCEL;
+
+		/* no more writers and nothing left in the pipe */
+		if (!teed)
+			break;
+
+		if (teed < 0) {
+			int errsv = errno;
+
+			if (errsv == EAGAIN || errsv == EINTR) {
+				g_usleep (500);
+				continue;
+			}
+
+			if (!started && (errsv == EINVAL || errsv == ENOSYS))
+				return BRASERO_BURN_NOT_SUPPORTED;
+
+			g_set_error (error,
+				     BRASERO_BURN_ERROR,
+				     BRASERO_BURN_ERROR_GENERAL,
+				     _("Data could not be written (%s)"),
+				     g_strerror (errsv));
+			return BRASERO_BURN_ERR;
+		}
+
+		started = TRUE;
+
+		/* The data is already in the pipe so this doesn't wait */
+		read_bytes = brasero_checksum_image_read (self,
+							  fd_in,
+							  buffer,
+							  teed,
+							  error);
+		if (read_bytes == -2)
+			return BRASERO_BURN_CANCEL;
+
+		if (read_bytes == -1)
+			return BRASERO_BURN_ERR;
+
+		brasero_checksum_image_update (self, buffer, read_bytes);
+
+		if (read_bytes != teed) {
+			g_set_error (error,
+				     BRASERO_BURN_ERROR,
+				     BRASERO_BURN_ERROR_GENERAL,
+				     _("Data could not be read (%s)"),
+				     g_strerror (EIO));
+			return BRASERO_BURN_ERR;
+		}
+	}
+
+	return BRASERO_BURN_OK;
+}
+
+/**
+ * Used when the input is a file: its content is moved to the next job with
+ * brasero_job_forward_fd () (without going through user space) and then
+ * hashed from the page cache where it still is. That's one copy instead
+ * of two.
+ */
+
+static BraseroBurnResult
+brasero_checksum_image_checksum_forward (BraseroChecksumImage *self,
+					 int fd_in,
+					 guchar *buffer,
+					 GError **error)
+{
+	BraseroChecksumImagePrivate *priv;
+	goffset offset = 0;
+
+	priv = BRASERO_CHECKSUM_IMAGE_PRIVATE (self);
+
+	while (1) {
+		BraseroBurnResult result;
+		gsize forwarded = 0;
+		gsize total = 0;
+
+		result = brasero_job_forward_fd (BRASERO_JOB (self),
+						 fd_in,
+						 BRASERO_CHECKSUM_IMAGE_BUFFER_SIZE,
+						 &forwarded,
+						 error);
+		if (priv->cancel)
+			return BRASERO_BURN_CANCEL;
+
+		if (result == BRASERO_BURN_RETRY) {
+			g_usleep (500);
+			continue;
+		}
+
+		if (result != BRASERO_BURN_OK)
+			return result;
+
+		/* end of file */
+		if (!forwarded)
+			break;
+
+		while (total < forwarded) {
+			gssize read_bytes;
+
+			read_bytes = pread (fd_in,
+					    buffer + total,
+					    forwarded - total,
+					    offset + total);
+			if (read_bytes <= 0) {
+				int errsv = errno;
+
+				if (read_bytes < 0 && errsv == EINTR)
+					continue;
+
+				g_set_error (error,
+					     BRASERO_BURN_ERROR,
+					     BRASERO_BURN_ERROR_GENERAL,
+					     _("Data could not be read (%s)"),
+					     g_strerror (read_bytes < 0 ? errsv : EIO));
+				return BRASERO_BURN_ERR;
+			}
+
+			total += read_bytes;
+		}
+
+		brasero_checksum_image_update (self, buffer, forwarded);
+		offset += forwarded;
+	}
+
+	return BRASERO_BURN_OK;
+}
+
 static BraseroBurnResult
 brasero_checksum_image_checksum (BraseroChecksumImage *self,
-				 GChecksumType checksum_type,
 				 int fd_in,
 				 int fd_out,
 				 GError **error)
 {
 	gint read_bytes;
-	guchar buffer [2048];
+	guchar *buffer;
 	BraseroBurnResult result;
 	BraseroChecksumImagePrivate *priv;
+	guint i;
 
 	priv = BRASERO_CHECKSUM_IMAGE_PRIVATE (self);
 
-	priv->checksum = g_checksum_new (checksum_type);
+	for (i = 0; i < BRASERO_CHECKSUM_IMAGE_TYPES_NUM; i ++) {
+		if (priv->checksum_mask & checksum_types [i].type)
+			priv->checksums [i] = g_checksum_new (checksum_types [i].gtype);
+	}
+
+	buffer = g_malloc (BRASERO_CHECKSUM_IMAGE_BUFFER_SIZE);
+
+	if (brasero_checksum_image_is_pipe (fd_in)
+	&&  brasero_checksum_image_is_pipe (fd_out)) {
+		result = brasero_checksum_image_checksum_tee (self,
+							      fd_in,
+							      fd_out,
+							      buffer,
+							      error);
+		if (result != BRASERO_BURN_NOT_SUPPORTED) {
+			g_free (buffer);
+			return result;
+		}
+
+		BRASERO_JOB_LOG (self, "tee () not supported, copying data");
+	}
+	else if (!brasero_checksum_image_is_pipe (fd_in)
+	     &&  brasero_checksum_image_is_pipe (fd_out)) {
+		result = brasero_checksum_image_checksum_forward (self,
+								  fd_in,
+								  buffer,
+								  error);
+		g_free (buffer);
+		return result;
+	}
+
 	result = BRASERO_BURN_OK;
 	while (1) {
 		read_bytes = brasero_checksum_image_read (self,
 							  fd_in,
 							  buffer,
-							  sizeof (buffer),
+							  BRASERO_CHECKSUM_IMAGE_BUFFER_SIZE,
 							  error);
-		if (read_bytes == -2)
-			return BRASERO_BURN_CANCEL;
+		if (read_bytes == -2) {
+			result = BRASERO_BURN_CANCEL;
+			break;
+		}
 
-		if (read_bytes == -1)
-			return BRASERO_BURN_ERR;
+		if (read_bytes == -1) {
+			result = BRASERO_BURN_ERR;
+			break;
+		}
 
 		if (!read_bytes)
 			break;
@@ -230,19 +493,15 @@ brasero_checksum_image_checksum (BraseroChecksumImage *self,
 				break;
 		}
 
-		g_checksum_update (priv->checksum,
-				   buffer,
-				   read_bytes);
-
-		priv->bytes += read_bytes;
+		brasero_checksum_image_update (self, buffer, read_bytes);
 	}
 
+	g_free (buffer);
 	return result;
 }
 
 static BraseroBurnResult
 brasero_checksum_image_checksum_fd_input (BraseroChecksumImage *self,
-					  GChecksumType checksum_type,
 					  GError **error)
 {
 	int fd_in = -1;
@@ -260,12 +519,11 @@ brasero_checksum_image_checksum_fd_input (BraseroChecksumImage *self,
 	brasero_job_get_fd_in (BRASERO_JOB (self), &fd_in);
 	brasero_job_get_fd_out (BRASERO_JOB (self), &fd_out);
 
-	return brasero_checksum_image_checksum (self, checksum_type, fd_in, fd_out, error);
+	return brasero_checksum_image_checksum (self, fd_in, fd_out, error);
 }
 
 static BraseroBurnResult
 brasero_checksum_image_checksum_file_input (BraseroChecksumImage *self,
-					    GChecksumType checksum_type,
 					    GError **error)
 {
 	BraseroChecksumImagePrivate *priv;
@@ -294,12 +552,14 @@ brasero_checksum_image_checksum_file_input (BraseroChecksumImage *self,
 			 priv->total);
 
 	fd_in = open (path, O_RDONLY);
-	if (!fd_in) {
+	if (fd_in < 0) {
                 int errsv;
 		gchar *name = NULL;
 
-		if (errno == ENOENT)
+		if (errno == ENOENT) {
+			g_free (path);
 			return BRASERO_BURN_RETRY;
+		}
 
 		name = g_path_get_basename (path);
 
@@ -319,9 +579,13 @@ brasero_checksum_image_checksum_file_input (BraseroChecksumImage *self,
 		return BRASERO_BURN_ERR;
 	}
 
+#ifdef POSIX_FADV_SEQUENTIAL
+	posix_fadvise (fd_in, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+
 	/* and here we go */
 	brasero_job_get_fd_out (BRASERO_JOB (self), &fd_out);
-	result = brasero_checksum_image_checksum (self, checksum_type, fd_in, fd_out, error);
+	result = brasero_checksum_image_checksum (self, fd_in, fd_out, error);
 	g_free (path);
 	close (fd_in);
 
@@ -334,21 +598,16 @@ brasero_checksum_image_create_checksum (BraseroChecksumImage *self,
 {
 	BraseroBurnResult result;
 	BraseroTrack *track = NULL;
-	GChecksumType checksum_type;
 	BraseroChecksumImagePrivate *priv;
 
 	priv = BRASERO_CHECKSUM_IMAGE_PRIVATE (self);
 
-	/* get the checksum type */
+	/* get the checksum type; only the one we compare against is needed */
 	switch (priv->checksum_type) {
 		case BRASERO_CHECKSUM_MD5:
-			checksum_type = G_CHECKSUM_MD5;
-			break;
 		case BRASERO_CHECKSUM_SHA1:
-			checksum_type = G_CHECKSUM_SHA1;
-			break;
 		case BRASERO_CHECKSUM_SHA256:
-			checksum_type = G_CHECKSUM_SHA256;
+			priv->checksum_mask = priv->checksum_type;
 			break;
 		default:
 			return BRASERO_BURN_ERR;
@@ -400,7 +659,7 @@ brasero_checksum_image_create_checksum (BraseroChecksumImage *self,
 		/* That's the only way to get the sector size */
 		priv->total *= bytes / sectors;
 
-		return brasero_checksum_image_checksum_fd_input (self, checksum_type, error);
+		return brasero_checksum_image_checksum_fd_input (self, error);
 	}
 	else {
 		result = brasero_track_get_size (track,
@@ -409,7 +668,7 @@ brasero_checksum_image_create_checksum (BraseroChecksumImage *self,
 		if (result != BRASERO_BURN_OK)
 			return result;
 
-		return brasero_checksum_image_checksum_file_input (self, checksum_type, error);
+		return brasero_checksum_image_checksum_file_input (self, error);
 	}
 
 	return BRASERO_BURN_OK;
@@ -428,12 +687,24 @@ brasero_checksum_get_checksum_type (void)
 	return checksum_type;
 }
 
+static gboolean
+brasero_checksum_get_checksum_all (void)
+{
+	GSettings *settings;
+	gboolean all;
+
+	settings = g_settings_new (BRASERO_SCHEMA_CONFIG);
+	all = g_settings_get_boolean (settings, BRASERO_PROPS_CHECKSUM_IMAGE_ALL);
+	g_object_unref (settings);
+
+	return all;
+}
+
 static BraseroBurnResult
 brasero_checksum_image_image_and_checksum (BraseroChecksumImage *self,
 					   GError **error)
 {
 	BraseroBurnResult result;
-	GChecksumType checksum_type;
 	BraseroChecksumImagePrivate *priv;
 
 	priv = BRASERO_CHECKSUM_IMAGE_PRIVATE (self);
@@ -441,15 +712,20 @@ brasero_checksum_image_image_and_checksum (BraseroChecksumImage *self,
 	priv->checksum_type = brasero_checksum_get_checksum_type ();
 
 	if (priv->checksum_type & BRASERO_CHECKSUM_MD5)
-		checksum_type = G_CHECKSUM_MD5;
+		priv->checksum_type = BRASERO_CHECKSUM_MD5;
 	else if (priv->checksum_type & BRASERO_CHECKSUM_SHA1)
-		checksum_type = G_CHECKSUM_SHA1;
+		priv->checksum_type = BRASERO_CHECKSUM_SHA1;
 	else if (priv->checksum_type & BRASERO_CHECKSUM_SHA256)
-		checksum_type = G_CHECKSUM_SHA256;
-	else {
-		checksum_type = G_CHECKSUM_MD5;
+		priv->checksum_type = BRASERO_CHECKSUM_SHA256;
+	else
 		priv->checksum_type = BRASERO_CHECKSUM_MD5;
-	}
+
+	/* The other sums come for free since we read the data anyway */
+	priv->checksum_mask = priv->checksum_type;
+	if (brasero_checksum_get_checksum_all ())
+		priv->checksum_mask |= BRASERO_CHECKSUM_MD5|
+				       BRASERO_CHECKSUM_SHA1|
+				       BRASERO_CHECKSUM_SHA256;
 
 	brasero_job_set_current_action (BRASERO_JOB (self),
 					BRASERO_BURN_ACTION_CHECKSUM,
@@ -467,14 +743,10 @@ brasero_checksum_image_image_and_checksum (BraseroChecksumImage *self,
 		if (result != BRASERO_BURN_OK)
 			return result;
 
-		result = brasero_checksum_image_checksum_file_input (self,
-								     checksum_type,
-								     error);
+		result = brasero_checksum_image_checksum_file_input (self, error);
 	}
 	else
-		result = brasero_checksum_image_checksum_fd_input (self,
-								   checksum_type,
-								   error);
+		result = brasero_checksum_image_checksum_fd_input (self, error);
 
 	return result;
 }
@@ -495,6 +767,8 @@ brasero_checksum_image_end (gpointer data)
 	BraseroBurnResult result;
 	BraseroChecksumImagePrivate *priv;
 	BraseroChecksumImageThreadCtx *ctx;
+	GChecksum *primary = NULL;
+	guint i;
 
 	ctx = data;
 	self = ctx->sum;
@@ -509,8 +783,7 @@ brasero_checksum_image_end (gpointer data)
 		error = ctx->error;
 		ctx->error = NULL;
 
-		g_checksum_free (priv->checksum);
-		priv->checksum = NULL;
+		brasero_checksum_image_free_checksums (self);
 
 		brasero_job_error (BRASERO_JOB (self), error);
 		return FALSE;
@@ -521,9 +794,34 @@ brasero_checksum_image_end (gpointer data)
 	track = NULL;
 	brasero_job_get_current_track (BRASERO_JOB (self), &track);
 
+	/* Keep the additional sums computed during the same pass as tags */
+	for (i = 0; i < BRASERO_CHECKSUM_IMAGE_TYPES_NUM; i ++) {
+		if (!priv->checksums [i])
+			continue;
+
+		if (checksum_types [i].type == priv->checksum_type) {
+			primary = priv->checksums [i];
+			continue;
+		}
+
+		checksum = g_checksum_get_string (priv->checksums [i]);
+		BRASERO_JOB_LOG (self,
+				 "Additional checksum (type = %i) %s",
+				 checksum_types [i].type,
+				 checksum);
+		brasero_track_tag_add_string (track,
+					      checksum_types [i].tag,
+					      checksum);
+	}
+
+	if (!primary) {
+		brasero_checksum_image_free_checksums (self);
+		goto error;
+	}
+
 	/* Set the checksum for the track and at the same time compare it to a
 	 * potential previous one. */
-	checksum = g_checksum_get_string (priv->checksum);
+	checksum = g_checksum_get_string (primary);
 	BRASERO_JOB_LOG (self,
 			 "Setting new checksum (type = %i) %s (%s before)",
 			 priv->checksum_type,
@@ -532,8 +830,7 @@ brasero_checksum_image_end (gpointer data)
 	result = brasero_track_set_checksum (track,
 					     priv->checksum_type,
 					     checksum);
-	g_checksum_free (priv->checksum);
-	priv->checksum = NULL;
+	brasero_checksum_image_free_checksums (self);
 
 	if (result != BRASERO_BURN_OK)
 		goto error;
@@ -706,7 +1003,7 @@ brasero_checksum_image_clock_tick (BraseroJob *job)
 
 	priv = BRASERO_CHECKSUM_IMAGE_PRIVATE (job);
 
-	if (!priv->checksum)
+	if (!priv->checksum_mask)
 		return BRASERO_BURN_OK;
 
 	if (!priv->total)
@@ -742,10 +1039,7 @@ brasero_checksum_image_stop (BraseroJob *job,
 		priv->end_id = 0;
 	}
 
-	if (priv->checksum) {
-		g_checksum_free (priv->checksum);
-		priv->checksum = NULL;
-	}
+	brasero_checksum_image_free_checksums (BRASERO_CHECKSUM_IMAGE (job));
 
 	return BRASERO_BURN_OK;
 }
@@ -782,10 +1076,7 @@ brasero_checksum_image_finalize (GObject *object)
 		priv->end_id = 0;
 	}
 
-	if (priv->checksum) {
-		g_checksum_free (priv->checksum);
-		priv->checksum = NULL;
-	}
+	brasero_checksum_image_free_checksums (BRASERO_CHECKSUM_IMAGE (object));
 
 	if (priv->mutex) {
 		g_mutex_free (priv->mutex);
@@ -822,6 +1113,7 @@ brasero_checksum_image_export_caps (BraseroPlugin *plugin)
 {
 	GSList *input;
 	BraseroPluginConfOption *checksum_type;
+	BraseroPluginConfOption *checksum_all;
 
 	brasero_plugin_define (plugin,
 	                       "image-checksum",
@@ -864,5 +1156,10 @@ brasero_checksum_image_export_caps (BraseroPlugin *plugin)
 
 	brasero_plugin_add_conf_option (plugin, checksum_type);
 
+	checksum_all = brasero_plugin_conf_option_new (BRASERO_PROPS_CHECKSUM_IMAGE_ALL,
+						       _("Also compute the other checksums in the same pass"),
+						       BRASERO_PLUGIN_OPTION_BOOL);
+	brasero_plugin_add_conf_option (plugin, checksum_all);
+
 	brasero_plugin_set_compulsory (plugin, FALSE);
 }
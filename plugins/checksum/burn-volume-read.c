@@ -34,9 +34,18 @@
 #include "burn-iso9660.h"
 #include "burn-volume-read.h"
 
+/* Number of blocks read at once. It starts with 64 (an empirical value
+ * based on one of my drives) and is then adapted so that every read takes
+ * about BRASERO_VOL_READ_TARGET_TIME with the measured throughput. */
+#define BRASERO_VOL_READ_DEFAULT_BLOCKS		64
+#define BRASERO_VOL_READ_MIN_BLOCKS		16
+#define BRASERO_VOL_READ_MAX_BLOCKS		512
+#define BRASERO_VOL_READ_TARGET_TIME		50000	/* µs */
+
 struct _BraseroVolFileHandle {
-	/* 64 is an empirical value based on one of my drives. */
-	guchar buffer [2048 * 64];
+	/* Blocks are read in one buffer on a separate thread while the
+	 * other is consumed; buffer is the one being consumed. */
+	guchar *buffer;
 	guint buffer_max;
 
 	/* position in buffer */
@@ -52,11 +61,168 @@ struct _BraseroVolFileHandle {
 	GSList *extents_backward;
 	GSList *extents_forward;
 	guint position;
+
+	guint read_blocks;
+
+	/* read-ahead; the source must not be used by anything else while
+	 * prefetching is set */
+	guchar *next;
+	guint next_blocks;
+
+	GThread *thread;
+	GMutex *mutex;
+	GCond *cond;
+
+	/* Not bitfields since they are shared with the thread */
+	gboolean prefetching;
+	gboolean prefetched;
+	gboolean prefetch_result;
+	gboolean quit;
 };
 
+/**
+ * Reads blocks from the source and adapts the size of the following reads
+ * to the time it took. Only called by one thread at a time.
+ */
+
+static gboolean
+brasero_volume_file_read_blocks (BraseroVolFileHandle *handle,
+				 guchar *buffer,
+				 guint blocks)
+{
+	gint64 start;
+	gint64 elapsed;
+	gboolean result;
+
+	start = g_get_monotonic_time ();
+	result = BRASERO_VOL_SRC_READ (handle->src,
+				       (char *) buffer,
+				       blocks,
+				       NULL);
+	if (!result)
+		return FALSE;
+
+	/* Short reads at the end of extents don't tell anything */
+	elapsed = g_get_monotonic_time () - start;
+	if (blocks == handle->read_blocks && elapsed > 0) {
+		gint64 target;
+
+		target = (gint64) blocks * BRASERO_VOL_READ_TARGET_TIME / elapsed;
+
+		/* Smooth it a bit as drives spin up and down */
+		target = (target + handle->read_blocks) / 2;
+		handle->read_blocks = CLAMP (target,
+					     BRASERO_VOL_READ_MIN_BLOCKS,
+					     BRASERO_VOL_READ_MAX_BLOCKS);
+	}
+
+	return TRUE;
+}
+
+static gpointer
+brasero_volume_file_prefetch_thread (gpointer data)
+{
+	BraseroVolFileHandle *handle = data;
+
+	g_mutex_lock (handle->mutex);
+	while (!handle->quit) {
+		gboolean result;
+
+		if (!handle->prefetching) {
+			g_cond_wait (handle->cond, handle->mutex);
+			continue;
+		}
+
+		g_mutex_unlock (handle->mutex);
+		result = brasero_volume_file_read_blocks (handle,
+							  handle->next,
+							  handle->next_blocks);
+		g_mutex_lock (handle->mutex);
+
+		handle->prefetch_result = result;
+		handle->prefetching = FALSE;
+		handle->prefetched = TRUE;
+		g_cond_broadcast (handle->cond);
+	}
+	g_mutex_unlock (handle->mutex);
+
+	return NULL;
+}
+
+/**
+ * Starts reading the following blocks of the current extent
+ */
+
+static void
+brasero_volume_file_prefetch (BraseroVolFileHandle *handle)
+{
+	guint blocks;
+
+	blocks = MIN (handle->read_blocks, handle->extent_last - handle->position);
+	if (!blocks)
+		return;
+
+	if (!handle->thread) {
+		handle->thread = g_thread_create (brasero_volume_file_prefetch_thread,
+						  handle,
+						  TRUE,
+						  NULL);
+
+		/* Not fatal; we'll just read synchronously */
+		if (!handle->thread)
+			return;
+	}
+
+	g_mutex_lock (handle->mutex);
+	handle->next_blocks = blocks;
+	handle->prefetched = FALSE;
+	handle->prefetching = TRUE;
+	g_cond_broadcast (handle->cond);
+	g_mutex_unlock (handle->mutex);
+}
+
+static void
+brasero_volume_file_prefetch_wait (BraseroVolFileHandle *handle)
+{
+	if (!handle->thread)
+		return;
+
+	g_mutex_lock (handle->mutex);
+	while (handle->prefetching)
+		g_cond_wait (handle->cond, handle->mutex);
+	g_mutex_unlock (handle->mutex);
+}
+
+/**
+ * Needed before moving to another position in the source
+ */
+
+static void
+brasero_volume_file_prefetch_discard (BraseroVolFileHandle *handle)
+{
+	brasero_volume_file_prefetch_wait (handle);
+	handle->prefetched = FALSE;
+}
+
 void
 brasero_volume_file_close (BraseroVolFileHandle *handle)
 {
+	if (handle->thread) {
+		g_mutex_lock (handle->mutex);
+		handle->quit = TRUE;
+		g_cond_broadcast (handle->cond);
+		g_mutex_unlock (handle->mutex);
+
+		g_thread_join (handle->thread);
+		handle->thread = NULL;
+	}
+
+	g_mutex_free (handle->mutex);
+	g_cond_free (handle->cond);
+
+	g_free (handle->buffer);
+	g_free (handle->next);
+
 	g_slist_free (handle->extents_forward);
 	g_slist_free (handle->extents_backward);
 	brasero_volume_source_close (handle->src);
@@ -69,27 +235,45 @@ brasero_volume_file_fill_buffer (BraseroVolFileHandle *handle)
 	guint blocks;
 	gboolean result;
 
-	blocks = MIN (sizeof (handle->buffer) / 2048,
-		      handle->extent_last - handle->position);
+	brasero_volume_file_prefetch_wait (handle);
+	if (handle->prefetched) {
+		guchar *tmp;
+
+		handle->prefetched = FALSE;
+		result = handle->prefetch_result;
+		blocks = handle->next_blocks;
+
+		tmp = handle->buffer;
+		handle->buffer = handle->next;
+		handle->next = tmp;
+	}
+	else {
+		blocks = MIN (handle->read_blocks,
+			      handle->extent_last - handle->position);
+
+		result = brasero_volume_file_read_blocks (handle,
+							  handle->buffer,
+							  blocks);
+	}
 
-	result = BRASERO_VOL_SRC_READ (handle->src,
-				       (char *) handle->buffer,
-				       blocks,
-				       NULL);
 	if (!result)
 		return FALSE;
 
 	handle->offset = 0;
 	handle->position += blocks;
 
-	if (handle->position == handle->extent_last)
+	if (!blocks)
+		handle->buffer_max = 0;
+	else if (handle->position == handle->extent_last)
 		handle->buffer_max = (blocks - 1) * 2048 +
 				     ((handle->extent_size % 2048) ?
 				      (handle->extent_size % 2048) :
 				       2048);
 	else
-		handle->buffer_max = sizeof (handle->buffer);
+		handle->buffer_max = blocks * 2048;
 
+	/* Read the next blocks while the caller consumes these */
+	brasero_volume_file_prefetch (handle);
 	return TRUE;
 }
 
@@ -100,6 +284,8 @@ brasero_volume_file_next_extent (BraseroVolFileHandle *handle)
 	gint res_seek;
 	GSList *node;
 
+	brasero_volume_file_prefetch_discard (handle);
+
 	node = handle->extents_forward;
 	extent = node->data;
 
@@ -118,6 +304,25 @@ brasero_volume_file_next_extent (BraseroVolFileHandle *handle)
 	return TRUE;
 }
 
+static BraseroVolFileHandle *
+brasero_volume_file_handle_new (BraseroVolSrc *src)
+{
+	BraseroVolFileHandle *handle;
+
+	handle = g_new0 (BraseroVolFileHandle, 1);
+	handle->src = src;
+	brasero_volume_source_ref (src);
+
+	handle->read_blocks = BRASERO_VOL_READ_DEFAULT_BLOCKS;
+	handle->buffer = g_malloc (BRASERO_VOL_READ_MAX_BLOCKS * 2048);
+	handle->next = g_malloc (BRASERO_VOL_READ_MAX_BLOCKS * 2048);
+
+	handle->mutex = g_mutex_new ();
+	handle->cond = g_cond_new ();
+
+	return handle;
+}
+
 static gboolean
 brasero_volume_file_rewind_real (BraseroVolFileHandle *handle)
 {
@@ -136,10 +341,7 @@ brasero_volume_file_open (BraseroVolSrc *src,
 	if (file->isdir)
 		return NULL;
 
-	handle = g_new0 (BraseroVolFileHandle, 1);
-	handle->src = src;
-	brasero_volume_source_ref (src);
-
+	handle = brasero_volume_file_handle_new (src);
 	handle->extents_forward = g_slist_copy (file->specific.file.extents);
 	if (!brasero_volume_file_rewind_real (handle)) {
 		brasero_volume_file_close (handle);
@@ -331,29 +533,18 @@ brasero_volume_file_read_line (BraseroVolFileHandle *handle,
 	return brasero_volume_file_check_state (handle);
 }
 
+/**
+ * These used to read straight into the caller's buffer. They now go through
+ * the read-ahead buffers so that the next blocks are read while the caller
+ * processes the previous ones; the extra copy is cheap compared to the
+ * time spent waiting for the drive.
+ */
+
 BraseroVolFileHandle *
 brasero_volume_file_open_direct (BraseroVolSrc *src,
 				 BraseroVolFile *file)
 {
-	BraseroVolFileHandle *handle;
-
-	if (file->isdir)
-		return NULL;
-
-	handle = g_new0 (BraseroVolFileHandle, 1);
-	handle->src = src;
-	brasero_volume_source_ref (src);
-
-	handle->extents_forward = g_slist_copy (file->specific.file.extents);
-
-	/* Here the buffer stays unused, we copy straight to the buffer passed
-	 * in the read direct function. */
-	if (!brasero_volume_file_next_extent (handle)) {
-		brasero_volume_file_close (handle);
-		return NULL;
-	}
-
-	return handle;
+	return brasero_volume_file_open (src, file);
 }
 
 gint64
@@ -361,42 +552,7 @@ brasero_volume_file_read_direct (BraseroVolFileHandle *handle,
 				 guchar *buffer,
 				 guint blocks)
 {
-	gboolean result;
-	guint block2read;
-	guint readblocks = 0;
-
-start:
-
-	block2read = MIN (blocks - readblocks, handle->extent_last - handle->position);
-	if (!block2read)
-		return readblocks * 2048;
-
-	result = BRASERO_VOL_SRC_READ (handle->src,
-				       (char *) buffer + readblocks * 2048,
-				       block2read,
-				       NULL);
-	if (!result)
-		return -1;
-
-	handle->position += block2read;
-	readblocks += block2read;
-
-	if (handle->position == handle->extent_last) {
-		/* we are at the end of current extent try to find another */
-		if (!handle->extents_forward) {
-			/* we reached the end of our file */
-			return (readblocks - 1) * 2048 +
-			       ((handle->extent_size % 2048) != 0?
-			        (handle->extent_size % 2048) :
-				 2048);
-		}
-
-		if (!brasero_volume_file_next_extent (handle))
-			return -1;
-
-		goto start;
-	}
-
-	return readblocks * 2048;
+	return brasero_volume_file_read (handle,
+					 (gchar *) buffer,
+					 blocks * 2048);
 }
-
@@ -48,6 +48,7 @@
 #include "brasero-plugin-registration.h"
 #include "burn-job.h"
 #include "burn-process.h"
+#include "burn-line-matcher.h"
 #include "brasero-drive.h"
 #include "burn-growisofs-common.h"
 #include "brasero-track-data.h"
@@ -64,6 +65,8 @@
 BRASERO_PLUGIN_BOILERPLATE (BraseroGrowisofs, brasero_growisofs, BRASERO_TYPE_PROCESS, BraseroProcess);
 
 struct BraseroGrowisofsPrivate {
+	BraseroLineMatcher *stderr_matcher;
+
 	guint use_utf8:1;
 	guint use_genisoimage:1;
   	guint use_dao:1;
@@ -77,6 +80,38 @@ static GObjectClass *parent_class = NULL;
 #define BRASERO_SCHEMA_CONFIG		"org.gnome.brasero.config"
 #define BRASERO_KEY_DAO_FLAG		"dao-flag"
 
+/* Lines we react to; the first pattern found in a line wins */
+enum {
+	BRASERO_GROWISOFS_LINE_PROGRESS,
+	BRASERO_GROWISOFS_LINE_EXTENTS,
+	BRASERO_GROWISOFS_LINE_FLUSHING,
+	BRASERO_GROWISOFS_LINE_BUSY,
+	BRASERO_GROWISOFS_LINE_NO_SPACE,
+	BRASERO_GROWISOFS_LINE_LAST_SESSION,
+	BRASERO_GROWISOFS_LINE_SORT,
+	BRASERO_GROWISOFS_LINE_JOLIET,
+	BRASERO_GROWISOFS_LINE_ENCODING,
+	BRASERO_GROWISOFS_LINE_CHARSET
+};
+
+static const BraseroLinePattern stderr_patterns [] = {
+	{ "% done, estimate finish",				BRASERO_LINE_MATCH_CONTAINS,	BRASERO_GROWISOFS_LINE_PROGRESS },
+	{ "Total extents scheduled to be written = ",		BRASERO_LINE_MATCH_CONTAINS,	BRASERO_GROWISOFS_LINE_EXTENTS },
+	{ "flushing cache",					BRASERO_LINE_MATCH_CONTAINS,	BRASERO_GROWISOFS_LINE_FLUSHING },
+	{ "unable to open",					BRASERO_LINE_MATCH_CONTAINS,	BRASERO_GROWISOFS_LINE_BUSY },
+	{ "unable to stat",					BRASERO_LINE_MATCH_CONTAINS,	BRASERO_GROWISOFS_LINE_BUSY },
+	{ "unable to proceed with recording: unable to unmount",	BRASERO_LINE_MATCH_CONTAINS,	BRASERO_GROWISOFS_LINE_BUSY },
+	{ "not enough space available",				BRASERO_LINE_MATCH_CONTAINS,	BRASERO_GROWISOFS_LINE_NO_SPACE },
+	{ "end of user area encountered on this track",		BRASERO_LINE_MATCH_CONTAINS,	BRASERO_GROWISOFS_LINE_NO_SPACE },
+	{ "blocks are free",					BRASERO_LINE_MATCH_CONTAINS,	BRASERO_GROWISOFS_LINE_NO_SPACE },
+	{ "Input/output error. Read error on old image",	BRASERO_LINE_MATCH_CONTAINS,	BRASERO_GROWISOFS_LINE_LAST_SESSION },
+	{ "Unable to sort directory",				BRASERO_LINE_MATCH_CONTAINS,	BRASERO_GROWISOFS_LINE_SORT },
+	{ "have the same joliet name",				BRASERO_LINE_MATCH_CONTAINS,	BRASERO_GROWISOFS_LINE_JOLIET },
+	{ "Joliet tree sort failed.",				BRASERO_LINE_MATCH_CONTAINS,	BRASERO_GROWISOFS_LINE_JOLIET },
+	{ "Incorrectly encoded string",				BRASERO_LINE_MATCH_CONTAINS,	BRASERO_GROWISOFS_LINE_ENCODING },
+	{ "Unknown charset",					BRASERO_LINE_MATCH_CONTAINS,	BRASERO_GROWISOFS_LINE_CHARSET },
+};
+
 /* Process start */
 static BraseroBurnResult
 brasero_growisofs_read_stdout (BraseroProcess *process, const gchar *line)
@@ -126,12 +161,19 @@ brasero_growisofs_read_stdout (BraseroProcess *process, const gchar *line)
 static BraseroBurnResult
 brasero_growisofs_read_stderr (BraseroProcess *process, const gchar *line)
 {
+	BraseroGrowisofsPrivate *priv;
 	int perc_1, perc_2;
 
-	if (sscanf (line, " %2d.%2d%% done, estimate finish", &perc_1, &perc_2) == 2) {
+	priv = BRASERO_GROWISOFS_PRIVATE (process);
+
+	switch (brasero_line_matcher_match (priv->stderr_matcher, line)) {
+	case BRASERO_GROWISOFS_LINE_PROGRESS: {
 		gdouble fraction;
 		BraseroBurnAction action;
 
+		if (sscanf (line, " %2d.%2d%% done, estimate finish", &perc_1, &perc_2) != 2)
+			break;
+
 		fraction = (gdouble) ((gdouble) perc_1 +
 			   ((gdouble) perc_2 / (gdouble) 100.0)) /
 			   (gdouble) 100.0;
@@ -153,8 +195,10 @@ brasero_growisofs_read_stderr (BraseroProcess *process, const gchar *line)
 						NULL,
 						FALSE);
 		brasero_job_start_progress (BRASERO_JOB (process), FALSE);
+		break;
 	}
-	else if (strstr (line, "Total extents scheduled to be written = ")) {
+
+	case BRASERO_GROWISOFS_LINE_EXTENTS: {
 		BraseroJobAction action;
 
 		line += strlen ("Total extents scheduled to be written = ");
@@ -173,60 +217,68 @@ brasero_growisofs_read_stderr (BraseroProcess *process, const gchar *line)
 			 * a value of 1 when mkisofs is run with --print-size */
 			brasero_job_finished_session (BRASERO_JOB (process));
 		}
+		break;
 	}
-	else if (strstr (line, "flushing cache") != NULL) {
+
+	case BRASERO_GROWISOFS_LINE_FLUSHING:
 		brasero_job_set_progress (BRASERO_JOB (process), 1.0);
 		brasero_job_set_current_action (BRASERO_JOB (process),
 						BRASERO_BURN_ACTION_FIXATING,
 						NULL,
 						FALSE);
-	}
-	else if (strstr (line, "unable to open")
-	     ||  strstr (line, "unable to stat")
-	     ||  strstr (line, "unable to proceed with recording: unable to unmount")) {
+		break;
+
+	case BRASERO_GROWISOFS_LINE_BUSY:
 		brasero_job_error (BRASERO_JOB (process),
 				   g_error_new_literal (BRASERO_BURN_ERROR,
 							BRASERO_BURN_ERROR_DRIVE_BUSY,
 							_("The drive is busy")));
-	}
-	else if (strstr (line, "not enough space available")
-	     ||  strstr (line, "end of user area encountered on this track")
-	     ||  strstr (line, "blocks are free")) {
+		break;
+
+	case BRASERO_GROWISOFS_LINE_NO_SPACE:
 		brasero_job_error (BRASERO_JOB (process), 
 				   g_error_new (BRASERO_BURN_ERROR,
 						BRASERO_BURN_ERROR_MEDIUM_SPACE,
 						_("Not enough space available on the disc")));
-	}
-	else if (strstr (line, "Input/output error. Read error on old image")) {
+		break;
+
+	case BRASERO_GROWISOFS_LINE_LAST_SESSION:
 		brasero_job_error (BRASERO_JOB (process), 
 				   g_error_new_literal (BRASERO_BURN_ERROR,
 							BRASERO_BURN_ERROR_IMAGE_LAST_SESSION,
 							_("Last session import failed")));
-	}
-	else if (strstr (line, "Unable to sort directory")) {
+		break;
+
+	case BRASERO_GROWISOFS_LINE_SORT:
 		brasero_job_error (BRASERO_JOB (process), 
 				   g_error_new_literal (BRASERO_BURN_ERROR,
 							BRASERO_BURN_ERROR_WRITE_IMAGE,
 							_("An image could not be created")));
-	}
-	else if (strstr (line, "have the same joliet name")
-	     ||  strstr (line, "Joliet tree sort failed.")) {
+		break;
+
+	case BRASERO_GROWISOFS_LINE_JOLIET:
 		brasero_job_error (BRASERO_JOB (process), 
 				   g_error_new_literal (BRASERO_BURN_ERROR,
 							BRASERO_BURN_ERROR_IMAGE_JOLIET,
 							_("An image could not be created")));
-	}
-	else if (strstr (line, "Incorrectly encoded string")) {
+		break;
+
+	case BRASERO_GROWISOFS_LINE_ENCODING:
 		brasero_job_error (BRASERO_JOB (process),
 				   g_error_new_literal (BRASERO_BURN_ERROR,
 							BRASERO_BURN_ERROR_INPUT_INVALID,
 							_("Some files have invalid filenames")));
-	}
-	else if (strstr (line, "Unknown charset")) {
+		break;
+
+	case BRASERO_GROWISOFS_LINE_CHARSET:
 		brasero_job_error (BRASERO_JOB (process),
 				   g_error_new_literal (BRASERO_BURN_ERROR,
 							BRASERO_BURN_ERROR_INPUT_INVALID,
 							_("Unknown character encoding")));
+		break;
+
+	default:
+		break;
 	}
 
 	/** REMINDER! removed messages:
@@ -680,6 +732,9 @@ brasero_growisofs_init (BraseroGrowisofs *obj)
 
 	priv = BRASERO_GROWISOFS_PRIVATE (obj);
 
+	priv->stderr_matcher = brasero_line_matcher_new (stderr_patterns,
+							 G_N_ELEMENTS (stderr_patterns));
+
 	/* this code (remotely) comes from ncb_mkisofs_supports_utf8 */
 	/* Added a way to detect whether we'll use mkisofs or genisoimage */
 
@@ -733,6 +788,13 @@ brasero_growisofs_init (BraseroGrowisofs *obj)
 static void
 brasero_growisofs_finalize (GObject *object)
 {
+	BraseroGrowisofsPrivate *priv;
+
+	priv = BRASERO_GROWISOFS_PRIVATE (object);
+
+	brasero_line_matcher_free (priv->stderr_matcher);
+	priv->stderr_matcher = NULL;
+
 	G_OBJECT_CLASS (parent_class)->finalize (object);
 }
 
@@ -38,6 +38,8 @@
 #include <string.h>
 #include <unistd.h>
 #include <errno.h>
+#include <poll.h>
+#include <sys/mman.h>
 
 #include <glib.h>
 #include <glib-object.h>
@@ -67,9 +69,30 @@ BRASERO_PLUGIN_BOILERPLATE (BraseroLibburn, brasero_libburn, BRASERO_TYPE_JOB, B
 
 #define BRASERO_PVD_SIZE	32ULL * 2048ULL
 
+#define BRASERO_SCHEMA_CONFIG			"org.gnome.brasero.config"
+#define BRASERO_KEY_FIFO_SIZE			"libburn-fifo-size"
+
+#define BRASERO_LIBBURN_FIFO_CHUNK		65536
+#define BRASERO_LIBBURN_FIFO_ALIGN		(2 * 1024 * 1024)
+#define BRASERO_LIBBURN_FIFO_POLL_TIMEOUT	100		/* ms */
+
+/* Shared between the job and the FIFO (which is owned by libburn) */
+struct _BraseroLibburnFifoInfo {
+	gsize size;
+
+	gint fill;
+	gint min_fill;
+	gint underruns;
+};
+typedef struct _BraseroLibburnFifoInfo BraseroLibburnFifoInfo;
+
 struct _BraseroLibburnPrivate {
 	BraseroLibburnCtx *ctx;
 
+	BraseroLibburnFifoInfo fifo;
+	gint fifo_min_logged;
+	gint fifo_underruns_logged;
+
 	/* This buffer is used to capture Primary Volume Descriptor for
 	 * for overwrite media so as to "grow" the latter. */
 	unsigned char *pvd;
@@ -100,15 +123,254 @@ struct _BraseroLibburnSrcData {
 	unsigned char *pvd;
 
 	int read_pvd:1;
+
+	/* FIFO filled by a separate thread when fifo is not NULL */
+	guchar *fifo;
+	gsize fifo_size;
+	gsize fifo_head;
+	gsize fifo_tail;
+	gsize fifo_fill;
+	gint fifo_errno;
+	gboolean fifo_eof;
+	gboolean fifo_mapped;
+	gboolean quit;
+
+	BraseroLibburnFifoInfo *info;
+
+	GThread *thread;
+	GMutex *mutex;
+	GCond *cond;
 };
 typedef struct _BraseroLibburnSrcData BraseroLibburnSrcData;
 
+/**
+ * Ring buffer placed in front of a pipe. A thread keeps filling it from
+ * the job upstream so that a short stall there doesn't starve the drive.
+ */
+
+static guchar *
+brasero_libburn_fifo_alloc (gsize size,
+			    gboolean *mapped)
+{
+#ifdef MAP_ANONYMOUS
+	void *buffer;
+
+	buffer = mmap (NULL,
+		       size,
+		       PROT_READ|PROT_WRITE,
+		       MAP_PRIVATE|MAP_ANONYMOUS,
+		       -1,
+		       0);
+	if (buffer != MAP_FAILED) {
+#ifdef MADV_HUGEPAGE
+		/* It's large and goes through the whole of it repeatedly so
+		 * huge pages save a lot of TLB misses */
+		madvise (buffer, size, MADV_HUGEPAGE);
+#endif
+		*mapped = TRUE;
+		return buffer;
+	}
+#endif
+
+	*mapped = FALSE;
+	return g_try_malloc (size);
+}
+
+static gpointer
+brasero_libburn_src_fifo_thread (gpointer user_data)
+{
+	BraseroLibburnSrcData *data = user_data;
+
+	g_mutex_lock (data->mutex);
+	while (!data->quit) {
+		struct pollfd fds;
+		gssize bytes;
+		gsize offset;
+		gsize room;
+		int res;
+
+		if (data->fifo_fill == data->fifo_size) {
+			g_cond_wait (data->cond, data->mutex);
+			continue;
+		}
+
+		/* Only this thread writes to [head, head + room) */
+		offset = data->fifo_head;
+		room = MIN (data->fifo_size - data->fifo_fill, data->fifo_size - offset);
+		room = MIN (room, BRASERO_LIBBURN_FIFO_CHUNK);
+		g_mutex_unlock (data->mutex);
+
+		/* Don't block forever in read () so we can be stopped */
+		fds.fd = data->fd;
+		fds.events = POLLIN;
+		fds.revents = 0;
+		res = poll (&fds, 1, BRASERO_LIBBURN_FIFO_POLL_TIMEOUT);
+
+		bytes = 0;
+		if (res > 0)
+			bytes = read (data->fd, data->fifo + offset, room);
+
+		g_mutex_lock (data->mutex);
+
+		if (res == 0 || (res < 0 && errno == EINTR))
+			continue;
+
+		if (res < 0 || bytes < 0) {
+			if (res > 0 && (errno == EINTR || errno == EAGAIN))
+				continue;
+
+			data->fifo_errno = errno;
+			data->fifo_eof = TRUE;
+			g_cond_broadcast (data->cond);
+			break;
+		}
+
+		if (!bytes) {
+			data->fifo_eof = TRUE;
+			g_cond_broadcast (data->cond);
+			break;
+		}
+
+		data->fifo_head = (data->fifo_head + bytes) % data->fifo_size;
+		data->fifo_fill += bytes;
+		g_atomic_int_set (&data->info->fill, data->fifo_fill);
+		g_cond_broadcast (data->cond);
+	}
+	g_mutex_unlock (data->mutex);
+
+	return NULL;
+}
+
+static int
+brasero_libburn_src_fifo_read (BraseroLibburnSrcData *data,
+			       unsigned char *buffer,
+			       int size)
+{
+	gboolean waited = FALSE;
+	int total = 0;
+
+	g_mutex_lock (data->mutex);
+	while (total < size) {
+		gsize chunk;
+		gsize offset;
+
+		if (!data->fifo_fill) {
+			if (data->fifo_eof)
+				break;
+
+			/* The drive is waiting for upstream */
+			if (!waited) {
+				g_atomic_int_inc (&data->info->underruns);
+				waited = TRUE;
+			}
+
+			g_cond_wait (data->cond, data->mutex);
+			continue;
+		}
+
+		offset = data->fifo_tail;
+		chunk = MIN (data->fifo_fill, (gsize) (size - total));
+		chunk = MIN (chunk, data->fifo_size - offset);
+
+		/* The thread never writes to the part which is filled */
+		g_mutex_unlock (data->mutex);
+		memcpy (buffer + total, data->fifo + offset, chunk);
+		g_mutex_lock (data->mutex);
+
+		data->fifo_tail = (data->fifo_tail + chunk) % data->fifo_size;
+		data->fifo_fill -= chunk;
+		total += chunk;
+		g_cond_broadcast (data->cond);
+	}
+
+	g_atomic_int_set (&data->info->fill, data->fifo_fill);
+	if (data->fifo_fill < (gsize) g_atomic_int_get (&data->info->min_fill))
+		g_atomic_int_set (&data->info->min_fill, data->fifo_fill);
+
+	if (!total && data->fifo_errno) {
+		g_mutex_unlock (data->mutex);
+		return -1;
+	}
+
+	g_mutex_unlock (data->mutex);
+	return total;
+}
+
+static void
+brasero_libburn_src_fifo_stop (BraseroLibburnSrcData *data)
+{
+	if (data->thread) {
+		g_mutex_lock (data->mutex);
+		data->quit = TRUE;
+		g_cond_broadcast (data->cond);
+		g_mutex_unlock (data->mutex);
+
+		g_thread_join (data->thread);
+		data->thread = NULL;
+	}
+
+	if (data->mutex) {
+		g_mutex_free (data->mutex);
+		data->mutex = NULL;
+	}
+
+	if (data->cond) {
+		g_cond_free (data->cond);
+		data->cond = NULL;
+	}
+
+	if (data->fifo) {
+#ifdef MAP_ANONYMOUS
+		if (data->fifo_mapped)
+			munmap (data->fifo, data->fifo_size);
+		else
+#endif
+			g_free (data->fifo);
+
+		data->fifo = NULL;
+	}
+}
+
+static void
+brasero_libburn_src_fifo_start (BraseroLibburnSrcData *data,
+				BraseroLibburnFifoInfo *info)
+{
+	/* Round it to a multiple of huge pages (2 MiB) */
+	data->fifo_size = (info->size + BRASERO_LIBBURN_FIFO_ALIGN - 1) &
+			  ~((gsize) BRASERO_LIBBURN_FIFO_ALIGN - 1);
+	data->fifo = brasero_libburn_fifo_alloc (data->fifo_size, &data->fifo_mapped);
+	if (!data->fifo) {
+		BRASERO_BURN_LOG ("FIFO could not be allocated");
+		return;
+	}
+
+	data->info = info;
+	g_atomic_int_set (&info->fill, 0);
+	g_atomic_int_set (&info->min_fill, data->fifo_size);
+	g_atomic_int_set (&info->underruns, 0);
+
+	data->mutex = g_mutex_new ();
+	data->cond = g_cond_new ();
+	data->thread = g_thread_create (brasero_libburn_src_fifo_thread,
+					data,
+					TRUE,
+					NULL);
+	if (!data->thread) {
+		BRASERO_BURN_LOG ("FIFO thread could not be created");
+		brasero_libburn_src_fifo_stop (data);
+		return;
+	}
+
+	BRASERO_BURN_LOG ("Using a %"G_GSIZE_FORMAT" bytes FIFO", data->fifo_size);
+}
+
 static void
 brasero_libburn_src_free_data (struct burn_source *src)
 {
 	BraseroLibburnSrcData *data;
 
 	data = src->data;
+	brasero_libburn_src_fifo_stop (data);
 	close (data->fd);
 	g_free (data);
 }
@@ -154,8 +416,12 @@ brasero_libburn_src_read_xt (struct burn_source *src,
 
 	data = src->data;
 
-	total = 0;
-	while (total < size) {
+	if (data->fifo) {
+		total = brasero_libburn_src_fifo_read (data, buffer, size);
+		if (total < 0)
+			return -1;
+	}
+	else for (total = 0; total < size; ) {
 		int bytes;
 
 		bytes = read (data->fd, buffer + total, size - total);
@@ -204,7 +470,8 @@ brasero_libburn_src_read_xt (struct burn_source *src,
 static struct burn_source *
 brasero_libburn_create_fd_source (int fd,
 				  gint64 size,
-				  unsigned char *pvd)
+				  unsigned char *pvd,
+				  BraseroLibburnFifoInfo *fifo)
 {
 	struct burn_source *src;
 	BraseroLibburnSrcData *data;
@@ -214,8 +481,11 @@ brasero_libburn_create_fd_source (int fd,
 	data->size = size;
 	data->pvd = pvd;
 
-	/* FIXME: this could be wrapped into a fifo source to get a smoother
-	 * data delivery. But that means another thread ... */
+	/* NOTE: libburn's own fifo source isn't used since we want to
+	 * control its size and its memory */
+	if (fifo && fifo->size)
+		brasero_libburn_src_fifo_start (data, fifo);
+
 	src = g_new0 (struct burn_source, 1);
 	src->version = 1;
 	src->refcount = 1;
@@ -260,6 +530,7 @@ brasero_libburn_add_fd_track (struct burn_session *session,
 			      gint mode,
 			      gint64 size,
 			      unsigned char *pvd,
+			      BraseroLibburnFifoInfo *fifo,
 			      GError **error)
 {
 	struct burn_source *src;
@@ -269,7 +540,7 @@ brasero_libburn_add_fd_track (struct burn_session *session,
 	track = burn_track_create ();
 	burn_track_define_data (track, 0, 0, 0, mode);
 
-	src = brasero_libburn_create_fd_source (fd, size, pvd);
+	src = brasero_libburn_create_fd_source (fd, size, pvd, fifo);
 	result = brasero_libburn_add_track (session, track, src, mode, error);
 
 	burn_source_free (src);
@@ -298,7 +569,26 @@ brasero_libburn_add_file_track (struct burn_session *session,
 		return BRASERO_BURN_ERR;
 	}
 
-	return brasero_libburn_add_fd_track (session, fd, mode, size, pvd, error);
+	return brasero_libburn_add_fd_track (session, fd, mode, size, pvd, NULL, error);
+}
+
+static void
+brasero_libburn_get_fifo_size (BraseroLibburn *self)
+{
+	BraseroLibburnPrivate *priv;
+	GSettings *settings;
+	gint size;
+
+	priv = BRASERO_LIBBURN_PRIVATE (self);
+
+	settings = g_settings_new (BRASERO_SCHEMA_CONFIG);
+	size = g_settings_get_int (settings, BRASERO_KEY_FIFO_SIZE);
+	g_object_unref (settings);
+
+	/* In MiB; 0 means no FIFO */
+	priv->fifo.size = CLAMP (size, 0, 1024) * 1024 * 1024;
+	priv->fifo_min_logged = -1;
+	priv->fifo_underruns_logged = 0;
 }
 
 static BraseroBurnResult
@@ -335,11 +625,14 @@ brasero_libburn_setup_session_fd (BraseroLibburn *self,
 						     NULL,
 						     &bytes);
 
+		/* Only one track is read from the pipe; see below */
+		brasero_libburn_get_fifo_size (self);
 		result = brasero_libburn_add_fd_track (session,
 						       fd,
 						       mode,
 						       bytes,
 						       priv->pvd,
+						       &priv->fifo,
 						       error);
 	}
 	else if (brasero_track_type_get_has_stream (type)) {
@@ -357,12 +650,15 @@ brasero_libburn_setup_session_fd (BraseroLibburn *self,
 			bytes = BRASERO_DURATION_TO_BYTES (length);
 
 			/* we dup the descriptor so the same 
-			 * will be shared by all tracks */
+			 * will be shared by all tracks. That's also why
+			 * there is no FIFO: it would read ahead the data
+			 * of the next tracks. */
 			result = brasero_libburn_add_fd_track (session,
 							       dup (fd),
 							       BURN_AUDIO,
 							       bytes,
 							       NULL,
+							       NULL,
 							       error);
 			if (result != BRASERO_BURN_OK)
 				return result;
@@ -694,6 +990,7 @@ brasero_libburn_start_erase (BraseroLibburn *self,
 					       BURN_MODE1,
 					       65536,		/* 32 blocks */
 					       priv->pvd,
+					       NULL,
 					       error);
 	close (fd);
 
@@ -834,6 +1131,33 @@ brasero_libburn_stop (BraseroJob *job,
 	return BRASERO_BURN_OK;
 }
 
+static void
+brasero_libburn_log_fifo (BraseroJob *job)
+{
+	BraseroLibburnPrivate *priv;
+	gint underruns;
+	gint min_fill;
+
+	priv = BRASERO_LIBBURN_PRIVATE (job);
+	if (!priv->fifo.size)
+		return;
+
+	/* Only log when it got worse to avoid flooding the logs */
+	min_fill = g_atomic_int_get (&priv->fifo.min_fill);
+	underruns = g_atomic_int_get (&priv->fifo.underruns);
+	if (min_fill == priv->fifo_min_logged
+	&&  underruns == priv->fifo_underruns_logged)
+		return;
+
+	priv->fifo_min_logged = min_fill;
+	priv->fifo_underruns_logged = underruns;
+	BRASERO_JOB_LOG (job,
+			 "FIFO filled at %i bytes (min %i) and %i underruns",
+			 g_atomic_int_get (&priv->fifo.fill),
+			 min_fill,
+			 underruns);
+}
+
 static BraseroBurnResult
 brasero_libburn_clock_tick (BraseroJob *job)
 {
@@ -842,6 +1166,7 @@ brasero_libburn_clock_tick (BraseroJob *job)
 	int ret;
 
 	priv = BRASERO_LIBBURN_PRIVATE (job);
+	brasero_libburn_log_fifo (job);
 	result = brasero_libburn_common_status (job, priv->ctx);
 
 	if (result != BRASERO_BURN_OK)
@@ -966,6 +1291,7 @@ brasero_libburn_export_caps (BraseroPlugin *plugin)
 					       BRASERO_MEDIUM_APPENDABLE|
 					       BRASERO_MEDIUM_CLOSED|
 					       BRASERO_MEDIUM_HAS_DATA;
+	BraseroPluginConfOption *fifo;
 	GSList *output;
 	GSList *input;
 
@@ -1087,5 +1413,11 @@ brasero_libburn_export_caps (BraseroPlugin *plugin)
 					BRASERO_BURN_FLAG_FAST_BLANK,
 					BRASERO_BURN_FLAG_NONE);
 
+	fifo = brasero_plugin_conf_option_new (BRASERO_KEY_FIFO_SIZE,
+					       _("Size of the buffer for images (in MiB, 0 to disable):"),
+					       BRASERO_PLUGIN_OPTION_INT);
+	brasero_plugin_conf_option_int_set_range (fifo, 0, 1024);
+	brasero_plugin_add_conf_option (plugin, fifo);
+
 	brasero_plugin_register_group (plugin, _(LIBBURNIA_DESCRIPTION));
 }
@@ -37,6 +37,7 @@
 #include <errno.h>
 #include <stdlib.h>
 #include <unistd.h>
+#include <poll.h>
 
 #include <glib.h>
 #include <glib-object.h>
@@ -63,6 +64,10 @@
 #define BRASERO_IS_LIBISOFS_CLASS(k)  (G_TYPE_CHECK_CLASS_TYPE ((k), BRASERO_TYPE_LIBISOFS))
 #define BRASERO_LIBISOFS_GET_CLASS(o) (G_TYPE_INSTANCE_GET_CLASS ((o), BRASERO_TYPE_LIBISOFS, BraseroLibisofsClass))
 
+/* Sectors are read from libisofs and written by batches of that size */
+#define BRASERO_LIBISOFS_BATCH_SIZE		(2 * 1024 * 1024)
+#define BRASERO_LIBISOFS_POLL_TIMEOUT		100	/* ms */
+
 BRASERO_PLUGIN_BOILERPLATE (BraseroLibisofs, brasero_libisofs, BRASERO_TYPE_JOB, BraseroJob);
 
 struct _BraseroLibisofsPrivate {
@@ -130,10 +135,10 @@ brasero_libisofs_thread_finished (gpointer data)
 }
 
 static BraseroBurnResult
-brasero_libisofs_write_sector_to_fd (BraseroLibisofs *self,
-				     int fd,
-				     gpointer buffer,
-				     gint bytes_remaining)
+brasero_libisofs_write_to_fd (BraseroLibisofs *self,
+			      int fd,
+			      gpointer buffer,
+			      gint bytes_remaining)
 {
 	gint bytes_written = 0;
 	BraseroLibisofsPrivate *priv;
@@ -141,6 +146,7 @@ brasero_libisofs_write_sector_to_fd (BraseroLibisofs *self,
 	priv = BRASERO_LIBISOFS_PRIVATE (self);
 
 	while (bytes_remaining) {
+		struct pollfd fds;
 		gint written;
 
 		written = write (fd,
@@ -150,43 +156,103 @@ brasero_libisofs_write_sector_to_fd (BraseroLibisofs *self,
 		if (priv->cancel)
 			break;
 
-		if (written != bytes_remaining) {
-			if (errno != EINTR && errno != EAGAIN) {
-                                int errsv = errno;
-
-				/* unrecoverable error */
-				priv->error = g_error_new (BRASERO_BURN_ERROR,
-							   BRASERO_BURN_ERROR_GENERAL,
-							   _("Data could not be written (%s)"),
-							   g_strerror (errsv));
-				return BRASERO_BURN_ERR;
-			}
-
-			g_thread_yield ();
-		}
-
 		if (written > 0) {
 			bytes_remaining -= written;
 			bytes_written += written;
+			continue;
+		}
+
+		if (written < 0 && errno != EINTR && errno != EAGAIN) {
+			int errsv = errno;
+
+			/* unrecoverable error */
+			priv->error = g_error_new (BRASERO_BURN_ERROR,
+						   BRASERO_BURN_ERROR_GENERAL,
+						   _("Data could not be written (%s)"),
+						   g_strerror (errsv));
+			return BRASERO_BURN_ERR;
 		}
+
+		/* The pipe is full: wait for the reader with a timeout so
+		 * that we notice when we are cancelled */
+		fds.fd = fd;
+		fds.events = POLLOUT;
+		fds.revents = 0;
+		poll (&fds, 1, BRASERO_LIBISOFS_POLL_TIMEOUT);
 	}
 
 	return BRASERO_BURN_OK;
 }
 
+/**
+ * Fills buffer with as many sectors as possible. Returns the number of
+ * bytes read which is less than size only at the end of the image or -1.
+ */
+
+static gint
+brasero_libisofs_read_batch (BraseroLibisofs *self,
+			     guchar *buffer,
+			     gint size)
+{
+	BraseroLibisofsPrivate *priv;
+	gint total = 0;
+
+	priv = BRASERO_LIBISOFS_PRIVATE (self);
+
+	while (total < size) {
+		int read_bytes;
+
+		if (priv->cancel)
+			break;
+
+		read_bytes = priv->libburn_src->read_xt (priv->libburn_src,
+							 buffer + total,
+							 size - total);
+		if (read_bytes < 0)
+			return -1;
+
+		if (!read_bytes)
+			break;
+
+		total += read_bytes;
+	}
+
+	return total;
+}
+
+static guchar *
+brasero_libisofs_batch_new (BraseroLibisofs *self)
+{
+	BraseroLibisofsPrivate *priv;
+	guchar *buffer;
+
+	priv = BRASERO_LIBISOFS_PRIVATE (self);
+
+	buffer = g_try_malloc (BRASERO_LIBISOFS_BATCH_SIZE);
+	if (!buffer)
+		priv->error = g_error_new (BRASERO_BURN_ERROR,
+					   BRASERO_BURN_ERROR_GENERAL,
+					   _("Data could not be written (%s)"),
+					   g_strerror (ENOMEM));
+	return buffer;
+}
+
 static void
 brasero_libisofs_write_image_to_fd_thread (BraseroLibisofs *self)
 {
-	const gint sector_size = 2048;
 	BraseroLibisofsPrivate *priv;
-	gint64 written_sectors = 0;
+	gint64 written_bytes = 0;
 	BraseroBurnResult result;
-	guchar buf [sector_size];
+	guchar *buf;
 	int read_bytes;
 	int fd = -1;
 
 	priv = BRASERO_LIBISOFS_PRIVATE (self);
 
+	buf = brasero_libisofs_batch_new (self);
+	if (!buf)
+		return;
+
 	brasero_job_set_nonblocking (BRASERO_JOB (self), NULL);
 
 	brasero_job_set_current_action (BRASERO_JOB (self),
@@ -198,24 +264,29 @@ brasero_libisofs_write_image_to_fd_thread (BraseroLibisofs *self)
 	brasero_job_get_fd_out (BRASERO_JOB (self), &fd);
 
 	BRASERO_JOB_LOG (self, "Writing to pipe");
-	read_bytes = priv->libburn_src->read_xt (priv->libburn_src, buf, sector_size);
-	while (read_bytes == sector_size) {
+	read_bytes = brasero_libisofs_read_batch (self, buf, BRASERO_LIBISOFS_BATCH_SIZE);
+	while (read_bytes > 0) {
 		if (priv->cancel)
 			break;
 
-		result = brasero_libisofs_write_sector_to_fd (self,
-							      fd,
-							      buf,
-							      sector_size);
+		result = brasero_libisofs_write_to_fd (self,
+						       fd,
+						       buf,
+						       read_bytes);
 		if (result != BRASERO_BURN_OK)
 			break;
 
-		written_sectors ++;
-		brasero_job_set_written_track (BRASERO_JOB (self), written_sectors << 11);
+		written_bytes += read_bytes;
+		brasero_job_set_written_track (BRASERO_JOB (self), written_bytes);
 
-		read_bytes = priv->libburn_src->read_xt (priv->libburn_src, buf, sector_size);
+		if (read_bytes < BRASERO_LIBISOFS_BATCH_SIZE)
+			break;
+
+		read_bytes = brasero_libisofs_read_batch (self, buf, BRASERO_LIBISOFS_BATCH_SIZE);
 	}
 
+	g_free (buf);
+
 	if (read_bytes == -1 && !priv->error)
 		priv->error = g_error_new (BRASERO_BURN_ERROR,
 					   BRASERO_BURN_ERROR_GENERAL,
@@ -225,10 +296,9 @@ brasero_libisofs_write_image_to_fd_thread (BraseroLibisofs *self)
 static void
 brasero_libisofs_write_image_to_file_thread (BraseroLibisofs *self)
 {
-	const gint sector_size = 2048;
 	BraseroLibisofsPrivate *priv;
-	gint64 written_sectors = 0;
-	guchar buf [sector_size];
+	gint64 written_bytes = 0;
+	guchar *buf;
 	int read_bytes;
 	gchar *output;
 	FILE *file;
@@ -251,6 +321,15 @@ brasero_libisofs_write_image_to_file_thread (BraseroLibisofs *self)
 		return;
 	}
 
+	buf = brasero_libisofs_batch_new (self);
+	if (!buf) {
+		fclose (file);
+		return;
+	}
+
+	/* Batches are bigger than the stdio buffer anyway */
+	setvbuf (file, NULL, _IONBF, 0);
+
 	BRASERO_JOB_LOG (self, "writing to file %s", output);
 
 	brasero_job_set_current_action (BRASERO_JOB (self),
@@ -261,12 +340,12 @@ brasero_libisofs_write_image_to_file_thread (BraseroLibisofs *self)
 	priv = BRASERO_LIBISOFS_PRIVATE (self);
 	brasero_job_start_progress (BRASERO_JOB (self), FALSE);
 
-	read_bytes = priv->libburn_src->read_xt (priv->libburn_src, buf, sector_size);
-	while (read_bytes == sector_size) {
+	read_bytes = brasero_libisofs_read_batch (self, buf, BRASERO_LIBISOFS_BATCH_SIZE);
+	while (read_bytes > 0) {
 		if (priv->cancel)
 			break;
 
-		if (fwrite (buf, 1, sector_size, file) != sector_size) {
+		if (fwrite (buf, 1, read_bytes, file) != read_bytes) {
                         int errsv = errno;
 
 			priv->error = g_error_new (BRASERO_BURN_ERROR,
@@ -279,12 +358,17 @@ brasero_libisofs_write_image_to_file_thread (BraseroLibisofs *self)
 		if (priv->cancel)
 			break;
 
-		written_sectors ++;
-		brasero_job_set_written_track (BRASERO_JOB (self), written_sectors << 11);
+		written_bytes += read_bytes;
+		brasero_job_set_written_track (BRASERO_JOB (self), written_bytes);
 
-		read_bytes = priv->libburn_src->read_xt (priv->libburn_src, buf, sector_size);
+		if (read_bytes < BRASERO_LIBISOFS_BATCH_SIZE)
+			break;
+
+		read_bytes = brasero_libisofs_read_batch (self, buf, BRASERO_LIBISOFS_BATCH_SIZE);
 	}
 
+	g_free (buf);
+
 	if (read_bytes == -1 && !priv->error)
 		priv->error = g_error_new (BRASERO_BURN_ERROR,
 					   BRASERO_BURN_ERROR_GENERAL,
@@ -31,6 +31,7 @@
 
 #include "brasero-misc.h"
 #include "brasero-metadata.h"
+#include "brasero-metadata-cache.h"
 
 #include "brasero-units.h"
 
@@ -611,40 +612,43 @@ brasero_split_dialog_no_silence_message (BraseroSplitDialog *self)
 				      GTK_MESSAGE_WARNING);
 }
 
+static GFileInfo *
+brasero_split_dialog_query_file_info (const gchar *uri)
+{
+	GFileInfo *info;
+	GFile *file;
+
+	/* Needed to check whether a cached result is still valid */
+	file = g_file_new_for_uri (uri);
+	info = g_file_query_info (file,
+				  G_FILE_ATTRIBUTE_STANDARD_SIZE ","
+				  G_FILE_ATTRIBUTE_TIME_MODIFIED,
+				  G_FILE_QUERY_INFO_NONE,
+				  NULL,
+				  NULL);
+	g_object_unref (file);
+
+	return info;
+}
+
 static void
-brasero_split_dialog_metadata_finished_cb (BraseroMetadata *metadata,
-					   GError *error,
-					   BraseroSplitDialog *self)
+brasero_split_dialog_add_silences (BraseroSplitDialog *self,
+				   BraseroMetadataInfo *info)
 {
-	BraseroMetadataInfo info = { NULL, };
 	BraseroSplitDialogPrivate *priv;
 	gboolean added_silence;
 	GSList *iter;
 
 	priv = BRASERO_SPLIT_DIALOG_PRIVATE (self);
 
-	gtk_widget_set_sensitive (priv->cut, TRUE);
-
-	g_object_unref (priv->metadata);
-	priv->metadata = NULL;
-
-	if (error) {
-		brasero_utils_message_dialog (GTK_WIDGET (self),
-					      _("An error occurred while detecting silences."),
-					      error->message,
-					      GTK_MESSAGE_ERROR);
-		return;
-	}
-
-	brasero_metadata_get_result (metadata, &info, NULL);
-	if (!info.silences) {
+	if (!info->silences) {
 		brasero_split_dialog_no_silence_message (self);
 		return;
 	}
 
 	/* remove silences */
 	added_silence = FALSE;
-	for (iter = info.silences; iter; iter = iter->next) {
+	for (iter = info->silences; iter; iter = iter->next) {
 		BraseroMetadataSilence *silence;
 
 		silence = iter->data;
@@ -679,7 +683,47 @@ brasero_split_dialog_metadata_finished_cb (BraseroMetadata *metadata,
 
 	if (!added_silence)
 		brasero_split_dialog_no_silence_message (self);
+}
 
+static void
+brasero_split_dialog_metadata_finished_cb (BraseroMetadata *metadata,
+					   GError *error,
+					   BraseroSplitDialog *self)
+{
+	BraseroMetadataInfo info = { NULL, };
+	BraseroSplitDialogPrivate *priv;
+	GFileInfo *file_info;
+	const gchar *uri;
+
+	priv = BRASERO_SPLIT_DIALOG_PRIVATE (self);
+
+	gtk_widget_set_sensitive (priv->cut, TRUE);
+
+	g_object_unref (priv->metadata);
+	priv->metadata = NULL;
+
+	if (error) {
+		brasero_utils_message_dialog (GTK_WIDGET (self),
+					      _("An error occurred while detecting silences."),
+					      error->message,
+					      GTK_MESSAGE_ERROR);
+		return;
+	}
+
+	brasero_metadata_get_result (metadata, &info, NULL);
+
+	/* Keep the result so the (slow) detection isn't run again */
+	uri = brasero_song_control_get_uri (BRASERO_SONG_CONTROL (priv->player));
+	file_info = brasero_split_dialog_query_file_info (uri);
+	if (file_info) {
+		brasero_metadata_cache_add (uri,
+					    file_info,
+					    BRASERO_METADATA_FLAG_SILENCES,
+					    &info);
+		g_object_unref (file_info);
+	}
+
+	brasero_split_dialog_add_silences (self, &info);
 	brasero_metadata_info_clear (&info);
 }
 
@@ -732,6 +776,8 @@ brasero_split_dialog_cut_clicked_cb (GtkButton *button,
 				     BraseroSplitDialog *self)
 {
 	BraseroSplitDialogPrivate *priv;
+	GFileInfo *file_info;
+	const gchar *uri;
 	guint page;
 
 	priv = BRASERO_SPLIT_DIALOG_PRIVATE (self);
@@ -799,13 +845,33 @@ brasero_split_dialog_cut_clicked_cb (GtkButton *button,
 
 	gtk_list_store_clear (priv->model);
 
+	/* See if silences were already detected for this file */
+	uri = brasero_song_control_get_uri (BRASERO_SONG_CONTROL (priv->player));
+	file_info = brasero_split_dialog_query_file_info (uri);
+	if (file_info) {
+		BraseroMetadataInfo info = { NULL, };
+		gboolean found;
+
+		found = brasero_metadata_cache_lookup (uri,
+						       file_info,
+						       BRASERO_METADATA_FLAG_SILENCES,
+						       &info);
+		g_object_unref (file_info);
+
+		if (found) {
+			brasero_split_dialog_add_silences (self, &info);
+			brasero_metadata_info_clear (&info);
+			return;
+		}
+	}
+
 	priv->metadata = brasero_metadata_new ();
 	g_signal_connect (priv->metadata,
 			  "completed",
 			  G_CALLBACK (brasero_split_dialog_metadata_finished_cb),
 			  self);
 	brasero_metadata_get_info_async (priv->metadata,
-					 brasero_song_control_get_uri (BRASERO_SONG_CONTROL (priv->player)),
+					 uri,
 					 BRASERO_METADATA_FLAG_SILENCES);
 
 	/* stop anything from playing and grey out things */